@@ -30,6 +30,9 @@
 #endif
 #include "app/scanner.h"
 #include "audio.h"
+#ifdef ENABLE_CHANNEL_ZONES
+    #include "chstore.h"
+#endif
 #ifdef ENABLE_FMRADIO
     #include "driver/bk1080.h"
 #endif
@@ -125,6 +128,9 @@ void (*action_opt_table[])(void) = {
     [ACTION_OPT_REGA_ALARM] = &ACTION_RegaAlarm,
     [ACTION_OPT_REGA_TEST] = &ACTION_RegaTest,
 #endif
+#ifdef ENABLE_CHANNEL_ZONES
+    [ACTION_OPT_ZONE] = &ACTION_Zone,
+#endif
 };
 
 static_assert(ARRAY_SIZE(action_opt_table) == ACTION_OPT_LEN);
@@ -280,6 +286,17 @@ void ACTION_SwitchDemodul(void)
         gTxVfo->Modulation = MODULATION_FM;
 }
 
+#ifdef ENABLE_CHANNEL_ZONES
+void ACTION_Zone(void)
+{
+    CHSTORE_SetZone((gEeprom.CHANNEL_ZONE + 1) % CHSTORE_ZONES);
+
+    // both VFOs may sit on memory channels of the old zone
+    gFlagResetVfos    = true;
+    gVfoConfigureMode = VFO_CONFIGURE_RELOAD;
+    gRequestSaveVFO   = true;
+}
+#endif
 
 void ACTION_Handle(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld)
 {
@@ -52,14 +52,22 @@
     #include "driver/bk1080.h"
 #endif
 #include "driver/bk4819.h"
+#include "driver/bk4819_profile.h"
+#ifdef ENABLE_BK4819_IRQ
+    #include "driver/bk4819_irq.h"
+#endif
 #include "driver/gpio.h"
 #include "driver/keyboard.h"
+#include "driver/py25q16_journal.h"
 #include "driver/st7565.h"
 #include "driver/system.h"
 #include "dtmf.h"
 #include "external/printf/printf.h"
 #include "frequencies.h"
 #include "functions.h"
+#ifdef ENABLE_HEARD_LOG
+    #include "heardlog.h"
+#endif
 #include "helper/battery.h"
 #include "misc.h"
 #include "radio.h"
@@ -569,6 +577,11 @@ void APP_StartListening(FUNCTION_Type_t function)
 
     FUNCTION_Select(function);
 
+#ifdef ENABLE_HEARD_LOG
+    if (function == FUNCTION_RECEIVE)
+        HEARDLOG_Open();
+#endif
+
 #ifdef ENABLE_FMRADIO
     if (function == FUNCTION_MONITOR || gFmRadioMode)
 #else
@@ -642,7 +655,7 @@ static void DualwatchAlternate(void)
         }
     }
 
-    RADIO_SetupRegisters(false);
+    RADIO_QuickRetune(false);
 
     #ifdef ENABLE_NOAA
         gDualWatchCountdown_10ms = gIsNoaaMode ? dual_watch_count_noaa_10ms : dual_watch_count_toggle_10ms;
@@ -802,6 +815,33 @@ static void CheckRadioInterrupts(void)
     }
 }
 
+#ifdef ENABLE_BK4819_IRQ
+// Set by an IRQ line edge, cleared once REG_0C has been drained. Starts set:
+// the line may already be asserted when the EXTI gets enabled.
+static bool gRadioIrqPending = true;
+
+static void ServiceRadioInterrupts(void)
+{
+    uint32_t Time;
+
+    while (BK4819_IRQ_Pop(&Time))
+        gRadioIrqPending = true;
+
+    // Same gating as the polled build; a skipped edge stays pending since the
+    // line gives no new edge until the chip is serviced
+    if (!gRadioIrqPending || gReducedService || SCANNER_IsScanning())
+        return;
+
+    if (gCurrentFunction == FUNCTION_POWER_SAVE && gRxIdleMode)
+        return;
+
+    gRadioIrqPending = false;
+    BK4819_PROFILE_BEGIN(BK4819_CALLER_IRQ);
+    CheckRadioInterrupts();
+    BK4819_PROFILE_END();
+}
+#endif
+
 void APP_EndTransmission(void)
 {
     // back to RX mode
@@ -891,6 +931,10 @@ static void HandleVox(void)
 
 void APP_Update(void)
 {
+#ifdef ENABLE_BK4819_IRQ
+    ServiceRadioInterrupts();
+#endif
+
 #ifdef ENABLE_VOICE
     if (gFlagPlayQueuedVoice) {
             AUDIO_PlayQueuedVoice();
@@ -1371,7 +1415,9 @@ void APP_TimeSlice10ms(void)
 
 #ifdef ENABLE_AM_FIX__
     if (gRxVfo->Modulation == MODULATION_AM) {
+        BK4819_PROFILE_BEGIN(BK4819_CALLER_AM_FIX);
         AM_fix_10ms(gEeprom.RX_VFO);
+        BK4819_PROFILE_END();
     }
 #endif
 
@@ -1383,11 +1429,24 @@ void APP_TimeSlice10ms(void)
     }
 #endif
 
+    // commit deferred settings writes, one page program per tick
+    JOURNAL_FlushStep();
+
+#ifdef ENABLE_HEARD_LOG
+    HEARDLOG_TimeSlice10ms();
+#endif
+
     if (gReducedService)
         return;
 
+#ifndef ENABLE_BK4819_IRQ
     if (gCurrentFunction != FUNCTION_POWER_SAVE || !gRxIdleMode)
+    {
+        BK4819_PROFILE_BEGIN(BK4819_CALLER_IRQ);
         CheckRadioInterrupts();
+        BK4819_PROFILE_END();
+    }
+#endif
 
     if (gCurrentFunction == FUNCTION_TRANSMIT)
     {   // transmitting
@@ -1516,7 +1575,9 @@ void APP_TimeSlice10ms(void)
     }
 #endif
 
+    BK4819_PROFILE_BEGIN(BK4819_CALLER_UI);
     CheckKeys();
+    BK4819_PROFILE_END();
 }
 
 void cancelUserInputModes(void)
@@ -1676,6 +1737,10 @@ void APP_TimeSlice500ms(void)
 
         if (gBatteryCurrent > 500 || gBatteryCalibration[3] < gBatteryCurrentVoltage)
         {
+            JOURNAL_FlushAll();
+            #ifdef ENABLE_HEARD_LOG
+                HEARDLOG_Flush();
+            #endif
             #ifdef ENABLE_OVERLAY
                 overlay_FLASH_RebootToBootloader();
             #else
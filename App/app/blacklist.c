@@ -0,0 +1,163 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+/**
+ * -----------------------------------
+ * Spectrum blacklist
+ *
+ *    Frequency ranges the spectrum analyzer skips, kept sorted and merged
+ *    so a lookup is one binary search. Ranges are in 10 Hz units, both ends
+ *    included, so they hold at any scan step or zoom.
+ *
+ *    The list is stored as is, header first, at the start of one sector:
+ *    a save programs Count ranges and the rest of the sector reads blank.
+ * ------------------------------------
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "app/blacklist.h"
+#include "driver/py25q16.h"
+
+// Free area above the heard log
+#define BLACKLIST_ADDR 0x05A000
+#define BLACKLIST_MAGIC 0x54534c42 // "BLST"
+
+#ifndef BLACKLIST_MAX
+#define BLACKLIST_MAX 32
+#endif
+
+typedef struct
+{
+    uint32_t Lower;
+    uint32_t Upper;
+} Range_t;
+
+typedef struct
+{
+    uint32_t Magic;
+    uint16_t Count;
+    uint16_t Reserved;
+    Range_t Ranges[BLACKLIST_MAX];
+} List_t;
+
+static List_t List;
+
+static bool Dirty;
+
+// First range that ends at or above Frequency, Count if none
+static uint8_t Find(uint32_t Frequency)
+{
+    uint8_t Lo = 0;
+    uint8_t Hi = List.Count;
+
+    while (Lo < Hi)
+    {
+        const uint8_t Mid = (Lo + Hi) / 2;
+
+        if (List.Ranges[Mid].Upper < Frequency)
+            Lo = Mid + 1;
+        else
+            Hi = Mid;
+    }
+
+    return Lo;
+}
+
+void BLACKLIST_Load(void)
+{
+    PY25Q16_ReadBuffer(BLACKLIST_ADDR, &List, offsetof(List_t, Ranges));
+
+    if (BLACKLIST_MAGIC != List.Magic || List.Count > BLACKLIST_MAX)
+    {
+        BLACKLIST_Clear();
+        Dirty = false;
+        return;
+    }
+
+    PY25Q16_ReadBuffer(BLACKLIST_ADDR + offsetof(List_t, Ranges), List.Ranges,
+                       List.Count * sizeof(Range_t));
+
+    // Not sorted and apart: a half written list, start over
+    for (uint8_t i = 0; i < List.Count; i++)
+    {
+        if (List.Ranges[i].Lower > List.Ranges[i].Upper ||
+            (i && List.Ranges[i].Lower <= List.Ranges[i - 1].Upper))
+        {
+            BLACKLIST_Clear();
+            break;
+        }
+    }
+
+    Dirty = false;
+}
+
+// False when the list is full
+bool BLACKLIST_Add(uint32_t Lower, uint32_t Upper)
+{
+    // Ranges overlapping or touching the new one: First..Last - 1
+    uint8_t First = Find(Lower ? Lower - 1 : 0);
+    uint8_t Last = First;
+
+    while (Last < List.Count && List.Ranges[Last].Lower <= Upper + 1)
+        Last++;
+
+    if (First == Last)
+    {
+        if (List.Count == BLACKLIST_MAX)
+            return false;
+
+        memmove(&List.Ranges[First + 1], &List.Ranges[First], (List.Count - First) * sizeof(Range_t));
+        List.Count++;
+    }
+    else
+    {
+        if (List.Ranges[First].Lower < Lower)
+            Lower = List.Ranges[First].Lower;
+        if (List.Ranges[Last - 1].Upper > Upper)
+            Upper = List.Ranges[Last - 1].Upper;
+
+        memmove(&List.Ranges[First + 1], &List.Ranges[Last], (List.Count - Last) * sizeof(Range_t));
+        List.Count -= Last - First - 1;
+    }
+
+    List.Ranges[First].Lower = Lower;
+    List.Ranges[First].Upper = Upper;
+    Dirty = true;
+    return true;
+}
+
+bool BLACKLIST_Overlaps(uint32_t Lower, uint32_t Upper)
+{
+    const uint8_t i = Find(Lower);
+    return i < List.Count && List.Ranges[i].Lower <= Upper;
+}
+
+void BLACKLIST_Clear(void)
+{
+    List.Magic = BLACKLIST_MAGIC;
+    List.Count = 0;
+    List.Reserved = 0;
+    Dirty = true;
+}
+
+// Goes through the flash sector cache
+void BLACKLIST_Save(void)
+{
+    if (!Dirty)
+        return;
+
+    PY25Q16_WriteBuffer(BLACKLIST_ADDR, &List, offsetof(List_t, Ranges) + List.Count * sizeof(Range_t), true);
+    Dirty = false;
+}
@@ -0,0 +1,26 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef APP_BLACKLIST_H
+#define APP_BLACKLIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void BLACKLIST_Load(void);
+bool BLACKLIST_Add(uint32_t Lower, uint32_t Upper);
+bool BLACKLIST_Overlaps(uint32_t Lower, uint32_t Upper);
+void BLACKLIST_Clear(void);
+void BLACKLIST_Save(void);
+
+#endif
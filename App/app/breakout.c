@@ -20,6 +20,10 @@
 #include "screenshot.h"
 #endif
 
+#ifdef ENABLE_BACKGROUND_TASKS
+#include "task.h"
+#endif
+
 static uint32_t randSeed = 1;
 static uint8_t blockAnim = 0;
 
@@ -455,9 +459,52 @@ static void Tick()
     HandleUserInput();
 }
 
+// Step
+static void Step(void)
+{
+    static uint8_t swap = 0;
+    static uint32_t frameUs = 0;
+
+    // Paced by time, not a delay, so the background services run in between
+    if(!isPaused && SYSTICK_GetUs() - frameUs < (40 - MIN(levelCountBreackout - 1, 20)) * 1000) // Add more fun...
+    {
+        return;
+    }
+    frameUs = SYSTICK_GetUs();
+
+    Tick();
+    if(!isPaused)
+    {
+        if(swap == 0)
+        {
+            blockAnim = (blockAnim + 1) % 4;
+
+            // For screenshot
+            #ifdef ENABLE_FEAT_F4HWN_SCREENSHOT
+                getScreenShot(false);
+            #endif
+        }
+        
+        swap = (swap + 1) % 4;
+
+        drawScore();
+        drawWall();
+        drawRacket();
+        drawBall();
+           
+        if(isBeep)
+        {
+            playBeep(tone);
+            isBeep = false;
+        }
+    }
+
+    ST7565_BlitStatusLine();  // Blank status line
+    ST7565_BlitFullScreen();
+}
+
 // APP_RunBreakout
 void APP_RunBreakout(void) {
-        static uint8_t swap = 0;
 
         // Init seed
         srand_custom(BK4819_ReadRegister(BK4819_REG_67) & 0x01FF * gBatteryVoltageAverage * gEeprom.VfoInfo[0].pRX->Frequency);
@@ -474,40 +521,12 @@ void APP_RunBreakout(void) {
         memset(gStatusLine,  0, sizeof(gStatusLine));
         isInitialized = true;
 
-        while(isInitialized)
-        {
-            Tick();
-            if(!isPaused)
+        #ifdef ENABLE_BACKGROUND_TASKS
+            TASK_RunApp(Step, &isInitialized);
+        #else
+            while(isInitialized)
             {
-                if(swap == 0)
-                {
-                    blockAnim = (blockAnim + 1) % 4;
-
-                    // For screenshot
-                    #ifdef ENABLE_FEAT_F4HWN_SCREENSHOT
-                        getScreenShot(false);
-                    #endif
-                }
-                
-                swap = (swap + 1) % 4;
-
-                drawScore();
-                drawWall();
-                drawRacket();
-                drawBall();
-                   
-                if(isBeep)
-                {
-                    playBeep(tone);
-                    isBeep = false;
-                }
-                else
-                {
-                    SYSTEM_DelayMs(40 - MIN(levelCountBreackout - 1, 20)); // Add more fun...
-                }
+                Step();
             }
-
-            ST7565_BlitStatusLine();  // Blank status line
-            ST7565_BlitFullScreen();
-        }
+        #endif
 }
\ No newline at end of file
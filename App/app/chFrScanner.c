@@ -1,8 +1,12 @@
 
 #include "app/app.h"
 #include "app/chFrScanner.h"
+#include "driver/bk4819_profile.h"
 #include "functions.h"
 #include "misc.h"
+#ifdef ENABLE_SCAN_PLAN
+    #include "scanplan.h"
+#endif
 #include "settings.h"
 //#include "debugging.h"
 
@@ -39,6 +43,8 @@ static void NextMemChannel(void);
 
 void CHFRSCANNER_Start(const bool storeBackupSettings, const int8_t scan_direction)
 {
+    BK4819_PROFILE_BEGIN(BK4819_CALLER_SCAN);
+
     if (storeBackupSettings) {
         initialCROSS_BAND_RX_TX = gEeprom.CROSS_BAND_RX_TX;
         gEeprom.CROSS_BAND_RX_TX = CROSS_BAND_OFF;
@@ -57,6 +63,9 @@ void CHFRSCANNER_Start(const bool storeBackupSettings, const int8_t scan_directi
             initialFrqOrChan = gRxVfo->CHANNEL_SAVE;
             lastFoundFrqOrChan = initialFrqOrChan;
         }
+#ifdef ENABLE_SCAN_PLAN
+        SCANPLAN_Start();
+#endif
         NextMemChannel();
     }
     else
@@ -76,6 +85,8 @@ void CHFRSCANNER_Start(const bool storeBackupSettings, const int8_t scan_directi
     gScheduleScanListen    = false;
     gRxReceptionMode       = RX_MODE_NONE;
     gScanPauseMode         = false;
+
+    BK4819_PROFILE_END();
 }
 
 /*
@@ -104,6 +115,8 @@ void CHFRSCANNER_ContinueScanning(void)
 
 void CHFRSCANNER_ContinueScanning(void)
 {
+    BK4819_PROFILE_BEGIN(BK4819_CALLER_SCAN);
+
     if (gCurrentFunction == FUNCTION_INCOMING &&
         (IS_FREQ_CHANNEL(gNextMrChannel) || gCurrentCodeType == CODE_TYPE_OFF))
     {
@@ -117,10 +130,17 @@ void CHFRSCANNER_ContinueScanning(void)
     gScanPauseMode      = false;
     gRxReceptionMode    = RX_MODE_NONE;
     gScheduleScanListen = false;
+
+    BK4819_PROFILE_END();
 }
 
 void CHFRSCANNER_Found(void)
 {
+#ifdef ENABLE_SCAN_PLAN
+    // the hop only set up the RX side of the channel
+    SCANPLAN_Complete();
+#endif
+
     if (gEeprom.SCAN_RESUME_MODE > 80) {
         if (!gScanPauseMode) {
             gScanPauseDelayIn_10ms = scan_pause_delay_in_5_10ms * (gEeprom.SCAN_RESUME_MODE - 80) * 5;
@@ -187,6 +207,10 @@ void CHFRSCANNER_Found(void)
 
 void CHFRSCANNER_Stop(void)
 {
+#ifdef ENABLE_SCAN_PLAN
+    SCANPLAN_Stop();
+#endif
+
     if(initialCROSS_BAND_RX_TX != CROSS_BAND_OFF) {
         gEeprom.CROSS_BAND_RX_TX = initialCROSS_BAND_RX_TX;
         initialCROSS_BAND_RX_TX = CROSS_BAND_OFF;
@@ -236,7 +260,7 @@ static void NextFreqChannel(void)
 
     RADIO_ApplyOffset(gRxVfo);
     RADIO_ConfigureSquelchAndOutputPower(gRxVfo);
-    RADIO_SetupRegisters(true);
+    RADIO_QuickRetune(true);
 
 #ifdef ENABLE_FASTER_CHANNEL_SCAN
     gScanPauseDelayIn_10ms = 9;   // 90ms
@@ -351,8 +375,11 @@ static void NextMemChannel(void)
         gEeprom.MrChannel[    gEeprom.RX_VFO] = gNextMrChannel;
         gEeprom.ScreenChannel[gEeprom.RX_VFO] = gNextMrChannel;
 
-        RADIO_ConfigureChannel(gEeprom.RX_VFO, VFO_CONFIGURE_RELOAD);
-        RADIO_SetupRegisters(true);
+#ifdef ENABLE_SCAN_PLAN
+        if (!SCANPLAN_Load(gEeprom.RX_VFO, gNextMrChannel))
+#endif
+            RADIO_ConfigureChannel(gEeprom.RX_VFO, VFO_CONFIGURE_RELOAD);
+        RADIO_QuickRetune(true);
 
         gUpdateDisplay = true;
     }
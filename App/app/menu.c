@@ -30,7 +30,11 @@
 #include "driver/eeprom.h"
 #include "driver/gpio.h"
 #include "driver/keyboard.h"
+#include "driver/py25q16_journal.h"
 #include "frequencies.h"
+#ifdef ENABLE_HEARD_LOG
+    #include "heardlog.h"
+#endif
 #include "helper/battery.h"
 #include "misc.h"
 #include "settings.h"
@@ -1765,6 +1769,10 @@ static void MENU_Key_MENU(const bool bKeyPressed, const bool bKeyHeld)
                         #endif
 
                         MENU_AcceptSetting();
+                        JOURNAL_FlushAll();
+                        #ifdef ENABLE_HEARD_LOG
+                            HEARDLOG_Flush();
+                        #endif
 
                         #if defined(ENABLE_OVERLAY)
                             overlay_FLASH_RebootToBootloader();
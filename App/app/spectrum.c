@@ -14,6 +14,7 @@
  *     limitations under the License.
  */
 #include "app/spectrum.h"
+#include "app/blacklist.h"
 #include "am_fix.h"
 #include "audio.h"
 #include "misc.h"
@@ -22,7 +23,12 @@
 #include "chFrScanner.h"
 #endif
 
+#if defined(ENABLE_SPECTRUM_SEGMENTS) && !defined(ENABLE_SCAN_RANGES)
+#error "ENABLE_SPECTRUM_SEGMENTS needs ENABLE_SCAN_RANGES"
+#endif
+
 #include "driver/backlight.h"
+#include "driver/bk4819_profile.h"
 #include "frequencies.h"
 #include "ui/helper.h"
 #include "ui/main.h"
@@ -31,10 +37,18 @@
 #include "screenshot.h"
 #endif
 
-#ifdef ENABLE_FEAT_F4HWN_SPECTRUM
+#if defined(ENABLE_FEAT_F4HWN_SPECTRUM) || defined(ENABLE_SPECTRUM_TRACES) || defined(ENABLE_SPECTRUM_WATERFALL)
 #include "driver/py25q16.h"
 #endif
 
+#ifdef ENABLE_SPECTRUM_STREAM
+#include "app/sweepstream.h"
+#endif
+
+#ifdef ENABLE_BACKGROUND_TASKS
+#include "task.h"
+#endif
+
 struct FrequencyBandInfo
 {
     uint32_t lower;
@@ -65,11 +79,9 @@ State currentState = SPECTRUM, previousState = SPECTRUM;
 PeakInfo peak;
 ScanInfo scanInfo;
 static KeyboardState kbd = {KEY_INVALID, KEY_INVALID, 0};
+static bool side1Held;    // This SIDE1 press turned into a hold
+static bool clearPending; // Blacklist clear asked for, MENU confirms
 
-#ifdef ENABLE_SCAN_RANGES
-static uint16_t blacklistFreqs[15];
-static uint8_t blacklistFreqsIdx;
-#endif
 
 const char *bwOptions[] = {"25", "12.5", "6.25"};
 const uint8_t modulationTypeTuneSteps[] = {100, 50, 10};
@@ -337,13 +349,241 @@ static void RestoreRegisters()
 #endif
 }
 
+// REG_30 as set by the spectrum, SetF() restarts the RX chain with it
+// without reading it back
+static uint16_t rxChainReg;
+
+// Settle-aware RSSI
+//
+// After a retune the glitch counter reads 255 until the noise detector has
+// run, and the RSSI keeps moving while the AGC settles. How long that takes
+// depends on the scan filter (scanStepBWRegValues), so it is learnt per scan
+// step: most of it is slept through, then the RSSI is polled until two
+// readings agree. The next step is tuned as soon as a reading is taken, so it
+// settles while the result is filed and the loop goes round.
+
+#define SETTLE_INITIAL_US 800
+#define SETTLE_POLL_US 50
+#define SETTLE_TIMEOUT_US 10000
+#define SETTLE_RSSI_DELTA 2 // 1 dB
+
+// One slot per scan step setting, plus the coarse sweep filter
+#define SETTLE_COARSE ARRAY_SIZE(scanStepValues)
+
+static uint16_t settleUs[SETTLE_COARSE + 1];
+static uint32_t retuneUs;  // SYSTICK_GetUs() of the last SetF()
+static bool settling;      // no reading taken since the last SetF()
+static bool tunedAhead;    // SetF() already done for the next scan step
+
+static struct
+{
+    uint32_t windowUs;
+    uint32_t settleSum;
+    uint16_t steps;
+    uint16_t stepsPerS;    // shown in the status line
+    uint16_t meanSettleUs;
+} sweepStats;
+
+#ifdef ENABLE_SCAN_RANGES
+// Coarse-to-fine sweep, for ranges of more than 128 steps. Opt-in (key 4 in
+// range mode): it trades weak signals in quiet blocks for sweep speed.
+//
+// Blocks of coarseFactor steps are first measured once, at the block centre,
+// through the 25 kHz filter. Only blocks that stand out from the noise floor
+// of the previous sweep, or come near the trigger level, are then measured
+// step by step. The others show the coarse reading, less the extra noise the
+// wider filter lets in (3 dB per doubling).
+//
+// The BK4819 frequency scan (REG_32) is no help here: it counts the frequency
+// of one strong nearby carrier and takes 0.2 s or more per result.
+
+#define COARSE_BW 2500        // 10 Hz units
+#define COARSE_MAX_FACTOR 4
+#define COARSE_MARGIN 8       // 4 dB
+#define COARSE_BW_REG listenBWRegValues[BK4819_FILTER_BW_WIDE]
+
+static bool coarseOn;
+static uint8_t coarseFactor = 1;    // steps per block, a power of two; 1 = off
+static uint8_t coarsePenalty;       // noise of the wide filter, RSSI units
+static uint16_t coarseFloor;        // lowest block reading of the last sweep
+static uint16_t coarseFloorNext;
+static bool coarsePass;
+#endif
+
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+// Disjoint segments swept back to back, in place of the range
+//
+// Steps are numbered through the segments in order, so the history, the peak
+// and the blacklist work on them as on one range and the gaps are never tuned.
+// Past 128 steps each segment gets the bins its share of the steps falls on,
+// so a bin only mixes two segments when one is narrower than a bin. All
+// segments use the scan step.
+
+#ifndef SPECTRUM_SEGMENTS
+#define SPECTRUM_SEGMENTS                             \
+    {44600625, 44619375},   /* PMR446 */              \
+    {14560000, 14578750},   /* 2 m repeater outputs */ \
+    {43340000, 43360000},   /* 70 cm simplex */
+#endif
+
+typedef struct
+{
+    uint32_t start, stop;   // 10 Hz units, both swept
+} Segment;
+
+static const Segment segments[] = {SPECTRUM_SEGMENTS};
+static bool segmentsOn;
+#endif
+
+#ifdef ENABLE_SPECTRUM_TRACES
+// Average, max hold and min hold traces, views of the graph
+//
+// Q8 per display bin, all three updated in one pass at the end of each sweep
+// so a view shows a settled trace as soon as it is picked. Max hold sinks by
+// SPECTRUM_TRACE_DECAY per sweep and min hold rises by SPECTRUM_TRACE_RISE,
+// letting go of signals that are gone. The min hold trace is the noise floor
+// the automatic trigger level is set from.
+
+#define TRACE_AVG_SHIFT 3                 // 1/8 of the difference per sweep
+#ifndef SPECTRUM_TRACE_DECAY
+#define SPECTRUM_TRACE_DECAY 64           // Q8 RSSI units (0.5 dB) per sweep
+#endif
+#ifndef SPECTRUM_TRACE_RISE
+#define SPECTRUM_TRACE_RISE 16
+#endif
+#define TRACE_SETTLE 16                   // sweeps before the floor is trusted
+#define TRACE_TRIGGER_MARGIN 8            // 4 dB
+
+typedef struct
+{
+    uint32_t avg, max, min;
+} TraceBin;
+
+static uint8_t traceSweeps;               // since the last reset, saturates
+#endif
+
+#ifdef ENABLE_SPECTRUM_WATERFALL
+// Waterfall below the graph, one of the views
+//
+// Each sweep leaves a row of WATERFALL_BINS 4 bit levels, two per byte, in a
+// ring. Levels are taken against the dB scale of their own sweep and are not
+// rescaled later. A new sweep scrolls the dithered rows down one pixel and
+// draws just its row.
+
+#define WATERFALL_BINS 64                           // 2 px each
+#define WATERFALL_ROW_BYTES (WATERFALL_BINS / 2)
+#define WATERFALL_LINE 3                            // first framebuffer line
+#define WATERFALL_ROWS 16                           // pixels, a multiple of 8
+
+static const uint8_t waterfallBayer[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5},
+};
+
+static uint8_t waterfallHead;      // newest row
+static uint8_t waterfallRows;      // rows held
+static uint8_t waterfallSeq;       // sweep count, pins the dither pattern to the rows
+static bool waterfallOn;
+static bool waterfallPending;      // row of the last sweep not drawn yet
+static bool waterfallShown;        // the framebuffer holds the rows
+
+static void WaterfallReset()
+{
+    waterfallRows = 0;
+    waterfallPending = false;
+    waterfallShown = false;
+}
+#endif
+
+#if defined(ENABLE_SPECTRUM_TRACES) || defined(ENABLE_SPECTRUM_WATERFALL)
+// Held in the flash sector cache: the spectrum only writes settings on entry
+// and exit, so that buffer sits idle in between
+static struct Scratch
+{
+#ifdef ENABLE_SPECTRUM_TRACES
+    TraceBin trace[128];
+#endif
+#ifdef ENABLE_SPECTRUM_WATERFALL
+    uint8_t waterfall[WATERFALL_ROWS][WATERFALL_ROW_BYTES];
+#endif
+} *scratch;
+
+_Static_assert(sizeof(struct Scratch) <= 4096, "spectrum scratch");
+#endif
+
+static SpectrumView view;
+
+static uint8_t GetDisplayBins()
+{
+    return scanInfo.measurementsCount > 128 ? 128 : scanInfo.measurementsCount;
+}
+
+#ifdef ENABLE_SPECTRUM_TRACES
+static inline uint32_t MinU32(uint32_t a, uint32_t b)
+{
+    return b ^ ((a ^ b) & -(uint32_t)(a < b));
+}
+
+static inline uint32_t MaxU32(uint32_t a, uint32_t b)
+{
+    return a ^ ((a ^ b) & -(uint32_t)(a < b));
+}
+
+static void UpdateTraces()
+{
+    const uint8_t bins = GetDisplayBins();
+    TraceBin *t = scratch->trace;
+
+    for (uint8_t i = 0; i < bins; i++, t++)
+    {
+        // Blacklisted bins keep their traces
+        const uint32_t keep = -(uint32_t)(rssiHistory[i] == RSSI_MAX_VALUE);
+        const uint32_t x = ((uint32_t)rssiHistory[i] << 8) & ~keep;
+
+        if (!traceSweeps)
+        {
+            t->avg = t->max = t->min = x;
+            continue;
+        }
+
+        const uint32_t avg = t->avg + ((int32_t)(x - t->avg) >> TRACE_AVG_SHIFT);
+        const uint32_t sunk = (t->max - SPECTRUM_TRACE_DECAY) & -(uint32_t)(t->max >= SPECTRUM_TRACE_DECAY);
+        const uint32_t max = MaxU32(x, sunk);
+        const uint32_t min = MinU32(x, t->min + SPECTRUM_TRACE_RISE);
+
+        t->avg = (avg & ~keep) | (t->avg & keep);
+        t->max = (max & ~keep) | (t->max & keep);
+        t->min = (min & ~keep) | (t->min & keep);
+    }
+
+    if (traceSweeps < 255)
+        traceSweeps++;
+}
+
+// Highest bin of the min hold trace: above the steady signals, not the bursts
+static uint16_t TraceFloor()
+{
+    const uint8_t bins = GetDisplayBins();
+    uint32_t floor = 0;
+
+    for (uint8_t i = 0; i < bins; i++)
+    {
+        if (rssiHistory[i] != RSSI_MAX_VALUE)
+            floor = MaxU32(floor, scratch->trace[i].min);
+    }
+
+    return (floor + 128) >> 8;
+}
+#endif
+
 static void ToggleAFDAC(bool on)
 {
-    uint32_t Reg = BK4819_ReadRegister(BK4819_REG_30);
-    Reg &= ~(1 << 9);
+    rxChainReg &= ~(1 << 9);
     if (on)
-        Reg |= (1 << 9);
-    BK4819_WriteRegister(BK4819_REG_30, Reg);
+        rxChainReg |= (1 << 9);
+    BK4819_WriteRegister(BK4819_REG_30, rxChainReg);
 }
 
 static void SetF(uint32_t f)
@@ -352,9 +592,112 @@ static void SetF(uint32_t f)
 
     BK4819_SetFrequency(fMeasure);
     BK4819_PickRXFilterPathBasedOnFrequency(fMeasure);
-    uint16_t reg = BK4819_ReadRegister(BK4819_REG_30);
     BK4819_WriteRegister(BK4819_REG_30, 0);
-    BK4819_WriteRegister(BK4819_REG_30, reg);
+    BK4819_WriteRegister(BK4819_REG_30, rxChainReg);
+
+    retuneUs = SYSTICK_GetUs();
+    settling = true;
+}
+
+static void InitSettle()
+{
+    for (uint8_t i = 0; i < ARRAY_SIZE(settleUs); i++)
+    {
+        settleUs[i] = SETTLE_INITIAL_US;
+    }
+    memset(&sweepStats, 0, sizeof(sweepStats));
+    sweepStats.windowUs = SYSTICK_GetUs();
+}
+
+static uint8_t SettleSlot()
+{
+#ifdef ENABLE_SCAN_RANGES
+    if (coarsePass)
+        return SETTLE_COARSE;
+#endif
+    return settings.scanStepIndex;
+}
+
+// settled: from the retune to the first of the readings that agreed. Steps
+// that never settle count as SETTLE_TIMEOUT_US, which bounds the average.
+static void LearnSettle(uint32_t settled)
+{
+    const uint16_t sample = MIN(settled, SETTLE_TIMEOUT_US);
+    uint16_t *pLearnt = &settleUs[SettleSlot()];
+    *pLearnt += ((int32_t)sample - *pLearnt) / 8;
+
+    sweepStats.settleSum += sample;
+    sweepStats.steps++;
+
+    const uint32_t window = SYSTICK_GetUs() - sweepStats.windowUs;
+    if (window >= 1000000)
+    {
+        sweepStats.stepsPerS = sweepStats.steps * 1000u / (window / 1000);
+        sweepStats.meanSettleUs = sweepStats.settleSum / sweepStats.steps;
+        sweepStats.windowUs += window;
+        sweepStats.settleSum = 0;
+        sweepStats.steps = 0;
+        redrawStatus = true;
+    }
+}
+
+static void SettleWait(uint16_t us)
+{
+#ifdef ENABLE_SPECTRUM_STREAM
+    // Feed the sweep stream meanwhile
+    const uint32_t start = SYSTICK_GetUs();
+    do
+        SWEEPSTREAM_Pump();
+    while (SYSTICK_GetUs() - start < us);
+#else
+    SYSTICK_DelayUs(us);
+#endif
+}
+
+static uint16_t ReadSettledRssi()
+{
+    // Only scan readings right after a retune are timed, the listening filter
+    // settles differently
+    const bool learn = settling && !isListening;
+    const uint16_t sleep = settleUs[SettleSlot()] * 3 / 4;
+    uint32_t elapsed = SYSTICK_GetUs() - retuneUs;
+    uint32_t lastUs = 0; // when last was read
+    uint16_t last = RSSI_MAX_VALUE;
+    uint16_t rssi;
+
+    if (learn && elapsed < sleep)
+    {
+        SettleWait(sleep - elapsed);
+    }
+
+    for (;;)
+    {
+        const bool glitchReady = (BK4819_ReadRegister(BK4819_REG_63) & 0xff) < 255;
+        rssi = BK4819_GetRSSI();
+        elapsed = SYSTICK_GetUs() - retuneUs;
+
+        if (glitchReady && (!settling || (rssi + SETTLE_RSSI_DELTA >= last && rssi <= last + SETTLE_RSSI_DELTA)))
+            break;
+
+        if (elapsed >= SETTLE_TIMEOUT_US)
+        {
+            lastUs = elapsed;
+            break;
+        }
+
+        last = glitchReady ? rssi : RSSI_MAX_VALUE;
+        lastUs = elapsed;
+        SettleWait(SETTLE_POLL_US);
+    }
+
+    // The confirming reading and the poll before it are not settle time
+    if (learn)
+    {
+        LearnSettle(lastUs);
+    }
+    settling = false;
+
+    return rssi;
 }
 
 // Spectrum related
@@ -401,8 +744,59 @@ bool IsCenterMode() { return settings.scanStepIndex < S_STEP_2_5kHz; }
 // scan step in 0.01khz
 uint16_t GetScanStep() { return scanStepValues[settings.scanStepIndex]; }
 
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+static uint16_t SegmentSteps(uint8_t k)
+{
+    return (segments[k].stop - segments[k].start) / GetScanStep() + 1;
+}
+
+static uint32_t SegmentFreq(uint16_t idx)
+{
+    for (uint8_t k = 0; k < ARRAY_SIZE(segments); k++)
+    {
+        const uint16_t steps = SegmentSteps(k);
+        if (idx < steps)
+            return segments[k].start + (uint32_t)idx * GetScanStep();
+        idx -= steps;
+    }
+    return segments[ARRAY_SIZE(segments) - 1].stop;
+}
+
+// Display bins before step idx, when steps are merged into bins
+static uint8_t BinsBefore(uint16_t idx)
+{
+    return (uint32_t)idx * 128 / scanInfo.measurementsCount;
+}
+
+// Past 128 steps, the steps of a segment spread over its own bins only
+static uint8_t SegmentBin(uint16_t idx)
+{
+    uint16_t first = 0;
+    for (uint8_t k = 0;; k++)
+    {
+        const uint16_t steps = SegmentSteps(k);
+        if (idx < first + steps || k == ARRAY_SIZE(segments) - 1)
+        {
+            const uint8_t bin = BinsBefore(first);
+            const uint8_t bins = BinsBefore(first + steps) - bin;
+            return bin + (uint32_t)(idx - first) * bins / steps;
+        }
+        first += steps;
+    }
+}
+#endif
+
 uint16_t GetStepsCount()
 {
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+    {
+        uint16_t steps = 0;
+        for (uint8_t k = 0; k < ARRAY_SIZE(segments); k++)
+            steps += SegmentSteps(k);
+        return steps;
+    }
+#endif
 #ifdef ENABLE_SCAN_RANGES
     if (gScanRangeStart)
     {
@@ -417,6 +811,12 @@ uint16_t GetStepsCount()
 #ifdef ENABLE_SCAN_RANGES
 static uint16_t GetStepsCountDisplay()
 {
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+    {
+        return GetStepsCount();
+    }
+#endif
     if (gScanRangeStart)
     {
         return (gScanRangeStop - gScanRangeStart) / GetScanStep();
@@ -428,11 +828,23 @@ static uint16_t GetStepsCountDisplay()
 uint32_t GetBW() { return GetStepsCount() * GetScanStep(); }
 uint32_t GetFStart()
 {
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+    {
+        return segments[0].start;
+    }
+#endif
     return IsCenterMode() ? currentFreq - (GetBW() >> 1) : currentFreq;
 }
 
 uint32_t GetFEnd()
 {
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+    {
+        return segments[ARRAY_SIZE(segments) - 1].stop;
+    }
+#endif
 #ifdef ENABLE_SCAN_RANGES
     if (gScanRangeStart)
     {
@@ -452,6 +864,9 @@ static void TuneToPeak()
 
 static void DeInitSpectrum()
 {
+#if defined(ENABLE_SPECTRUM_TRACES) || defined(ENABLE_SPECTRUM_WATERFALL)
+    PY25Q16_ReturnSectorCache();
+#endif
     SetF(initialFreq);
     RestoreRegisters();
     isInitialized = false;
@@ -464,13 +879,7 @@ uint8_t GetBWRegValueForScan()
 
 uint16_t GetRssi()
 {
-    // SYSTICK_DelayUs(800);
-    // testing autodelay based on Glitch value
-    while ((BK4819_ReadRegister(0x63) & 0b11111111) >= 255)
-    {
-        SYSTICK_DelayUs(100);
-    }
-    uint16_t rssi = BK4819_GetRSSI();
+    uint16_t rssi = ReadSettledRssi();
 #ifdef ENABLE_AM_FIX__
     if (settings.modulationType == MODULATION_AM && gSetting_AM_fix)
         rssi += AM_fix_get_gain_diff() * 2;
@@ -503,6 +912,7 @@ static void ToggleRX(bool on)
     }
     #endif
     isListening = on;
+    tunedAhead = false;
 
     RADIO_SetupAGC(settings.modulationType == MODULATION_AM, lockAGC);
     BK4819_ToggleGpioOut(BK4819_GPIO6_PIN2_GREEN, on);
@@ -541,24 +951,41 @@ static void ResetScanStats()
 static void InitScan()
 {
     ResetScanStats();
+    tunedAhead = false;
     scanInfo.i = 0;
     scanInfo.f = GetFStart();
 
     scanInfo.scanStep = GetScanStep();
     scanInfo.measurementsCount = GetStepsCount();
+
+#ifdef ENABLE_SCAN_RANGES
+    coarseFactor = 1;
+    coarsePenalty = 0;
+    // Coarse blocks would straddle the segment gaps
+    if (coarseOn && scanInfo.measurementsCount > 128
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+        && !segmentsOn
+#endif
+    )
+    {
+        while (coarseFactor < COARSE_MAX_FACTOR && coarseFactor * 2 * scanInfo.scanStep <= COARSE_BW)
+        {
+            coarseFactor *= 2;
+            coarsePenalty += 6;
+        }
+    }
+    coarseFloorNext = RSSI_MAX_VALUE;
+#endif
 }
 
-static void ResetBlacklist()
+// The blacklist itself is kept, the next sweep marks its steps again
+static void ClearBlacklistMarks()
 {
     for (int i = 0; i < 128; ++i)
     {
         if (rssiHistory[i] == RSSI_MAX_VALUE)
             rssiHistory[i] = 0;
     }
-#ifdef ENABLE_SCAN_RANGES
-    memset(blacklistFreqs, 0, sizeof(blacklistFreqs));
-    blacklistFreqsIdx = 0;
-#endif
 }
 
 static void RelaunchScan()
@@ -571,6 +998,15 @@ static void RelaunchScan()
 #endif
     preventKeypress = true;
     scanInfo.rssiMin = RSSI_MAX_VALUE;
+#ifdef ENABLE_SCAN_RANGES
+    coarseFloor = RSSI_MAX_VALUE;  // first sweep refines everything
+#endif
+#ifdef ENABLE_SPECTRUM_TRACES
+    traceSweeps = 0;
+#endif
+#ifdef ENABLE_SPECTRUM_WATERFALL
+    WaterfallReset();
+#endif
 }
 
 static void UpdateScanInfo()
@@ -594,6 +1030,16 @@ static void AutoTriggerLevel()
 {
     if (settings.rssiTriggerLevel == RSSI_MAX_VALUE)
     {
+#ifdef ENABLE_SPECTRUM_TRACES
+        // From the noise floor once it settled, so a burst caught by the
+        // first sweep does not lift the level
+        if (currentState == SPECTRUM)
+        {
+            if (traceSweeps >= TRACE_SETTLE)
+                settings.rssiTriggerLevel = TraceFloor() + TRACE_TRIGGER_MARGIN;
+            return;
+        }
+#endif
         settings.rssiTriggerLevel = clamp(scanInfo.rssiMax + 8, 0, RSSI_MAX_VALUE);
     }
 }
@@ -618,10 +1064,22 @@ static void SetRssiHistory(uint16_t idx, uint16_t rssi)
 #ifdef ENABLE_SCAN_RANGES
     if (scanInfo.measurementsCount > 128)
     {
-        uint8_t i = (uint32_t)ARRAY_SIZE(rssiHistory) * 1000 / scanInfo.measurementsCount * idx / 1000;
-        if (rssiHistory[i] < rssi || isListening)
+        uint8_t i;
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+        if (segmentsOn)
+            i = SegmentBin(idx);
+        else
+#endif
+        i = (uint32_t)ARRAY_SIZE(rssiHistory) * 1000 / scanInfo.measurementsCount * idx / 1000;
+        if (i >= ARRAY_SIZE(rssiHistory))
+            i = ARRAY_SIZE(rssiHistory) - 1;
+
+        // The highest reading of the steps in a bin, the bin after it is
+        // cleared for the next ones. The first step starts the sweep over.
+        if (idx == 0 || rssiHistory[i] < rssi || isListening)
             rssiHistory[i] = rssi;
-        rssiHistory[(i + 1) % 128] = 0;
+        if (i + 1 < ARRAY_SIZE(rssiHistory))
+            rssiHistory[i + 1] = 0;
         return;
     }
 #endif
@@ -695,7 +1153,7 @@ static void UpdateScanStep(bool inc)
 
     settings.frequencyChangeStep = GetBW() >> 1;
     RelaunchScan();
-    ResetBlacklist();
+    ClearBlacklistMarks();
     redrawScreen = true;
 }
 
@@ -714,7 +1172,7 @@ static void UpdateCurrentFreq(bool inc)
         return;
     }
     RelaunchScan();
-    ResetBlacklist();
+    ClearBlacklistMarks();
     redrawScreen = true;
 }
 
@@ -803,10 +1261,32 @@ static void ToggleStepsCount()
     }
     settings.frequencyChangeStep = GetBW() >> 1;
     RelaunchScan();
-    ResetBlacklist();
+    ClearBlacklistMarks();
     redrawScreen = true;
 }
 
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+static void ToggleSegments()
+{
+    segmentsOn = !segmentsOn;
+    memset(rssiHistory, 0, sizeof(rssiHistory));
+    ClearBlacklistMarks();
+    RelaunchScan();
+    redrawScreen = true;
+    redrawStatus = true;
+}
+#endif
+
+#ifdef ENABLE_SCAN_RANGES
+static void ToggleCoarse()
+{
+    coarseOn = !coarseOn;
+    RelaunchScan();
+    redrawScreen = true;
+    redrawStatus = true;
+}
+#endif
+
 static void ResetFreqInput()
 {
     tempFreq = 0;
@@ -887,11 +1367,20 @@ static void UpdateFreqInput(KEY_Code_t key)
     redrawScreen = true;
 }
 
+// What one scan step at f covers
+static uint32_t StepLower(uint32_t f) { return f - scanInfo.scanStep / 2; }
+static uint32_t StepUpper(uint32_t f) { return f + (scanInfo.scanStep - 1) / 2; }
+
+static bool IsBlacklisted(uint32_t f)
+{
+    return BLACKLIST_Overlaps(StepLower(f), StepUpper(f));
+}
+
 static void Blacklist()
 {
-#ifdef ENABLE_SCAN_RANGES
-    blacklistFreqs[blacklistFreqsIdx++ % ARRAY_SIZE(blacklistFreqs)] = peak.i;
-#endif
+    // Kept as a frequency range, so it holds at any step or zoom and
+    // across power cycles; saved on exit
+    BLACKLIST_Add(StepLower(peak.f), StepUpper(peak.f));
 
     SetRssiHistory(peak.i, RSSI_MAX_VALUE);
     ResetPeak();
@@ -899,16 +1388,12 @@ static void Blacklist()
     ResetScanStats();
 }
 
-#ifdef ENABLE_SCAN_RANGES
-static bool IsBlacklisted(uint16_t idx)
+static void ClearBlacklist()
 {
-    if (blacklistFreqsIdx)
-        for (uint8_t i = 0; i < ARRAY_SIZE(blacklistFreqs); i++)
-            if (blacklistFreqs[i] == idx)
-                return true;
-    return false;
+    BLACKLIST_Clear();
+    ClearBlacklistMarks();
+    redrawScreen = true;
 }
-#endif
 
 // Draw things
 
@@ -926,9 +1411,130 @@ uint8_t Rssi2PX(uint16_t rssi, uint8_t pxMin, uint8_t pxMax)
     return ((dbm - DB_MIN) * PX_RANGE + DB_RANGE / 2) / DB_RANGE + pxMin;
 }
 
+static uint8_t GraphEndY()
+{
+#ifdef ENABLE_SPECTRUM_WATERFALL
+    if (waterfallOn)
+        return WATERFALL_LINE * 8 - 2;
+#endif
+    return DrawingEndY;
+}
+
 uint8_t Rssi2Y(uint16_t rssi)
 {
-    return DrawingEndY - Rssi2PX(rssi, 0, DrawingEndY);
+    return GraphEndY() - Rssi2PX(rssi, 0, GraphEndY());
+}
+
+#ifdef ENABLE_SPECTRUM_WATERFALL
+static void WaterfallBegin()
+{
+    if (!waterfallOn)
+        return;
+
+    waterfallHead = (waterfallHead + 1) % WATERFALL_ROWS;
+    memset(scratch->waterfall[waterfallHead], 0, WATERFALL_ROW_BYTES);
+    if (waterfallRows < WATERFALL_ROWS)
+        waterfallRows++;
+    waterfallSeq++;
+    waterfallPending = true;
+}
+
+// Fed by DrawSpectrum() with each drawn column, a bin keeps its highest level
+static void WaterfallFeed(uint8_t x, uint16_t rssi)
+{
+    if (!waterfallPending)
+        return;
+
+    uint8_t *p = &scratch->waterfall[waterfallHead][x / 4];
+    const uint8_t shift = (x & 2) ? 4 : 0;
+    const uint8_t level = Rssi2PX(rssi, 0, 15);
+
+    if (level > ((*p >> shift) & 15))
+        *p = (*p & ~(15 << shift)) | level << shift;
+}
+
+static void DrawWaterfallRow(uint8_t row, uint8_t y, uint8_t seq)
+{
+    const uint8_t *threshold = waterfallBayer[seq & 3];
+    uint8_t *line = gFrameBuffer[WATERFALL_LINE + y / 8];
+    const uint8_t bit = 1u << (y & 7);
+
+    for (uint8_t x = 0; x < 128; x++)
+    {
+        const uint8_t level = (scratch->waterfall[row][x / 4] >> ((x & 2) ? 4 : 0)) & 15;
+        if (level > threshold[x & 3])
+            line[x] |= bit;
+        else
+            line[x] &= ~bit;
+    }
+}
+
+static void ScrollWaterfall()
+{
+    for (uint8_t x = 0; x < 128; x++)
+    {
+        uint8_t carry = 0;
+        for (uint8_t l = WATERFALL_LINE; l < WATERFALL_LINE + WATERFALL_ROWS / 8; l++)
+        {
+            const uint8_t b = gFrameBuffer[l][x];
+            gFrameBuffer[l][x] = b << 1 | carry;
+            carry = b >> 7;
+        }
+    }
+}
+
+static void DrawWaterfall()
+{
+    if (!waterfallOn)
+        return;
+
+    if (!waterfallShown)
+    {
+        memset(gFrameBuffer[WATERFALL_LINE], 0, WATERFALL_ROWS / 8 * sizeof(gFrameBuffer[0]));
+        for (uint8_t y = 0; y < waterfallRows; y++)
+            DrawWaterfallRow((waterfallHead + WATERFALL_ROWS - y) % WATERFALL_ROWS, y, waterfallSeq - y);
+        waterfallShown = true;
+    }
+    else if (waterfallPending)
+    {
+        ScrollWaterfall();
+        DrawWaterfallRow(waterfallHead, 0, waterfallSeq);
+    }
+
+    waterfallPending = false;
+}
+#endif
+
+static uint16_t GraphRssi(uint16_t i)
+{
+#ifdef ENABLE_SPECTRUM_TRACES
+    if (traceSweeps && rssiHistory[i] != RSSI_MAX_VALUE)
+    {
+        switch (view)
+        {
+        case VIEW_AVERAGE:
+            return (scratch->trace[i].avg + 128) >> 8;
+        case VIEW_MAX_HOLD:
+            return (scratch->trace[i].max + 128) >> 8;
+        case VIEW_MIN_HOLD:
+            return (scratch->trace[i].min + 128) >> 8;
+        default:
+            break;
+        }
+    }
+#endif
+    return rssiHistory[i];
+}
+
+static void NextView()
+{
+    view = (view + 1) % VIEW_COUNT;
+#ifdef ENABLE_SPECTRUM_WATERFALL
+    waterfallOn = view == VIEW_WATERFALL;
+    WaterfallReset();
+#endif
+    redrawScreen = true;
+    redrawStatus = true;
 }
 
 #ifdef ENABLE_FEAT_F4HWN
@@ -941,7 +1547,7 @@ uint8_t Rssi2Y(uint16_t rssi)
         uint8_t ox = 0;
         for (uint8_t i = 0; i < bars; ++i)
         {
-            uint16_t rssi = rssiHistory[(bars>128) ? i >> settings.stepsCount : i];
+            uint16_t rssi = GraphRssi((bars>128) ? i >> settings.stepsCount : i);
             
 #ifdef ENABLE_SCAN_RANGES
             uint8_t x;
@@ -974,7 +1580,10 @@ uint8_t Rssi2Y(uint16_t rssi)
             {
                 for (uint8_t xx = ox; xx < x; xx++)
                 {
-                    DrawVLine(Rssi2Y(rssi), DrawingEndY, xx, true);
+                    DrawVLine(Rssi2Y(rssi), GraphEndY(), xx, true);
+#ifdef ENABLE_SPECTRUM_WATERFALL
+                    WaterfallFeed(xx, rssi);
+#endif
                 }
             }
             ox = x;
@@ -985,15 +1594,50 @@ uint8_t Rssi2Y(uint16_t rssi)
     {
         for (uint8_t x = 0; x < 128; ++x)
         {
-            uint16_t rssi = rssiHistory[x >> settings.stepsCount];
+            uint16_t rssi = GraphRssi(x >> settings.stepsCount);
             if (rssi != RSSI_MAX_VALUE)
             {
-                DrawVLine(Rssi2Y(rssi), DrawingEndY, x, true);
+                DrawVLine(Rssi2Y(rssi), GraphEndY(), x, true);
+#ifdef ENABLE_SPECTRUM_WATERFALL
+                WaterfallFeed(x, rssi);
+#endif
             }
         }
     }
 #endif
 
+static void DrawSweepStats()
+{
+    if (isListening || !sweepStats.stepsPerS)
+    {
+        return;
+    }
+
+    sprintf(String, "%u/s %uus", sweepStats.stepsPerS, sweepStats.meanSettleUs);
+#ifdef ENABLE_SCAN_RANGES
+    if (coarseFactor > 1)
+        strcat(String, " C");
+#endif
+    GUI_DisplaySmallest(String, 36, 1, true, true);
+}
+
+static void DrawView()
+{
+    static const char *const names[] = {
+        [VIEW_LIVE] = "",
+#ifdef ENABLE_SPECTRUM_TRACES
+        [VIEW_AVERAGE] = "AVG",
+        [VIEW_MAX_HOLD] = "MAX",
+        [VIEW_MIN_HOLD] = "MIN",
+#endif
+#ifdef ENABLE_SPECTRUM_WATERFALL
+        [VIEW_WATERFALL] = "WF",
+#endif
+    };
+
+    GUI_DisplaySmallest(names[view], 96, 1, true, true);
+}
+
 static void DrawStatus()
 {
 #ifdef SPECTRUM_EXTRA_VALUES
@@ -1003,13 +1647,22 @@ static void DrawStatus()
     sprintf(String, "%d/%d", settings.dbMin, settings.dbMax);
 #endif
     GUI_DisplaySmallest(String, 0, 1, true, true);
+#ifndef SPECTRUM_EXTRA_VALUES
+    DrawSweepStats();
+    DrawView();
+#endif
 
+#ifdef ENABLE_BACKGROUND_TASKS
+    // Sampled by the battery task
+    uint16_t voltage = gBatteryVoltageAverage;
+#else
     BOARD_ADC_GetBatteryInfo(&gBatteryVoltages[gBatteryCheckCounter++ % 4],
                              &gBatteryCurrent);
 
     uint16_t voltage = (gBatteryVoltages[0] + gBatteryVoltages[1] +
                         gBatteryVoltages[2] + gBatteryVoltages[3]) /
                        4 * 760 / gBatteryCalibration[3];
+#endif
 
     unsigned perc = BATTERY_VoltsToPercent(voltage);
 
@@ -1063,6 +1716,10 @@ static void ShowChannelName(uint32_t f)
     else
     {
         memset(&gStatusLine[36], 0, 100 - 28);
+#ifndef SPECTRUM_EXTRA_VALUES
+        DrawSweepStats();
+        DrawView();
+#endif
     }
     ST7565_BlitStatusLine();
 }
@@ -1139,9 +1796,18 @@ static void DrawTicks()
 {
     uint32_t f = GetFStart();
     uint32_t span = GetFEnd() - GetFStart();
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+        span = (uint32_t)GetStepsCount() * GetScanStep();   // the gaps take no room
+#endif
     uint32_t step = span / 128;
     for (uint8_t i = 0; i < 128; i += (1 << settings.stepsCount))
     {
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+        if (segmentsOn)
+            f = SegmentFreq((uint32_t)i * GetStepsCount() / 128);
+        else
+#endif
         f = GetFStart() + span * i / 128;
         uint8_t barValue = 0b00000001;
         (f % 10000) < step && (barValue |= 0b00000010);
@@ -1179,8 +1845,49 @@ static void DrawArrow(uint8_t x)
     }
 }
 
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+// Dotted line where each segment after the first starts
+static void DrawSegmentSeparators()
+{
+    const uint16_t steps = GetStepsCount();
+    uint16_t first = 0;
+
+    for (uint8_t k = 1; k < ARRAY_SIZE(segments); k++)
+    {
+        first += SegmentSteps(k - 1);
+        const uint8_t bin = steps > 128 ? BinsBefore(first) : first;
+        uint8_t x = bin;
+#ifdef ENABLE_FEAT_F4HWN
+        // Left edge of the bar, as laid out by DrawSpectrum()
+        const uint8_t bars = steps > 128 ? 128 : steps;
+        if (bars > 1)
+        {
+            const uint16_t fullWidth = 128 * 2 / (bars - 1);
+            x = fullWidth / 4 + (uint16_t)(bin - 1) * fullWidth / 2;
+        }
+#endif
+        if (x >= 128)
+            continue;
+
+        for (uint8_t y = 0; y <= GraphEndY(); y++)
+            PutPixel(x, y, !(y & 1));
+        gFrameBuffer[5][x] = 0xff;
+    }
+}
+#endif
+
 static void OnKeyDown(uint8_t key)
 {
+    if (clearPending)
+    {
+        // Any other key keeps the blacklist
+        clearPending = false;
+        if (key == KEY_MENU)
+            ClearBlacklist();
+        redrawScreen = true;
+        return;
+    }
+
     switch (key)
     {
     case KEY_3:
@@ -1221,9 +1928,6 @@ static void OnKeyDown(uint8_t key)
             UpdateCurrentFreq(false);
 #endif
         break;
-    case KEY_SIDE1:
-        Blacklist();
-        break;
     case KEY_STAR:
         UpdateRssiTriggerLevel(true);
         break;
@@ -1231,6 +1935,13 @@ static void OnKeyDown(uint8_t key)
         UpdateRssiTriggerLevel(false);
         break;
     case KEY_5:
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+        if (gScanRangeStart)
+        {
+            ToggleSegments();
+            break;
+        }
+#endif
 #ifdef ENABLE_SCAN_RANGES
         if (!gScanRangeStart)
 #endif
@@ -1244,9 +1955,13 @@ static void OnKeyDown(uint8_t key)
         break;
     case KEY_4:
 #ifdef ENABLE_SCAN_RANGES
-        if (!gScanRangeStart)
+        if (gScanRangeStart)
+        {
+            ToggleCoarse();
+            break;
+        }
 #endif
-            ToggleStepsCount();
+        ToggleStepsCount();
         break;
     case KEY_SIDE2:
         ToggleBacklight();
@@ -1256,6 +1971,7 @@ static void OnKeyDown(uint8_t key)
         TuneToPeak();
         break;
     case KEY_MENU:
+        NextView();
         break;
     case KEY_EXIT:
         if (menuState)
@@ -1263,14 +1979,17 @@ static void OnKeyDown(uint8_t key)
             menuState = 0;
             break;
         }
+        // Returns the sector cache, the writes below need it
+        DeInitSpectrum();
 #ifdef ENABLE_FEAT_F4HWN_SPECTRUM
         SaveSettings();
 #endif
+        // Edits wait until here: the sector cache was lent
+        BLACKLIST_Save();
 #ifdef ENABLE_FEAT_F4HWN_RESUME_STATE
         gEeprom.CURRENT_STATE = 0;
         SETTINGS_WriteCurrentState();
 #endif
-        DeInitSpectrum();
         break;
     default:
         break;
@@ -1311,7 +2030,7 @@ static void OnKeyDownFreqInput(uint8_t key)
         currentFreq = tempFreq;
         if (currentState == SPECTRUM)
         {
-            ResetBlacklist();
+            ClearBlacklistMarks();
             RelaunchScan();
         }
         else
@@ -1432,10 +2151,25 @@ static void RenderStatus()
 static void RenderSpectrum()
 {
     DrawTicks();
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn && GetStepsCount() > 128)
+        DrawArrow(SegmentBin(peak.i));
+    else
+#endif
     DrawArrow(128u * peak.i / GetStepsCount());
     DrawSpectrum();
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+        DrawSegmentSeparators();
+#endif
+#ifdef ENABLE_SPECTRUM_WATERFALL
+    DrawWaterfall();
+#endif
     DrawRssiTriggerLevel();
-    DrawF(peak.f);
+    if (clearPending)
+        UI_PrintStringSmallNormal("CLEAR BL? MENU", 0, 127, 0);
+    else
+        DrawF(peak.f);
     DrawNums();
 }
 
@@ -1529,9 +2263,25 @@ static void RenderStill()
     }
 }
 
-static void Render()
+static void ClearScreen()
 {
+#ifdef ENABLE_SPECTRUM_WATERFALL
+    if (waterfallShown && currentState == SPECTRUM)
+    {
+        // Keep the rows, they only scroll
+        const uint8_t end = WATERFALL_LINE + WATERFALL_ROWS / 8;
+        memset(gFrameBuffer, 0, WATERFALL_LINE * sizeof(gFrameBuffer[0]));
+        memset(gFrameBuffer[end], 0, (FRAME_LINES - end) * sizeof(gFrameBuffer[0]));
+        return;
+    }
+    waterfallShown = false;
+#endif
     UI_DisplayClear();
+}
+
+static void Render()
+{
+    ClearScreen();
 
     switch (currentState)
     {
@@ -1564,9 +2314,32 @@ static bool HandleUserInput()
     }
     else
     {
+        // SIDE1 blacklists the peak when let go, a hold asks to clear all
+        if (kbd.prev == KEY_SIDE1 && currentState == SPECTRUM && kbd.counter >= 3 && !side1Held)
+        {
+            if (clearPending)
+            {
+                clearPending = false;
+                redrawScreen = true;
+            }
+            else
+                Blacklist();
+        }
+        side1Held = false;
         kbd.counter = 0;
     }
 
+    if (kbd.current == KEY_SIDE1 && currentState == SPECTRUM)
+    {
+        if (kbd.counter == 16 && !side1Held)
+        {
+            side1Held = true;
+            clearPending = true;
+            redrawScreen = true;
+        }
+        return true;
+    }
+
     if (kbd.counter == 3 || kbd.counter == 16)
     {
         switch (currentState)
@@ -1586,29 +2359,124 @@ static bool HandleUserInput()
     return true;
 }
 
-static void Scan()
+static void TuneAhead()
 {
-    if (rssiHistory[scanInfo.i] != RSSI_MAX_VALUE
 #ifdef ENABLE_SCAN_RANGES
-        && !IsBlacklisted(scanInfo.i)
+    // The next block starts with a coarse reading
+    if (((scanInfo.i + 1) & (coarseFactor - 1)) == 0 && coarseFactor > 1)
+        return;
 #endif
-    )
+    if (scanInfo.i >= scanInfo.measurementsCount)
+        return;
+
+    uint32_t f = scanInfo.f + scanInfo.scanStep;
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+        f = SegmentFreq(scanInfo.i + 1);
+#endif
+    if (!IsBlacklisted(f))
+    {
+        SetF(f);
+        tunedAhead = true;
+    }
+}
+
+static void Scan()
+{
+    if (IsBlacklisted(scanInfo.f))
+    {
+        // Merged bins keep the readings of their other steps
+        if (scanInfo.measurementsCount <= 128 && scanInfo.i < ARRAY_SIZE(rssiHistory))
+            rssiHistory[scanInfo.i] = RSSI_MAX_VALUE;
+    }
+    else
     {
-        SetF(scanInfo.f);
+        if (!tunedAhead || fMeasure != scanInfo.f)
+        {
+            SetF(scanInfo.f);
+        }
+        tunedAhead = false;
+
         Measure();
+        TuneAhead();
         UpdateScanInfo();
     }
 }
 
+#ifdef ENABLE_SCAN_RANGES
+static bool IsCoarseHot(uint16_t rssi)
+{
+    return coarseFloor == RSSI_MAX_VALUE ||
+           rssi >= coarseFloor + COARSE_MARGIN ||
+           rssi + COARSE_MARGIN >= settings.rssiTriggerLevel;
+}
+
+// One block: scanInfo.i/f at its first step on entry, at its last step on return
+static void ScanCoarse()
+{
+    const uint16_t first = scanInfo.i;
+    const uint32_t fFirst = scanInfo.f;
+    const uint16_t count = MIN(coarseFactor, scanInfo.measurementsCount - first + 1);
+
+    BK4819_WriteRegister(BK4819_REG_43, COARSE_BW_REG);
+    coarsePass = true;
+    SetF(fFirst + (count - 1) * scanInfo.scanStep / 2);
+    const uint16_t rssi = GetRssi();
+    coarsePass = false;
+    BK4819_WriteRegister(BK4819_REG_43, GetBWRegValueForScan());
+
+    if (rssi < coarseFloorNext)
+        coarseFloorNext = rssi;
+
+    if (IsCoarseHot(rssi))
+    {
+        for (uint16_t k = 0; k < count; k++)
+        {
+            scanInfo.i = first + k;
+            scanInfo.f = fFirst + k * scanInfo.scanStep;
+            Scan();
+        }
+        return;
+    }
+
+    const uint16_t level = rssi > coarsePenalty ? rssi - coarsePenalty : 0;
+    for (uint16_t k = 0; k < count; k++)
+    {
+        if (!IsBlacklisted(fFirst + k * scanInfo.scanStep))
+            SetRssiHistory(first + k, level);
+    }
+
+    scanInfo.rssi = level;
+    scanInfo.i = first + count / 2;
+    scanInfo.f = fFirst + count / 2 * scanInfo.scanStep;
+    UpdateScanInfo();
+
+    scanInfo.i = first + count - 1;
+    scanInfo.f = fFirst + (count - 1) * scanInfo.scanStep;
+}
+#endif
+
 static void NextScanStep()
 {
     ++peak.t;
     ++scanInfo.i;
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+    {
+        scanInfo.f = SegmentFreq(scanInfo.i);
+        return;
+    }
+#endif
     scanInfo.f += scanInfo.scanStep;
 }
 
 static void UpdateScan()
 {
+#ifdef ENABLE_SCAN_RANGES
+    if (coarseFactor > 1)
+        ScanCoarse();
+    else
+#endif
     Scan();
 
     if (scanInfo.i < scanInfo.measurementsCount)
@@ -1624,6 +2492,26 @@ static void UpdateScan()
     redrawScreen = true;
     preventKeypress = false;
 
+#ifdef ENABLE_SCAN_RANGES
+    if (coarseFactor > 1)
+        coarseFloor = coarseFloorNext;
+#endif
+#ifdef ENABLE_SPECTRUM_TRACES
+    UpdateTraces();
+    AutoTriggerLevel();
+#endif
+#ifdef ENABLE_SPECTRUM_WATERFALL
+    WaterfallBegin();
+#endif
+#ifdef ENABLE_SPECTRUM_STREAM
+    uint32_t binStep = (uint32_t)scanInfo.measurementsCount * scanInfo.scanStep / GetDisplayBins();
+#ifdef ENABLE_SPECTRUM_SEGMENTS
+    if (segmentsOn)
+        binStep = 0;    // not evenly spaced
+#endif
+    SWEEPSTREAM_Send(GetFStart(), binStep, rssiHistory, GetDisplayBins(), dBmCorrTable[gRxVfo->Band]);
+#endif
+
     UpdatePeakInfo();
     if (IsPeakOverLevel())
     {
@@ -1708,7 +2596,9 @@ static void Tick()
         gNextTimeslice = false;
         if (settings.modulationType == MODULATION_AM && !lockAGC)
         {
+            BK4819_PROFILE_BEGIN(BK4819_CALLER_AM_FIX);
             AM_fix_10ms(vfo); // allow AM_Fix to apply its AGC action
+            BK4819_PROFILE_END();
         }
     }
 #endif
@@ -1736,6 +2626,10 @@ static void Tick()
     }
 #endif
 
+#ifdef ENABLE_SPECTRUM_STREAM
+    SWEEPSTREAM_Pump();
+#endif
+
     if (!preventKeypress)
     {
         HandleUserInput();
@@ -1777,6 +2671,13 @@ static void Tick()
     }
 }
 
+static void Step()
+{
+    BK4819_PROFILE_BEGIN(BK4819_CALLER_SPECTRUM);
+    Tick();
+    BK4819_PROFILE_END();
+}
+
 void APP_RunSpectrum()
 {
     // TX here coz it always? set to active VFO
@@ -1784,6 +2685,7 @@ void APP_RunSpectrum()
 #ifdef ENABLE_FEAT_F4HWN_SPECTRUM
     LoadSettings();
 #endif
+    BLACKLIST_Load();
     // set the current frequency in the middle of the display
 #ifdef ENABLE_SCAN_RANGES
     if (gScanRangeStart)
@@ -1815,7 +2717,14 @@ void APP_RunSpectrum()
         SETTINGS_WriteCurrentState();
     #endif
 
+#if defined(ENABLE_SPECTRUM_TRACES) || defined(ENABLE_SPECTRUM_WATERFALL)
+    // Returned on exit; flash writes through the cache are refused until then
+    scratch = PY25Q16_BorrowSectorCache();
+#endif
+
     BackupRegisters();
+    rxChainReg = BK4819_ReadRegister(BK4819_REG_30);
+    InitSettle();
 
     isListening = true; // to turn off RX later
     redrawStatus = true;
@@ -1837,8 +2746,12 @@ void APP_RunSpectrum()
 
     isInitialized = true;
 
+#ifdef ENABLE_BACKGROUND_TASKS
+    TASK_RunApp(Step, &isInitialized);
+#else
     while (isInitialized)
     {
-        Tick();
+        Step();
     }
+#endif
 }
\ No newline at end of file
@@ -145,6 +145,20 @@ typedef enum ScanStep
     S_STEP_100_0kHz,
 } ScanStep;
 
+typedef enum SpectrumView
+{
+    VIEW_LIVE,
+#ifdef ENABLE_SPECTRUM_TRACES
+    VIEW_AVERAGE,
+    VIEW_MAX_HOLD,
+    VIEW_MIN_HOLD,
+#endif
+#ifdef ENABLE_SPECTRUM_WATERFALL
+    VIEW_WATERFALL,
+#endif
+    VIEW_COUNT,
+} SpectrumView;
+
 typedef struct SpectrumSettings
 {
     uint32_t frequencyChangeStep;
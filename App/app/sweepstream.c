@@ -0,0 +1,311 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+/**
+ * -----------------------------------
+ * Spectrum sweep stream
+ *
+ *    The host asks for sweeps with 'S' 'W' mode ~mode, repeated at least
+ *    every second, on the UART or the USB VCP; frames go back on the port
+ *    the last request came from and stop two seconds after it.
+ *
+ *    Frames use the screenshot framing (see screenshot.c) with type 0x03:
+ *
+ *      AA 55 03 <size, big endian> SweepHeader_t <data> 0A
+ *
+ *    Key frames carry the readings as is, 8 bit or 9 bit packed LSB first.
+ *    Delta frames carry a nibble per bin, low nibble first: 0..14 is the
+ *    zigzag coded change -7..7 from the previous frame, 15 is followed by
+ *    the reading in 2 (8 bit) or 3 (9 bit) nibbles. A delta is only sent
+ *    when it is smaller, and a key frame at least every KEY_INTERVAL frames.
+ *
+ *    Nothing waits on the port: VCP frames go out by DMA, UART frames are
+ *    fed a byte at a time by SWEEPSTREAM_Pump(), and a sweep that ends while
+ *    the last frame is still going out is dropped. A command reply on the
+ *    UART waits for the rest of the frame (SWEEPSTREAM_Flush()).
+ * ------------------------------------
+ */
+
+#include <string.h>
+
+#include "app/sweepstream.h"
+#include "app/uart.h"
+#include "driver/systick.h"
+#if defined(ENABLE_UART)
+    #include "driver/uart.h"
+#endif
+#if defined(ENABLE_USB)
+    #include "driver/vcp.h"
+#endif
+
+#define FRAME_TYPE 0x03 // After the screenshot types
+#define MAX_BINS 128
+#define MAX_DATA ((MAX_BINS * 9 + 7) / 8)
+#define KEY_INTERVAL 16
+#define TIMEOUT_10ms 200
+
+_Static_assert(sizeof(SweepHeader_t) == 16, "sweep header size");
+
+static uint8_t Frame[5 + sizeof(SweepHeader_t) + MAX_DATA + 1];
+static uint16_t FrameSize;
+static uint16_t FrameSent;
+
+static bool Active;
+static uint8_t Mode;
+static uint8_t Port;
+static uint32_t RequestTime;
+
+// Readings of the last frame, what a delta is taken against
+static uint16_t Prev[MAX_BINS];
+static SweepHeader_t PrevHeader; // Count 0: none
+static uint8_t SinceKey;
+
+#if defined(ENABLE_UART)
+static uint16_t UartRead;
+#endif
+#if defined(ENABLE_USB)
+static uint16_t VcpRead;
+#endif
+
+// Looks through what arrived in the receive ring since *pRead, leaving it
+// as is for the command parser. A request cut short waits for the rest.
+static bool FindRequest(const uint8_t *pBuf, uint16_t BufSize, uint16_t Write, uint16_t *pRead)
+{
+    bool Found = false;
+
+    while ((Write + BufSize - *pRead) % BufSize >= 4)
+    {
+        const uint16_t i = *pRead;
+        const uint8_t Request = pBuf[(i + 2) % BufSize];
+
+        if ('S' == pBuf[i] && 'W' == pBuf[(i + 1) % BufSize] && 0xff == (Request ^ pBuf[(i + 3) % BufSize]) &&
+            !(Request & ~(SWEEPSTREAM_9BIT | SWEEPSTREAM_DELTA)))
+        {
+            if (!Active || Request != Mode)
+            {
+                PrevHeader.Count = 0;
+            }
+            Mode = Request;
+            Found = true;
+            *pRead = (i + 4) % BufSize;
+        }
+        else
+        {
+            *pRead = (i + 1) % BufSize;
+        }
+    }
+
+    return Found;
+}
+
+static bool Poll(void)
+{
+#if defined(ENABLE_UART)
+    if (FindRequest(UART_DMA_Buffer, sizeof(UART_DMA_Buffer), UART_GetRxIndex(), &UartRead))
+    {
+        Port = UART_PORT_UART;
+        RequestTime = gGlobalSysTickCounter;
+        Active = true;
+    }
+#endif
+#if defined(ENABLE_USB)
+    if (FindRequest(VCP_RxBuf, sizeof(VCP_RxBuf), VCP_RxBufPointer, &VcpRead))
+    {
+        Port = UART_PORT_VCP;
+        RequestTime = gGlobalSysTickCounter;
+        Active = true;
+    }
+#endif
+
+    if (Active && gGlobalSysTickCounter - RequestTime > TIMEOUT_10ms)
+    {
+        Active = false;
+    }
+
+    return Active;
+}
+
+static inline uint16_t Reading(uint16_t Rssi, uint8_t Bits)
+{
+    // Above 9 bits: no reading (blacklisted)
+    if (Rssi > 0x1ff)
+        return 0;
+    return Rssi >> (9 - Bits);
+}
+
+static uint16_t EncodeKey(uint8_t *pOut, const uint16_t *pRssi, uint16_t Count, uint8_t Bits)
+{
+    uint32_t Acc = 0;
+    uint8_t Held = 0;
+    uint16_t Size = 0;
+
+    for (uint16_t i = 0; i < Count; i++)
+    {
+        Acc |= (uint32_t)Reading(pRssi[i], Bits) << Held;
+        Held += Bits;
+        while (Held >= 8)
+        {
+            pOut[Size++] = Acc;
+            Acc >>= 8;
+            Held -= 8;
+        }
+    }
+
+    if (Held)
+    {
+        pOut[Size++] = Acc;
+    }
+
+    return Size;
+}
+
+// 0 when it would take more than Max bytes
+static uint16_t EncodeDelta(uint8_t *pOut, const uint16_t *pRssi, uint16_t Count, uint8_t Bits, uint16_t Max)
+{
+    uint16_t Nibbles = 0;
+
+    for (uint16_t i = 0; i < Count; i++)
+    {
+        const uint16_t Value = Reading(pRssi[i], Bits);
+        const int16_t Delta = Value - Prev[i];
+        uint32_t Code;
+        uint8_t Length;
+
+        if (Delta >= -7 && Delta <= 7)
+        {
+            Code = Delta < 0 ? -2 * Delta - 1 : 2 * Delta;
+            Length = 1;
+        }
+        else
+        {
+            Code = 15 | (uint32_t)Value << 4;
+            Length = 1 + (Bits + 3) / 4;
+        }
+
+        if (Nibbles + Length > Max * 2)
+        {
+            return 0;
+        }
+
+        for (; Length; Length--, Code >>= 4, Nibbles++)
+        {
+            if (Nibbles & 1)
+                pOut[Nibbles / 2] |= (Code & 15) << 4;
+            else
+                pOut[Nibbles / 2] = Code & 15;
+        }
+    }
+
+    return (Nibbles + 1) / 2;
+}
+
+void SWEEPSTREAM_Send(uint32_t Start, uint32_t Step, const uint16_t *pRssi, uint16_t Count, int8_t DbmCorr)
+{
+    if (!Poll() || FrameSent < FrameSize)
+    {
+        return;
+    }
+
+#if defined(ENABLE_USB)
+    if (UART_PORT_VCP == Port && VCP_IsSending())
+    {
+        return;
+    }
+#endif
+
+    if (Count > MAX_BINS)
+    {
+        Count = MAX_BINS;
+    }
+
+    // Frame + 5 is not word aligned, the header is copied in
+    SweepHeader_t Header;
+    uint8_t *pData = Frame + 5 + sizeof(Header);
+    const uint8_t Bits = (Mode & SWEEPSTREAM_9BIT) ? 9 : 8;
+    uint16_t Size = 0;
+
+    if ((Mode & SWEEPSTREAM_DELTA) && SinceKey < KEY_INTERVAL - 1 && PrevHeader.Count == Count &&
+        PrevHeader.Start == Start && PrevHeader.Step == Step)
+    {
+        Size = EncodeDelta(pData, pRssi, Count, Bits, (Count * Bits + 7) / 8 - 1);
+    }
+
+    memset(&Header, 0, sizeof(Header));
+    Header.Start = Start;
+    Header.Step = Step;
+    Header.Count = Count;
+    Header.Flags = Mode & SWEEPSTREAM_9BIT;
+    Header.Seq = PrevHeader.Seq + 1;
+    Header.DbmCorr = DbmCorr;
+
+    if (Size)
+    {
+        Header.Flags |= SWEEPSTREAM_DELTA;
+        SinceKey++;
+    }
+    else
+    {
+        Size = EncodeKey(pData, pRssi, Count, Bits);
+        SinceKey = 0;
+    }
+
+    for (uint16_t i = 0; i < Count; i++)
+    {
+        Prev[i] = Reading(pRssi[i], Bits);
+    }
+    PrevHeader = Header;
+
+    memcpy(Frame + 5, &Header, sizeof(Header));
+    Size += sizeof(Header);
+    Frame[0] = 0xAA;
+    Frame[1] = 0x55;
+    Frame[2] = FRAME_TYPE;
+    Frame[3] = Size >> 8;
+    Frame[4] = Size & 0xff;
+    Frame[5 + Size] = 0x0A;
+    FrameSize = 5 + Size + 1;
+    FrameSent = 0;
+
+#if defined(ENABLE_USB)
+    if (UART_PORT_VCP == Port)
+    {
+        VCP_SendAsync(Frame, FrameSize);
+        FrameSent = FrameSize;
+        return;
+    }
+#endif
+
+    SWEEPSTREAM_Pump();
+}
+
+void SWEEPSTREAM_Pump(void)
+{
+#if defined(ENABLE_UART)
+    if (FrameSent < FrameSize)
+    {
+        FrameSent += UART_TrySend(Frame + FrameSent, FrameSize - FrameSent);
+    }
+#endif
+}
+
+// Finishes the UART frame going out, so that other output can follow
+void SWEEPSTREAM_Flush(void)
+{
+#if defined(ENABLE_UART)
+    if (FrameSent < FrameSize)
+    {
+        UART_Send(Frame + FrameSent, FrameSize - FrameSent);
+        FrameSent = FrameSize;
+    }
+#endif
+}
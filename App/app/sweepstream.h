@@ -0,0 +1,39 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef APP_SWEEPSTREAM_H
+#define APP_SWEEPSTREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Request modes, also the header flags
+#define SWEEPSTREAM_9BIT  0x01 // 9 bit readings, else 8 bit (1 dB)
+#define SWEEPSTREAM_DELTA 0x02 // Frames may be deltas against the previous one
+
+typedef struct
+{
+    uint32_t Start;       // 10 Hz units, first bin
+    uint32_t Step;        // 10 Hz units, bin width; 0: uneven (spectrum segments)
+    uint16_t Count;       // Bins
+    uint8_t  Flags;       // SWEEPSTREAM_*
+    uint8_t  Seq;         // Frame counter, a delta only follows Seq - 1
+    int8_t   DbmCorr;     // dBm = reading / 2 - 160 + DbmCorr (9 bit)
+    uint8_t  Reserved[3];
+} SweepHeader_t;
+
+void SWEEPSTREAM_Send(uint32_t Start, uint32_t Step, const uint16_t *pRssi, uint16_t Count, int8_t DbmCorr);
+void SWEEPSTREAM_Pump(void);
+void SWEEPSTREAM_Flush(void);
+
+#endif
@@ -23,14 +23,24 @@
 #ifdef ENABLE_FMRADIO
     #include "app/fm.h"
 #endif
+#ifdef ENABLE_SPECTRUM_STREAM
+    #include "app/sweepstream.h"
+#endif
 #include "app/uart.h"
 #include "board.h"
+#include "chstore.h"
 #include "py32f071_ll_dma.h"
 #include "driver/backlight.h"
 #include "driver/bk4819.h"
+#ifdef ENABLE_BK4819_PROFILE
+    #include "driver/bk4819_profile.h"
+#endif
 #include "driver/crc.h"
 #include "driver/eeprom.h"
 #include "driver/gpio.h"
+#include "driver/py25q16.h"
+#include "driver/py25q16_journal.h"
+#include "driver/systick.h"
 
 #if defined(ENABLE_UART)
 #include "driver/uart.h"
@@ -41,8 +51,17 @@
 #endif
 
 #include "functions.h"
+#ifdef ENABLE_HEARD_LOG
+    #include "heardlog.h"
+#endif
 #include "misc.h"
+#ifdef ENABLE_SCAN_PLAN
+    #include "scanplan.h"
+#endif
 #include "settings.h"
+#ifdef ENABLE_BACKGROUND_TASKS
+    #include "task.h"
+#endif
 #include "version.h"
 
 #if defined(ENABLE_OVERLAY)
@@ -59,6 +78,7 @@
 
 // !! Make sure this is correct!
 #define MAX_REPLY_SIZE 144
+#define VCP_REPLY_WAIT_US 20000
 
 typedef struct {
     uint16_t ID;
@@ -120,6 +140,25 @@ typedef struct {
     } Data;
 } REPLY_051D_t;
 
+#ifdef ENABLE_HEARD_LOG
+typedef struct {
+    Header_t Header;
+    uint16_t Index;
+    uint16_t Padding;
+} CMD_0620_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t      Index;
+        uint16_t      Total;
+        uint8_t       Count;
+        uint8_t       Padding[3];
+        HeardRecord_t Records[8];
+    } Data;
+} REPLY_0620_t;
+#endif
+
 #ifdef ENABLE_EXTRA_UART_CMD
 typedef struct {
     Header_t Header;
@@ -201,6 +240,17 @@ static void SendReply_VCP(void *pReply, uint16_t Size)
         return;
     }
 
+    // The endpoint may still be sending the last reply or a sweep frame
+    // (sweepstream.c): wait for it, not forever if the host stopped reading
+    const uint32_t Start = SYSTICK_GetUs();
+    while (VCP_IsSending())
+    {
+        if (SYSTICK_GetUs() - Start > VCP_REPLY_WAIT_US)
+        {
+            return;
+        }
+    }
+
     memcpy(VCP_ReplyBuf + sizeof(Header_t), pReply, Size);
 
     Header_t *pHeader = (Header_t *)VCP_ReplyBuf;
@@ -263,6 +313,11 @@ static void SendReply(uint32_t Port, void *pReply, uint16_t Size)
     Header.ID = 0xCDAB;
     Header.Size = Size;
 
+#ifdef ENABLE_SPECTRUM_STREAM
+    // Not into the middle of a sweep frame
+    SWEEPSTREAM_Flush();
+#endif
+
     UART_Send(&Header, sizeof(Header));
     UART_Send(pReply, Size);
 
@@ -469,6 +524,13 @@ static void CMD_051D(uint32_t Port, const uint8_t *pBuffer)
             }
         }
 
+        // channel records may have changed under the read window
+        CHSTORE_Invalidate();
+#ifdef ENABLE_SCAN_PLAN
+        // and so may the calibration behind the scan plans
+        SCANPLAN_Invalidate();
+#endif
+
         if (bReloadEeprom)
             SETTINGS_InitEEPROM();
     }
@@ -638,6 +700,162 @@ static void CMD_0602_WriteBK4819Reg(const uint8_t *pBuffer)
 }
 #endif
 
+#ifdef ENABLE_BK4819_PROFILE
+// BK4819 bus profile, 128 bytes at a time; the pages are not one snapshot
+static void CMD_0603_ReadBK4819Profile(uint32_t Port, const uint8_t *pBuffer)
+{
+    typedef struct __attribute__((__packed__)) {
+        Header_t header;
+        uint16_t offset;
+        uint8_t reset;  // clear the profile once its last page is sent
+    } CMD_0603_t;
+
+    const CMD_0603_t *cmd = (const CMD_0603_t *) pBuffer;
+
+    struct __attribute__((__packed__)) {
+        Header_t header;
+        struct __attribute__((__packed__)) {
+            uint16_t offset;
+            uint16_t total;
+            uint8_t bytes[128];
+        } data;
+    } reply;
+
+    const uint16_t total = sizeof(gBK4819_Profile);
+    const uint16_t offset = cmd->offset < total ? cmd->offset : total;
+    const uint16_t size = MIN(total - offset, sizeof(reply.data.bytes));
+
+    memset(&reply, 0, sizeof(reply));
+    reply.header.ID = 0x0603;
+    reply.header.Size = sizeof(reply.data);
+    reply.data.offset = offset;
+    reply.data.total = total;
+    memcpy(reply.data.bytes, (const uint8_t *)&gBK4819_Profile + offset, size);
+    SendReply(Port, &reply, sizeof(reply));
+
+    // only after the last page, a stray or retried request for an earlier
+    // one must not lose the counts the host has yet to read
+    if (cmd->reset && offset + size == total)
+        BK4819_ProfileReset();
+}
+#endif
+
+#ifdef ENABLE_BACKGROUND_TASKS
+// Time used by the cooperative tasks
+static void CMD_0604_ReadTaskStats(uint32_t Port, const uint8_t *pBuffer)
+{
+    typedef struct __attribute__((__packed__)) {
+        Header_t header;
+        uint8_t reset;  // clear the stats once sent
+    } CMD_0604_t;
+
+    const CMD_0604_t *cmd = (const CMD_0604_t *) pBuffer;
+
+    struct __attribute__((__packed__)) {
+        Header_t header;
+        TASK_Stats_t stats;
+    } reply;
+
+    reply.header.ID = 0x0604;
+    reply.header.Size = sizeof(reply.stats);
+    memcpy(&reply.stats, &gTASK_Stats, sizeof(reply.stats));
+    SendReply(Port, &reply, sizeof(reply));
+
+    if (cmd->reset)
+        TASK_ResetStats();
+}
+#endif
+
+#ifdef ENABLE_UART_BENCHMARK
+static void CMD_0610_BenchmarkFlash(uint32_t Port)
+{
+    struct __attribute__((__packed__)) {
+        Header_t header;
+        PY25Q16_Benchmark_t data;
+    } reply;
+
+    PY25Q16_Benchmark_t result;
+
+    PY25Q16_Benchmark(&result);
+    reply.header.ID = 0x0610;
+    reply.header.Size = sizeof(reply.data);
+    reply.data = result;
+    SendReply(Port, &reply, sizeof(reply));
+}
+
+static void CMD_0611_BootProfile(uint32_t Port)
+{
+    struct __attribute__((__packed__)) {
+        Header_t header;
+        BootProfile_t data;
+    } reply;
+
+    reply.header.ID = 0x0611;
+    reply.header.Size = sizeof(reply.data);
+    reply.data = gBootProfile;
+    SendReply(Port, &reply, sizeof(reply));
+}
+
+static void CMD_0612_BK4819WriteStats(uint32_t Port)
+{
+    struct __attribute__((__packed__)) {
+        Header_t header;
+        BK4819_WriteStats_t data;
+    } reply;
+
+    reply.header.ID = 0x0612;
+    reply.header.Size = sizeof(reply.data);
+    reply.data = gBK4819_WriteStats;
+    SendReply(Port, &reply, sizeof(reply));
+}
+
+static void CMD_0613_BenchmarkBK4819(uint32_t Port)
+{
+    struct __attribute__((__packed__)) {
+        Header_t header;
+        BK4819_Benchmark_t data;
+    } reply;
+
+    BK4819_Benchmark_t result;
+
+    BK4819_Benchmark(&result);
+    reply.header.ID = 0x0613;
+    reply.header.Size = sizeof(reply.data);
+    reply.data = result;
+    SendReply(Port, &reply, sizeof(reply));
+}
+
+static void CMD_0614_RetuneStats(uint32_t Port)
+{
+    struct __attribute__((__packed__)) {
+        Header_t header;
+        RADIO_RetuneStats_t data;
+    } reply;
+
+    reply.header.ID = 0x0614;
+    reply.header.Size = sizeof(reply.data);
+    reply.data = gRadioRetuneStats;
+    SendReply(Port, &reply, sizeof(reply));
+}
+#endif
+
+#ifdef ENABLE_HEARD_LOG
+// read heard log, oldest record first
+static void CMD_0620_ReadHeardLog(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_0620_t *pCmd = (const CMD_0620_t *)pBuffer;
+    REPLY_0620_t      Reply;
+
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Header.ID   = 0x0620;
+    Reply.Header.Size = sizeof(Reply.Data);
+    Reply.Data.Index  = pCmd->Index;
+    Reply.Data.Total  = HEARDLOG_Count();
+    Reply.Data.Count  = HEARDLOG_Read(pCmd->Index, Reply.Data.Records, ARRAY_SIZE(Reply.Data.Records));
+    SendReply(Port, &Reply, sizeof(Reply));
+}
+#endif
+
 bool UART_IsCommandAvailable(uint32_t Port)
 {
     uint16_t Index;
@@ -763,6 +981,48 @@ bool UART_IsCommandAvailable(uint32_t Port)
     return CRC_Calculate(pUART_Command->Buffer, Size) == Crc;
 }
 
+#ifdef ENABLE_BACKGROUND_TASKS
+// The command waiting in Port's buffer only reads, and nothing a running
+// app owns: no flash writes, BK4819, backlight or VFO changes
+bool UART_IsAppSafeCommand(uint32_t Port)
+{
+    const UART_Command_t *pUART_Command;
+
+    if (0) {}
+#if defined(ENABLE_UART)
+    else if (Port == UART_PORT_UART)
+    {
+        pUART_Command = &UART_Command;
+    }
+#endif
+#if defined(ENABLE_USB)
+    else if (Port == UART_PORT_VCP)
+    {
+        pUART_Command = &VCP_Command;
+    }
+#endif
+    else
+    {
+        return false;
+    }
+
+    switch (pUART_Command->Header.ID)
+    {
+        case 0x051B: // EEPROM read
+        case 0x0603:
+        case 0x0604:
+#ifdef ENABLE_UART_BENCHMARK
+        case 0x0611:
+        case 0x0612:
+        case 0x0614:
+#endif
+        case 0x0620:
+            return true;
+    }
+    return false;
+}
+#endif
+
 void UART_HandleCommand(uint32_t Port)
 {
     UART_Command_t *pUART_Command;
@@ -826,6 +1086,10 @@ void UART_HandleCommand(uint32_t Port)
 #endif
 
         case 0x05DD: // reset
+            JOURNAL_FlushAll();
+            #ifdef ENABLE_HEARD_LOG
+                HEARDLOG_Flush();
+            #endif
             #if defined(ENABLE_OVERLAY)
                 overlay_FLASH_RebootToBootloader();
             #else
@@ -842,6 +1106,46 @@ void UART_HandleCommand(uint32_t Port)
             CMD_0602_WriteBK4819Reg(pUART_Command->Buffer);
             break;
 #endif
+
+#ifdef ENABLE_BK4819_PROFILE
+        case 0x0603:
+            CMD_0603_ReadBK4819Profile(Port, pUART_Command->Buffer);
+            break;
+#endif
+
+#ifdef ENABLE_BACKGROUND_TASKS
+        case 0x0604:
+            CMD_0604_ReadTaskStats(Port, pUART_Command->Buffer);
+            break;
+#endif
+
+#ifdef ENABLE_UART_BENCHMARK
+        case 0x0610:
+            CMD_0610_BenchmarkFlash(Port);
+            break;
+
+        case 0x0611:
+            CMD_0611_BootProfile(Port);
+            break;
+
+        case 0x0612:
+            CMD_0612_BK4819WriteStats(Port);
+            break;
+
+        case 0x0613:
+            CMD_0613_BenchmarkBK4819(Port);
+            break;
+
+        case 0x0614:
+            CMD_0614_RetuneStats(Port);
+            break;
+#endif
+
+#ifdef ENABLE_HEARD_LOG
+        case 0x0620:
+            CMD_0620_ReadHeardLog(Port, pUART_Command->Buffer);
+            break;
+#endif
     } // switch
 
     #ifdef ENABLE_FEAT_F4HWN_SCREENSHOT
@@ -19,6 +19,7 @@
 #define APP_UART_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 enum
 {
@@ -32,6 +33,9 @@ enum
 
 bool UART_IsCommandAvailable(uint32_t Port);
 void UART_HandleCommand(uint32_t Port);
+#ifdef ENABLE_BACKGROUND_TASKS
+bool UART_IsAppSafeCommand(uint32_t Port);
+#endif
 
 #endif
 
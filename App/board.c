@@ -36,6 +36,7 @@
 #include "driver/flash.h"
 #include "driver/gpio.h"
 #include "driver/system.h"
+#include "driver/systick.h"
 #include "driver/st7565.h"
 #include "frequencies.h"
 #include "helper/battery.h"
@@ -182,7 +183,7 @@ void BOARD_Init(void)
 #ifdef ENABLE_VOICE
     VOICE_Init();
 #endif
-    PY25Q16_Init();
+    BOOT_PROFILE(PY25Q16_Init, PY25Q16_Init());
     ST7565_Init();
 #ifdef ENABLE_FMRADIO
     BK1080_Init0();
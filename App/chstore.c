@@ -0,0 +1,211 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+/**
+ * -----------------------------------
+ * Channel store
+ *
+ *    Zone 0 is the classic layout: records at 0x000000, attributes at
+ *    0x002000 and names at 0x00e000, as seen through eeprom_compat.c.
+ *
+ *    Zones 1.. are pages of the store at CHSTORE_ADDR, two sectors each:
+ *
+ *      +0x0000  records, 16 bytes per channel
+ *      +0x0c80  index: one ChannelAttributes_t (band + scan lists) per channel
+ *      +0x1000  names, 16 bytes per channel
+ *
+ *    Only the index of the selected zone is held in RAM (gMR_ChannelAttributes),
+ *    which is all channel search and scanning look at. Records are read through
+ *    a small window of neighbouring channels; the window after it is fetched
+ *    in the background (PY25Q16_ReadAsync), as scans and searches walk the
+ *    channels in order.
+ * ------------------------------------
+ */
+
+#include <string.h>
+
+#include "chstore.h"
+#include "driver/py25q16.h"
+#include "settings.h"
+
+#define CHSTORE_ADDR 0x048000
+#define ZONE_SIZE 0x2000
+#define RECORD_SIZE 0x10
+#define INDEX_OFFSET 0x0c80
+#define NAMES_OFFSET 0x1000
+
+#define WINDOW_CHANNELS 8
+#define WINDOW_NONE 0xffff
+
+_Static_assert(CHSTORE_ZONE_CHANNELS * RECORD_SIZE <= INDEX_OFFSET, "channel store records");
+_Static_assert(CHSTORE_ZONE_CHANNELS % WINDOW_CHANNELS == 0, "channel store window");
+
+// Global number of the first channel in Window
+static uint16_t WindowFirst = WINDOW_NONE;
+static uint8_t Window[WINDOW_CHANNELS * RECORD_SIZE];
+
+// Read ahead of the next window, Ahead holds it once AheadBusy is clear
+static uint16_t AheadFirst = WINDOW_NONE;
+static uint8_t Ahead[sizeof(Window)];
+static volatile bool AheadBusy;
+
+static inline uint8_t Zone(void)
+{
+#ifdef ENABLE_CHANNEL_ZONES
+    return gEeprom.CHANNEL_ZONE;
+#else
+    return 0;
+#endif
+}
+
+static inline uint32_t ZoneAddr(void)
+{
+    return CHSTORE_ADDR + (Zone() - 1) * ZONE_SIZE;
+}
+
+uint32_t CHSTORE_RecordAddr(uint8_t Channel)
+{
+    return Zone() ? ZoneAddr() + Channel * RECORD_SIZE : Channel * RECORD_SIZE;
+}
+
+uint32_t CHSTORE_NameAddr(uint8_t Channel)
+{
+    return Zone() ? ZoneAddr() + NAMES_OFFSET + Channel * 16 : 0x00e000 + Channel * 16;
+}
+
+uint32_t CHSTORE_AttributeAddr(uint8_t Channel)
+{
+    // VFO attributes always live in zone 0
+    return (Zone() && IS_MR_CHANNEL(Channel)) ? ZoneAddr() + INDEX_OFFSET + Channel : 0x002000 + Channel;
+}
+
+static void AheadLoaded(__attribute__((unused)) void *pBuffer, __attribute__((unused)) uint32_t Size)
+{
+    AheadBusy = false;
+}
+
+static void ReadAhead(uint8_t First)
+{
+    if (First >= CHSTORE_ZONE_CHANNELS || AheadBusy)
+    {
+        return;
+    }
+
+    AheadFirst = Zone() * CHSTORE_ZONE_CHANNELS + First;
+    AheadBusy = true;
+    if (!PY25Q16_ReadAsync(CHSTORE_RecordAddr(First), Ahead, sizeof(Ahead), AheadLoaded))
+    {
+        AheadFirst = WINDOW_NONE;
+        AheadBusy = false;
+    }
+}
+
+void CHSTORE_ReadRecord(uint8_t Channel, uint8_t Offset, void *pBuffer, uint8_t Size)
+{
+    const uint8_t First = Channel - (Channel % WINDOW_CHANNELS);
+    const uint16_t Key = Zone() * CHSTORE_ZONE_CHANNELS + First;
+
+    if (Key != WindowFirst)
+    {
+        if (Key == AheadFirst)
+        {
+            while (AheadBusy)
+                ;
+            memcpy(Window, Ahead, sizeof(Window));
+        }
+        else
+        {
+            PY25Q16_ReadBuffer(CHSTORE_RecordAddr(First), Window, sizeof(Window));
+        }
+        WindowFirst = Key;
+        ReadAhead(First + WINDOW_CHANNELS);
+    }
+
+    memcpy(pBuffer, Window + (Channel - First) * RECORD_SIZE + Offset, Size);
+}
+
+void CHSTORE_WriteRecord(uint8_t Channel, const void *pBuffer)
+{
+    const uint8_t First = Channel - (Channel % WINDOW_CHANNELS);
+
+    PY25Q16_WriteBuffer(CHSTORE_RecordAddr(Channel), pBuffer, RECORD_SIZE, false);
+
+    if (Zone() * CHSTORE_ZONE_CHANNELS + First == WindowFirst)
+    {
+        memcpy(Window + (Channel - First) * RECORD_SIZE, pBuffer, RECORD_SIZE);
+    }
+
+    // The write waited for the read ahead, which may hold the old record
+    if (Zone() * CHSTORE_ZONE_CHANNELS + First == AheadFirst)
+    {
+        AheadFirst = WINDOW_NONE;
+    }
+}
+
+void CHSTORE_LoadAttributes(void)
+{
+    // 0D60..0E27
+    PY25Q16_ReadBuffer(0x002000, gMR_ChannelAttributes, sizeof(gMR_ChannelAttributes));
+    if (Zone())
+    {
+        PY25Q16_ReadBuffer(ZoneAddr() + INDEX_OFFSET, gMR_ChannelAttributes, CHSTORE_ZONE_CHANNELS);
+    }
+
+    for(uint16_t i = 0; i < sizeof(gMR_ChannelAttributes); i++) {
+        ChannelAttributes_t *att = &gMR_ChannelAttributes[i];
+        if(att->__val == 0xff){
+            att->__val = 0;
+            att->band = 0x7;
+        }
+        gMR_ChannelExclude[i] = false;
+    }
+}
+
+void CHSTORE_Invalidate(void)
+{
+    WindowFirst = WINDOW_NONE;
+    AheadFirst = WINDOW_NONE;
+}
+
+uint16_t CHSTORE_Number(uint8_t Channel)
+{
+    // 1 based, across zones
+    return Zone() * CHSTORE_ZONE_CHANNELS + Channel + 1;
+}
+
+#ifdef ENABLE_CHANNEL_ZONES
+void CHSTORE_SetZone(uint8_t Zone)
+{
+    uint8_t State[8];
+
+    gEeprom.CHANNEL_ZONE = Zone < CHSTORE_ZONES ? Zone : 0;
+
+    // 0x1FF8
+    PY25Q16_ReadBuffer(0x00c008, State, sizeof(State));
+    State[0] = gEeprom.CHANNEL_ZONE;
+    PY25Q16_WriteBuffer(0x00c008, State, sizeof(State), true);
+
+    CHSTORE_LoadAttributes();
+    CHSTORE_Invalidate();
+}
+
+void CHSTORE_EraseZones(void)
+{
+    for (uint32_t Addr = CHSTORE_ADDR; Addr < CHSTORE_ADDR + (CHSTORE_ZONES - 1) * ZONE_SIZE; Addr += 0x1000)
+    {
+        PY25Q16_SectorErase(Addr);
+    }
+
+    CHSTORE_Invalidate();
+}
+#endif
@@ -0,0 +1,46 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef CHSTORE_H
+#define CHSTORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "misc.h"
+
+// Memory channels come in zones of CHSTORE_ZONE_CHANNELS; the memory channel
+// slots (MR_CHANNEL_FIRST..MR_CHANNEL_LAST) show the selected zone.
+#define CHSTORE_ZONE_CHANNELS (MR_CHANNEL_LAST + 1)
+
+#ifdef ENABLE_CHANNEL_ZONES
+    #define CHSTORE_ZONES 6
+#else
+    #define CHSTORE_ZONES 1
+#endif
+
+uint32_t CHSTORE_RecordAddr(uint8_t Channel);
+uint32_t CHSTORE_NameAddr(uint8_t Channel);
+uint32_t CHSTORE_AttributeAddr(uint8_t Channel);
+void     CHSTORE_ReadRecord(uint8_t Channel, uint8_t Offset, void *pBuffer, uint8_t Size);
+void     CHSTORE_WriteRecord(uint8_t Channel, const void *pBuffer);
+void     CHSTORE_LoadAttributes(void);
+void     CHSTORE_Invalidate(void);
+uint16_t CHSTORE_Number(uint8_t Channel);
+
+#ifdef ENABLE_CHANNEL_ZONES
+    void CHSTORE_SetZone(uint8_t Zone);
+    void CHSTORE_EraseZones(void);
+#endif
+
+#endif
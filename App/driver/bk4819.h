@@ -63,12 +63,59 @@ enum BK4819_CssScanResult_t
 
 typedef enum BK4819_CssScanResult_t BK4819_CssScanResult_t;
 
+#ifdef ENABLE_UART_BENCHMARK
+    typedef struct
+    {
+        uint32_t Issued; // register writes sent over the bus
+        uint32_t Elided; // skipped, the shadow already held the value
+    } BK4819_WriteStats_t;
+
+    extern BK4819_WriteStats_t gBK4819_WriteStats;
+
+    typedef struct
+    {
+        uint32_t LegacyReads;  // transactions/s with the old 1 us SysTick delays
+        uint32_t LegacyWrites;
+        uint32_t Reads;        // transactions/s with the tuned bus timing
+        uint32_t Writes;
+    } BK4819_Benchmark_t;
+
+    void BK4819_Benchmark(BK4819_Benchmark_t *pResult);
+#endif
+
+// Register sequences, see BK4819_RunSequence()
+enum {
+    BK4819_SEQ_WRITE,   // Register = Value
+    BK4819_SEQ_MODIFY,  // Register = (Register & ~Mask) | Value
+    BK4819_SEQ_DELAY,   // wait Value microseconds
+};
+
+typedef struct
+{
+    uint8_t  Op;
+    uint8_t  Register;
+    uint16_t Mask;
+    uint16_t Value;
+} BK4819_SeqStep_t;
+
+#define BK4819_SEQ_W(Reg, Value)          { BK4819_SEQ_WRITE,  (Reg), 0,      (Value) }
+#define BK4819_SEQ_M(Reg, Mask, Value)    { BK4819_SEQ_MODIFY, (Reg), (Mask), (Value) }
+#define BK4819_SEQ_DELAY_US(Us)           { BK4819_SEQ_DELAY,  0,     0,      (Us) }
+
 // radio is asleep, not listening
 extern bool gRxIdleMode;
 
 void     BK4819_Init(void);
 uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register);
 void     BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data);
+void     BK4819_InvalidateShadow(void);
+void     BK4819_WriteBurst(BK4819_REGISTER_t Register, const uint16_t *pData, uint32_t Count);
+void     BK4819_RunSequence(const BK4819_SeqStep_t *pSteps, uint32_t Count);
+
+// Bumped by every change to a register RADIO_SetupRegisters() programs for RX
+// (filter, squelch, CSS, gains, scramble, VOX, compander, DTMF, AGC) and by a
+// soft reset, whoever writes it
+uint32_t BK4819_GetRxSetupWrites(void);
 void     BK4819_SetRegValue(RegisterSpec s, uint16_t v);
 void     BK4819_WriteU8(uint8_t Data);
 void     BK4819_WriteU16(uint16_t Data);
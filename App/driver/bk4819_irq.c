@@ -0,0 +1,98 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include "py32f071_ll_bus.h"
+#include "py32f071_ll_exti.h"
+#include "py32f071_ll_gpio.h"
+#include "py32f071_ll_system.h"
+
+#include "driver/bk4819_irq.h"
+#include "driver/systick.h"
+
+// BK4819 interrupt output: PB7 (EXTI line 7)
+#define IRQ_PORT        GPIOB
+#define IRQ_PIN         LL_GPIO_PIN_7
+#define IRQ_EXTI_PORT   LL_EXTI_CONFIG_PORTB
+#define IRQ_EXTI_SOURCE LL_EXTI_CONFIG_LINE7
+#define IRQ_EXTI_LINE   LL_EXTI_LINE_7
+
+// Power of two, Head and Tail run free and wrap
+#define QUEUE_SIZE 8
+
+// Single producer (EXTI handler), single consumer (main loop): Head is only
+// written by the handler, Tail only by BK4819_IRQ_Pop()
+static uint32_t Queue[QUEUE_SIZE];
+static volatile uint8_t Head;
+static volatile uint8_t Tail;
+
+void BK4819_IRQ_Init(void)
+{
+    LL_IOP_GRP1_EnableClock(LL_IOP_GRP1_PERIPH_GPIOB);
+    LL_APB1_GRP2_EnableClock(LL_APB1_GRP2_PERIPH_SYSCFG);
+
+    LL_GPIO_SetPinMode(IRQ_PORT, IRQ_PIN, LL_GPIO_MODE_INPUT);
+    LL_GPIO_SetPinPull(IRQ_PORT, IRQ_PIN, LL_GPIO_PULL_NO);
+
+    LL_EXTI_SetEXTISource(IRQ_EXTI_PORT, IRQ_EXTI_SOURCE);
+
+    // Both edges: works whatever the line polarity, a release edge only
+    // costs the main loop one REG_0C read
+    LL_EXTI_InitTypeDef InitStruct;
+    InitStruct.Line = IRQ_EXTI_LINE;
+    InitStruct.LineCommand = ENABLE;
+    InitStruct.Mode = LL_EXTI_MODE_IT;
+    InitStruct.Trigger = LL_EXTI_TRIGGER_RISING_FALLING;
+    LL_EXTI_Init(&InitStruct);
+
+    NVIC_SetPriority(EXTI4_15_IRQn, 2);
+    NVIC_EnableIRQ(EXTI4_15_IRQn);
+}
+
+bool BK4819_IRQ_Pop(uint32_t *pTime)
+{
+    const uint8_t Index = Tail;
+
+    if (Index == Head)
+    {
+        return false;
+    }
+
+    *pTime = Queue[Index % QUEUE_SIZE];
+    __DMB(); // slot read before it is handed back to the handler
+    Tail = Index + 1;
+
+    return true;
+}
+
+void EXTI4_15_IRQHandler(void)
+{
+    if (!LL_EXTI_IsActiveFlag(IRQ_EXTI_LINE))
+    {
+        return;
+    }
+
+    LL_EXTI_ClearFlag(IRQ_EXTI_LINE);
+
+    const uint8_t Index = Head;
+
+    // Full: the main loop still has edges to handle and drains REG_0C until
+    // the chip is idle anyway, so dropping one loses nothing
+    if ((uint8_t)(Index - Tail) >= QUEUE_SIZE)
+    {
+        return;
+    }
+
+    Queue[Index % QUEUE_SIZE] = SYSTICK_GetUs();
+    __DMB(); // slot written before it is published
+    Head = Index + 1;
+}
@@ -0,0 +1,29 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef DRIVER_BK4819_IRQ_H
+#define DRIVER_BK4819_IRQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Edges of the BK4819 interrupt line, queued by the EXTI handler for the main
+// loop. The handler never touches the BK4819 bus: the main loop may be in the
+// middle of a transaction, so REG_02 is still read there.
+
+void BK4819_IRQ_Init(void);
+
+// Oldest queued edge, SYSTICK_GetUs() time stamp; false when none
+bool BK4819_IRQ_Pop(uint32_t *pTime);
+
+#endif
@@ -0,0 +1,77 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// Bookkeeping only: the driver takes the time stamps, so this file has no
+// hardware dependency and builds as is on a host.
+
+#include <string.h>
+
+#include "driver/bk4819_profile.h"
+
+_Static_assert(sizeof(BK4819_Profile_t) == 564, "profile layout, see _bkprof.py");
+
+#define STACK_DEPTH 4
+
+BK4819_Profile_t gBK4819_Profile;
+
+static uint8_t Caller = BK4819_CALLER_OTHER;
+static uint8_t Stack[STACK_DEPTH];
+static uint8_t Depth;
+
+void BK4819_ProfileReset(void)
+{
+    memset(&gBK4819_Profile, 0, sizeof(gBK4819_Profile));
+}
+
+void BK4819_ProfileEnter(BK4819_Caller_t NewCaller)
+{
+    // Deeper nesting keeps counting the depth but is charged to the innermost
+    // caller that fit
+    if (Depth < STACK_DEPTH)
+    {
+        Stack[Depth] = Caller;
+        Caller = NewCaller;
+    }
+    Depth++;
+}
+
+void BK4819_ProfileLeave(void)
+{
+    if (Depth && --Depth < STACK_DEPTH)
+    {
+        Caller = Stack[Depth];
+    }
+}
+
+void BK4819_ProfileCount(uint8_t Register, bool Write)
+{
+    uint16_t *pCount = Write ? &gBK4819_Profile.Writes[Register & 0x7f] : &gBK4819_Profile.Reads[Register & 0x7f];
+
+    if (*pCount != 0xffff)
+    {
+        (*pCount)++;
+    }
+}
+
+void BK4819_ProfileCall(uint8_t Register, bool Write, uint32_t Us)
+{
+    gBK4819_Profile.BusUs[Caller] += Us;
+    gBK4819_Profile.Calls[Caller]++;
+
+    if (Us > gBK4819_Profile.WorstUs)
+    {
+        gBK4819_Profile.WorstUs = Us > 0xffff ? 0xffff : Us;
+        gBK4819_Profile.WorstRegister = (Register & 0x7f) | (Write ? 0 : 0x80);
+        gBK4819_Profile.WorstCaller = Caller;
+    }
+}
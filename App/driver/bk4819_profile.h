@@ -0,0 +1,63 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef DRIVER_BK4819_PROFILE_H
+#define DRIVER_BK4819_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// BK4819 bus accounting (ENABLE_BK4819_PROFILE). Code paths mark themselves
+// with BK4819_PROFILE_BEGIN()/END(); bus time inside is charged to them.
+// Without the flag the macros expand to nothing.
+
+typedef enum
+{
+    BK4819_CALLER_OTHER,
+    BK4819_CALLER_SCAN,
+    BK4819_CALLER_SPECTRUM,
+    BK4819_CALLER_AM_FIX,
+    BK4819_CALLER_IRQ,
+    BK4819_CALLER_UI,
+    BK4819_CALLER_COUNT
+} BK4819_Caller_t;
+
+// Layout read by tools/serialtool/_bkprof.py
+typedef struct
+{
+    uint16_t Reads[128];                   // per register, saturating
+    uint16_t Writes[128];                  // bus writes, shadow hits not counted
+    uint32_t BusUs[BK4819_CALLER_COUNT];   // bus time per caller
+    uint32_t Calls[BK4819_CALLER_COUNT];   // bus transactions per caller
+    uint16_t WorstUs;                      // slowest single call
+    uint8_t  WorstRegister;                // of the slowest call, bit 7 set for a read
+    uint8_t  WorstCaller;
+} BK4819_Profile_t;
+
+#ifdef ENABLE_BK4819_PROFILE
+    extern BK4819_Profile_t gBK4819_Profile;
+
+    void BK4819_ProfileReset(void);
+    void BK4819_ProfileEnter(BK4819_Caller_t Caller);
+    void BK4819_ProfileLeave(void);
+    void BK4819_ProfileCount(uint8_t Register, bool Write);
+    void BK4819_ProfileCall(uint8_t Register, bool Write, uint32_t Us);
+
+    #define BK4819_PROFILE_BEGIN(Caller) BK4819_ProfileEnter(Caller)
+    #define BK4819_PROFILE_END()         BK4819_ProfileLeave()
+#else
+    #define BK4819_PROFILE_BEGIN(Caller) do {} while (0)
+    #define BK4819_PROFILE_END()         do {} while (0)
+#endif
+
+#endif
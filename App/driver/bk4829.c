@@ -17,12 +17,14 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "settings.h"
 
 #include "audio.h"
 
 #include "driver/bk4819.h"
+#include "driver/bk4819_profile.h"
 #include "driver/gpio.h"
 #include "driver/system.h"
 #include "driver/systick.h"
@@ -43,8 +45,43 @@ static const uint16_t FSK_RogerTable[7] = {0xF1A2, 0x7446, 0x61A4, 0x6544, 0x4E8
 
 static uint16_t gBK4819_GpioOutState;
 
+// Last value written to each register, valid where the ShadowValid bit is set.
+// Writes of an unchanged value are skipped.
+static uint16_t Shadow[128];
+static uint32_t ShadowValid[128 / 32];
+
+#define REG_BIT(Register) (1u << ((Register) % 32))
+
+// Registers RADIO_QuickRetune() leaves as RADIO_SetupRegisters() set them.
+// Not the frequency, the interrupt mask or GPIOs: it rewrites those itself.
+static const uint32_t RxSetupRegs[128 / 32] = {
+    REG_BIT(BK4819_REG_07) | REG_BIT(BK4819_REG_08) | REG_BIT(BK4819_REG_10) | REG_BIT(BK4819_REG_11) |
+    REG_BIT(BK4819_REG_12) | REG_BIT(BK4819_REG_13) | REG_BIT(BK4819_REG_14),
+    REG_BIT(BK4819_REG_21) | REG_BIT(BK4819_REG_24) | REG_BIT(BK4819_REG_28) | REG_BIT(BK4819_REG_29) |
+    REG_BIT(BK4819_REG_2B) | REG_BIT(BK4819_REG_31),
+    REG_BIT(BK4819_REG_43) | REG_BIT(BK4819_REG_46) | REG_BIT(BK4819_REG_48) | REG_BIT(BK4819_REG_49) |
+    REG_BIT(BK4819_REG_4D) | REG_BIT(BK4819_REG_4E) | REG_BIT(BK4819_REG_4F) | REG_BIT(BK4819_REG_51),
+    REG_BIT(BK4819_REG_71) | REG_BIT(BK4819_REG_78) | REG_BIT(BK4819_REG_79) | REG_BIT(BK4819_REG_7A) |
+    REG_BIT(BK4819_REG_7B) | REG_BIT(BK4819_REG_7D) | REG_BIT(BK4819_REG_7E),
+};
+
+static uint32_t RxSetupWrites;
+
 bool gRxIdleMode;
 
+#ifdef ENABLE_UART_BENCHMARK
+BK4819_WriteStats_t gBK4819_WriteStats;
+#endif
+
+// Bus time of one call, see driver/bk4819_profile.h
+#ifdef ENABLE_BK4819_PROFILE
+    #define PROFILE_STAMP(Start)                 const uint32_t Start = SYSTICK_GetUs()
+    #define PROFILE_CALL(Start, Register, Write) BK4819_ProfileCall(Register, Write, SYSTICK_GetUs() - (Start))
+#else
+    #define PROFILE_STAMP(Start)
+    #define PROFILE_CALL(Start, Register, Write)
+#endif
+
 static inline void CS_Assert()
 {
     GPIO_ResetOutputPin(PIN_CSN);
@@ -91,31 +128,82 @@ static inline uint16_t scale_freq(const uint16_t freq)
     return (((uint32_t)freq * 1353245u) + (1u << 16)) >> 17;   // with rounding
 }
 
-void BK4819_Init(void)
-{
-    CS_Release();
-    SCL_Set();
-    SDA_Set();
-
-    BK4819_WriteRegister(BK4819_REG_00, 0x8000);
-    BK4819_WriteRegister(BK4819_REG_00, 0x0000);
-
-    BK4819_WriteRegister(BK4819_REG_37, 0x9D1F);
-    BK4819_WriteRegister(BK4819_REG_36, 0x0022);
+// REG_24 DTMF detection
+//
+// <15>   1  ???
+//
+// <14:7> 24 Threshold
+//
+// <6>    1  ???
+//
+// <5>    0  DTMF/SelCall enable
+//        1 = Enable
+//        0 = Disable
+//
+// <4>    1  DTMF or SelCall detection mode
+//        1 = for DTMF
+//        0 = for SelCall
+//
+// <3:0>  14 Max symbol number for SelCall detection
+//
+// threshold 24 is the default, but doesn't decode non-QS radios; 128 ~ 247 does
+#define REG_24_DTMF_ON (                                  \
+    (1u   << BK4819_REG_24_SHIFT_UNKNOWN_15) |            \
+    (130u << BK4819_REG_24_SHIFT_THRESHOLD)  |            \
+    (1u   << BK4819_REG_24_SHIFT_UNKNOWN_6)  |            \
+             BK4819_REG_24_ENABLE            |            \
+             BK4819_REG_24_SELECT_DTMF       |            \
+    (15u  << BK4819_REG_24_SHIFT_MAX_SYMBOLS))
+
+#define REG_30_RX_ON (                                    \
+    BK4819_REG_30_ENABLE_VCO_CALIB |                      \
+    BK4819_REG_30_ENABLE_RX_LINK   |                      \
+    BK4819_REG_30_ENABLE_AF_DAC    |                      \
+    BK4819_REG_30_ENABLE_DISC_MODE |                      \
+    BK4819_REG_30_ENABLE_PLL_VCO   |                      \
+    BK4819_REG_30_ENABLE_RX_DSP)
+
+#define REG_30_TX_LINK (                                  \
+    BK4819_REG_30_ENABLE_VCO_CALIB |                      \
+    BK4819_REG_30_ENABLE_UNKNOWN   |                      \
+    BK4819_REG_30_DISABLE_RX_LINK  |                      \
+    BK4819_REG_30_ENABLE_AF_DAC    |                      \
+    BK4819_REG_30_ENABLE_DISC_MODE |                      \
+    BK4819_REG_30_ENABLE_PLL_VCO   |                      \
+    BK4819_REG_30_ENABLE_PA_GAIN   |                      \
+    BK4819_REG_30_DISABLE_MIC_ADC  |                      \
+    BK4819_REG_30_ENABLE_TX_DSP    |                      \
+    BK4819_REG_30_DISABLE_RX_DSP)
+
+// AF Output Inverse Mode = Inverse
+// Undocumented bits 0x2040
+#define REG_47_AF(AF) (0x6042 | ((AF) << 8))
+// #define REG_47_AF(AF) ((6u << 12) | ((AF) << 8) | (1u << 6))
+
+#define REG_50_TX_MUTE   0xBB18
+#define REG_50_TX_UNMUTE 0x3B18
+
+static const BK4819_SeqStep_t InitSequence[] = {
+    // soft reset, which also drops the shadow
+    BK4819_SEQ_W(BK4819_REG_00, 0x8000),
+    BK4819_SEQ_W(BK4819_REG_00, 0x0000),
+
+    BK4819_SEQ_W(BK4819_REG_37, 0x9D1F),
+    BK4819_SEQ_W(BK4819_REG_36, 0x0022),
 
     // BK4819_InitAGC(false);
     // BK4819_SetAGC(true);
-    BK4819_WriteRegister(BK4819_REG_10, 0x0318);
-    BK4819_WriteRegister(BK4819_REG_11, 0x033A);
-    BK4819_WriteRegister(BK4819_REG_12, 0x03DB);
-    BK4819_WriteRegister(BK4819_REG_13, 0x03DF);
-    BK4819_WriteRegister(BK4819_REG_14, 0x0210);
-    BK4819_WriteRegister(BK4819_REG_49, 0x2AB2);
-    BK4819_WriteRegister(BK4819_REG_7B, 0x73DC);
+    BK4819_SEQ_W(BK4819_REG_10, 0x0318),
+    BK4819_SEQ_W(BK4819_REG_11, 0x033A),
+    BK4819_SEQ_W(BK4819_REG_12, 0x03DB),
+    BK4819_SEQ_W(BK4819_REG_13, 0x03DF),
+    BK4819_SEQ_W(BK4819_REG_14, 0x0210),
+    BK4819_SEQ_W(BK4819_REG_49, 0x2AB2),
+    BK4819_SEQ_W(BK4819_REG_7B, 0x73DC),
 
-    // BK4819_WriteRegister(BK4819_REG_19, 0b0001000001000001);   // <15> MIC AGC  1 = disable  0 = enable
+    // BK4819_SEQ_W(BK4819_REG_19, 0b0001000001000001),   // <15> MIC AGC  1 = disable  0 = enable
 
-    BK4819_WriteRegister(BK4819_REG_7D, 0xE920);
+    BK4819_SEQ_W(BK4819_REG_7D, 0xE920),
 
     // REG_48 .. RX AF level
     //
@@ -135,179 +223,439 @@ void BK4819_Init(void)
     //         15 = max
     //          0 = min
     //
-    BK4819_WriteRegister(BK4819_REG_48, //  0xB3A8);     // 1011 00 111010 1000
+    BK4819_SEQ_W(BK4819_REG_48, //  0xB3A8);     // 1011 00 111010 1000
         // (11u << 12) |     // ??? 0..15
         // ( 0u << 10) |     // AF Rx Gain-1
         // (58u <<  4) |     // AF Rx Gain-2
         // ( 8u <<  0));     // AF DAC Gain (after Gain-1 and Gain-2)
-        0x33A8);
+        0x33A8),
+
+    BK4819_SEQ_W(0x40, 0x3516),
+
+    // DTMF coefficients: 111, 107, 103, 98, 80, 71, 58, 44, 65, 55, 37, 23, 228, 203, 181, 159
+    BK4819_SEQ_W(BK4819_REG_09, 0x006F),
+    BK4819_SEQ_W(BK4819_REG_09, 0x106B),
+    BK4819_SEQ_W(BK4819_REG_09, 0x2067),
+    BK4819_SEQ_W(BK4819_REG_09, 0x3062),
+    BK4819_SEQ_W(BK4819_REG_09, 0x4050),
+    BK4819_SEQ_W(BK4819_REG_09, 0x5047),
+    BK4819_SEQ_W(BK4819_REG_09, 0x603A),
+    BK4819_SEQ_W(BK4819_REG_09, 0x702C),
+    BK4819_SEQ_W(BK4819_REG_09, 0x8041),
+    BK4819_SEQ_W(BK4819_REG_09, 0x9037),
+    BK4819_SEQ_W(BK4819_REG_09, 0xA025),
+    BK4819_SEQ_W(BK4819_REG_09, 0xB017),
+    BK4819_SEQ_W(BK4819_REG_09, 0xC0E4),
+    BK4819_SEQ_W(BK4819_REG_09, 0xD0CB),
+    BK4819_SEQ_W(BK4819_REG_09, 0xE0B5),
+    BK4819_SEQ_W(BK4819_REG_09, 0xF09F),
+
+    BK4819_SEQ_W(0x1C, 0x07C0),
+    BK4819_SEQ_W(0x1D, 0xE555),
+    BK4819_SEQ_W(0x1E, 0x4C58),
+
+    BK4819_SEQ_W(BK4819_REG_1F, 0xC65A),
+    BK4819_SEQ_W(BK4819_REG_3E, 0x94C6),
+
+    BK4819_SEQ_W(0x73, 0x4691),
+    BK4819_SEQ_W(0x77, 0x88EF),
+    BK4819_SEQ_W(BK4819_REG_19, 0x104E),
+    BK4819_SEQ_W(BK4819_REG_28, 0x0B40),
+    BK4819_SEQ_W(BK4819_REG_29, 0xAA00),
+    BK4819_SEQ_W(0x2A, 0x6600),
+    BK4819_SEQ_W(0x2C, 0x1822),
+    BK4819_SEQ_W(0x2F, 0x9890),
+    BK4819_SEQ_W(0x53, 0x2028),
+    BK4819_SEQ_W(BK4819_REG_7E, 0x303E),
+    BK4819_SEQ_W(BK4819_REG_46, 0x600A),
+    BK4819_SEQ_W(0x4A, 0x5430),
+    BK4819_SEQ_W(BK4819_REG_07, 0x61CE),
+
+    BK4819_SEQ_W(BK4819_REG_33, 0x9000), // gBK4819_GpioOutState
+    BK4819_SEQ_W(BK4819_REG_3F, 0),
+};
+
+void BK4819_Init(void)
+{
+    CS_Release();
+    SCL_Set();
+    SDA_Set();
 
-    BK4819_WriteRegister(0x40, 0x3516);
+    gBK4819_GpioOutState = 0x9000;
 
-#if 1
-    const uint8_t dtmf_coeffs[] = {111, 107, 103, 98, 80, 71, 58, 44, 65, 55, 37, 23, 228, 203, 181, 159};
-    for (unsigned int i = 0; i < ARRAY_SIZE(dtmf_coeffs); i++)
-        BK4819_WriteRegister(BK4819_REG_09, (i << 12) | dtmf_coeffs[i]);
+    BK4819_RunSequence(InitSequence, ARRAY_SIZE(InitSequence));
+}
+
+// Bus timing at 48 MHz. The SYSTICK_DelayUs(1) calls used before really took
+// 2-3 us each (SysTick polling), which made a register access cost ~150 us.
+//
+// Writes: the chip latches SDA on the rising edge of SCL. The BK4819
+// datasheet has no serial timing table, the only proven figure is the stock
+// firmware's 1 us phases. That is kept: 44 NOPs plus the GPIO store, 1 us of
+// setup and of hold around that edge.
+//
+// ENABLE_BK4819_FAST_BUS cuts that to 4 NOPs, 6-8 cycles or 125-170 ns. It
+// relies on the chip being ~6x faster than the stock timing, which has not
+// been checked on a scope yet: an opt-in until it is.
+//
+// Reads: the chip drives the next bit after the falling edge, with no output
+// delay specified anywhere. SDA is sampled a full 1 us after that edge, as it
+// always was: reads are rarer than writes and not worth the risk.
+#ifdef ENABLE_BK4819_FAST_BUS
+    #define BUS_DELAY_NOPS "4"
 #else
-    // original code
-    BK4819_WriteRegister(BK4819_REG_09, 0x006F);  // 6F
-    BK4819_WriteRegister(BK4819_REG_09, 0x106B);  // 6B
-    BK4819_WriteRegister(BK4819_REG_09, 0x2067);  // 67
-    BK4819_WriteRegister(BK4819_REG_09, 0x3062);  // 62
-    BK4819_WriteRegister(BK4819_REG_09, 0x4050);  // 50
-    BK4819_WriteRegister(BK4819_REG_09, 0x5047);  // 47
-    BK4819_WriteRegister(BK4819_REG_09, 0x603A);  // 3A
-    BK4819_WriteRegister(BK4819_REG_09, 0x702C);  // 2C
-    BK4819_WriteRegister(BK4819_REG_09, 0x8041);  // 41
-    BK4819_WriteRegister(BK4819_REG_09, 0x9037);  // 37
-    BK4819_WriteRegister(BK4819_REG_09, 0xA025);  // 25
-    BK4819_WriteRegister(BK4819_REG_09, 0xB017);  // 17
-    BK4819_WriteRegister(BK4819_REG_09, 0xC0E4);  // E4
-    BK4819_WriteRegister(BK4819_REG_09, 0xD0CB);  // CB
-    BK4819_WriteRegister(BK4819_REG_09, 0xE0B5);  // B5
-    BK4819_WriteRegister(BK4819_REG_09, 0xF09F);  // 9F
+    #define BUS_DELAY_NOPS "44"
 #endif
+#define READ_SAMPLE_NOPS "44" // + loop and GPIO read: 48 cycles
 
-    BK4819_WriteRegister(0x1C, 0x07C0);
-    BK4819_WriteRegister(0x1D, 0xE555);
-    BK4819_WriteRegister(0x1E, 0x4C58);
-
-    BK4819_WriteRegister(BK4819_REG_1F, 0xC65A);
-    BK4819_WriteRegister(BK4819_REG_3E, 0x94C6);
-
-    BK4819_WriteRegister(0x73, 0x4691);
-    BK4819_WriteRegister(0x77, 0x88EF);
-    BK4819_WriteRegister(BK4819_REG_19, 0x104E);
-    BK4819_WriteRegister(BK4819_REG_28, 0x0B40);
-    BK4819_WriteRegister(BK4819_REG_29, 0xAA00);
-    BK4819_WriteRegister(0x2A, 0x6600);
-    BK4819_WriteRegister(0x2C, 0x1822);
-    BK4819_WriteRegister(0x2F, 0x9890);
-    BK4819_WriteRegister(0x53, 0x2028);
-    BK4819_WriteRegister(BK4819_REG_7E, 0x303E);
-    BK4819_WriteRegister(BK4819_REG_46, 0x600A);
-    BK4819_WriteRegister(0x4A, 0x5430);
-    BK4819_WriteRegister(BK4819_REG_07, 0x61CE);
+#ifdef ENABLE_UART_BENCHMARK
+    static bool LegacyTiming; // benchmark reference: the old 1 us SysTick delays
+#endif
 
-    gBK4819_GpioOutState = 0x9000;
+static inline __attribute__((always_inline)) void BusDelay(void)
+{
+#ifdef ENABLE_UART_BENCHMARK
+    if (LegacyTiming)
+    {
+        SYSTICK_DelayUs(1);
+        return;
+    }
+#endif
+    __asm volatile(".rept " BUS_DELAY_NOPS "\n\tnop\n\t.endr");
+}
 
-    BK4819_WriteRegister(BK4819_REG_33, 0x9000);
-    BK4819_WriteRegister(BK4819_REG_3F, 0);
+// Between the SCL falling edge and the SDA sample
+static inline __attribute__((always_inline)) void BusSampleDelay(void)
+{
+#ifdef ENABLE_UART_BENCHMARK
+    if (LegacyTiming)
+    {
+        SYSTICK_DelayUs(1);
+        return;
+    }
+#endif
+    __asm volatile(".rept " READ_SAMPLE_NOPS "\n\tnop\n\t.endr");
 }
 
-static uint16_t BK4819_ReadU16(void)
+static inline __attribute__((always_inline)) void BusWriteBits(uint32_t Data, unsigned int Bits)
 {
-    unsigned int i;
-    uint16_t     Value;
+    Data <<= 32 - Bits;
+
+    SCL_Reset();
+    while (Bits--)
+    {
+        if (Data & 0x80000000u)
+            SDA_Set();
+        else
+            SDA_Reset();
+
+        BusDelay();
+        SCL_Set();
+        BusDelay();
+
+        Data <<= 1;
+
+        SCL_Reset();
+        BusDelay();
+    }
+}
+
+static uint16_t BusReadU16(void)
+{
+    uint16_t Value = 0;
 
     SDA_SetDir(false);
-    SYSTICK_DelayUs(1);
-    Value = 0;
-    for (i = 0; i < 16; i++)
+    BusSampleDelay();
+    for (unsigned int i = 0; i < 16; i++)
     {
         Value <<= 1;
         Value |= SDA_ReadInput();
         SCL_Set();
-        SYSTICK_DelayUs(1);
+        BusDelay();
         SCL_Reset();
-        SYSTICK_DelayUs(1);
+        BusSampleDelay();
     }
     SDA_SetDir(true);
 
     return Value;
 }
 
-uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register)
+// One address + data frame; the chip latches it on the CS rising edge
+static inline void BusWriteFrame(uint8_t Register, uint16_t Data)
 {
-    uint16_t Value;
+    CS_Assert();
+    BusWriteBits(Register, 8);
+    BusDelay();
+    BusWriteBits(Data, 16);
+    BusDelay();
+    CS_Release();
+    BusDelay();
+}
 
+static inline void BusBegin(void)
+{
     CS_Release();
     SCL_Reset();
+    BusDelay();
+}
+
+static inline void BusEnd(void)
+{
+    SCL_Set();
+    SDA_Set();
+}
 
-    SYSTICK_DelayUs(1);
+uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register)
+{
+    uint16_t Value;
+
+    PROFILE_STAMP(Start);
+
+    BusBegin();
 
     CS_Assert();
-    BK4819_WriteU8(Register | 0x80);
-    Value = BK4819_ReadU16();
+    BusWriteBits(Register | 0x80, 8);
+    Value = BusReadU16();
     CS_Release();
 
-    SYSTICK_DelayUs(1);
+    BusDelay();
 
-    SCL_Set();
-    SDA_Set();
+    BusEnd();
+
+#ifdef ENABLE_BK4819_PROFILE
+    BK4819_ProfileCount(Register, false);
+#endif
+    PROFILE_CALL(Start, Register, false);
 
     return Value;
 }
 
-void BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data)
+// Registers that act on write or change by themselves: always written, never shadowed
+static inline bool IsVolatile(BK4819_REGISTER_t Register)
 {
-    CS_Release();
-    SCL_Reset();
+    switch (Register)
+    {
+        case BK4819_REG_00: // soft reset
+        case BK4819_REG_02: // interrupt flags, cleared by writing
+        case BK4819_REG_09: // indexed DTMF coefficient table
+        case BK4819_REG_30: // toggled through 0 to restart the RX/TX chain
+        case BK4819_REG_32: // frequency scan start
+        case BK4819_REG_59: // self-clearing FSK FIFO clear bits
+        case BK4819_REG_5F: // FSK FIFO
+            return true;
 
-    SYSTICK_DelayUs(1);
+        default:
+            return false;
+    }
+}
 
-    CS_Assert();
-    BK4819_WriteU8(Register);
+void BK4819_InvalidateShadow(void)
+{
+    memset(ShadowValid, 0, sizeof(ShadowValid));
+    RxSetupWrites++;
+}
 
-    SYSTICK_DelayUs(1);
+uint32_t BK4819_GetRxSetupWrites(void)
+{
+    return RxSetupWrites;
+}
 
-    BK4819_WriteU16(Data);
+static inline bool ShadowValidFor(uint8_t Index)
+{
+    return ShadowValid[Index / 32] & (1u << (Index % 32));
+}
 
-    SYSTICK_DelayUs(1);
+// True when the chip already holds Data, the write can be skipped
+static inline bool ShadowHit(BK4819_REGISTER_t Register, uint16_t Data)
+{
+    const uint8_t Index = Register & 0x7f;
 
-    CS_Release();
+    if (ShadowValidFor(Index) && Shadow[Index] == Data)
+    {
+#ifdef ENABLE_UART_BENCHMARK
+        gBK4819_WriteStats.Elided++;
+#endif
+        return true;
+    }
 
-    SYSTICK_DelayUs(1);
+    return false;
+}
 
-    SCL_Set();
-    SDA_Set();
+// Bookkeeping after Data went out on the bus
+static void ShadowStore(BK4819_REGISTER_t Register, uint16_t Data)
+{
+    const uint8_t Index = Register & 0x7f;
+
+#ifdef ENABLE_UART_BENCHMARK
+    gBK4819_WriteStats.Issued++;
+#endif
+#ifdef ENABLE_BK4819_PROFILE
+    BK4819_ProfileCount(Register, true);
+#endif
+
+    if (Register == BK4819_REG_00)
+    {
+        BK4819_InvalidateShadow();
+    }
+    else if (!IsVolatile(Register))
+    {
+        // Reached only when the shadow had no copy or another value
+        if (RxSetupRegs[Index / 32] & REG_BIT(Index))
+        {
+            RxSetupWrites++;
+        }
+        Shadow[Index] = Data;
+        ShadowValid[Index / 32] |= 1u << (Index % 32);
+    }
 }
 
-void BK4819_WriteU8(uint8_t Data)
+void BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data)
 {
-    unsigned int i;
+    if (ShadowHit(Register, Data))
+    {
+        return;
+    }
 
-    SCL_Reset();
-    for (i = 0; i < 8; i++)
+    PROFILE_STAMP(Start);
+
+    BusBegin();
+    BusWriteFrame(Register, Data);
+    BusEnd();
+
+    PROFILE_CALL(Start, Register, true);
+
+    ShadowStore(Register, Data);
+}
+
+void BK4819_WriteBurst(BK4819_REGISTER_t Register, const uint16_t *pData, uint32_t Count)
+{
+    // Back to back frames: CS still has to rise after each one, but the bus is
+    // parked only once
+    PROFILE_STAMP(Start);
+
+    BusBegin();
+    for (uint32_t i = 0; i < Count; i++)
     {
-        if ((Data & 0x80) == 0)
-            SDA_Reset();
-        else
-            SDA_Set();
+        BusWriteFrame(Register, pData[i]);
+        ShadowStore(Register, pData[i]);
+    }
+    BusEnd();
 
-        SYSTICK_DelayUs(1);
-        SCL_Set();
-        SYSTICK_DelayUs(1);
+    PROFILE_CALL(Start, Register, true);
+}
 
-        Data <<= 1;
+// Runs a const register table. Writes the shadow already matches are skipped,
+// the others are sent back to back like BK4819_WriteBurst(). MODIFY steps take
+// the current value from the shadow when they can, else from the chip.
+void BK4819_RunSequence(const BK4819_SeqStep_t *pSteps, uint32_t Count)
+{
+    bool Open = false;
+#ifdef ENABLE_BK4819_PROFILE
+    // Each run of back to back writes is one call, delays are not bus time
+    uint32_t Start = 0;
+    uint8_t  First = 0;
+#endif
 
-        SCL_Reset();
-        SYSTICK_DelayUs(1);
+    for (uint32_t i = 0; i < Count; i++)
+    {
+        const BK4819_SeqStep_t *pStep = &pSteps[i];
+        const BK4819_REGISTER_t Register = pStep->Register;
+        uint16_t Value = pStep->Value;
+
+        if (pStep->Op != BK4819_SEQ_WRITE)
+        {
+            if (Open)
+            {
+                BusEnd();
+                PROFILE_CALL(Start, First, true);
+                Open = false;
+            }
+
+            if (pStep->Op == BK4819_SEQ_DELAY)
+            {
+                SYSTICK_DelayUs(Value);
+                continue;
+            }
+
+            const uint8_t Index = Register & 0x7f;
+            const uint16_t Current = ShadowValidFor(Index) ? Shadow[Index] : BK4819_ReadRegister(Register);
+            Value = (Current & ~pStep->Mask) | (Value & pStep->Mask);
+        }
+
+        if (ShadowHit(Register, Value))
+        {
+            continue;
+        }
+
+        if (!Open)
+        {
+#ifdef ENABLE_BK4819_PROFILE
+            Start = SYSTICK_GetUs();
+            First = Register;
+#endif
+            BusBegin();
+            Open = true;
+        }
+
+        BusWriteFrame(Register, Value);
+        ShadowStore(Register, Value);
+    }
+
+    if (Open)
+    {
+        BusEnd();
+        PROFILE_CALL(Start, First, true);
     }
 }
 
+void BK4819_WriteU8(uint8_t Data)
+{
+    BusWriteBits(Data, 8);
+}
+
 void BK4819_WriteU16(uint16_t Data)
 {
-    unsigned int i;
+    BusWriteBits(Data, 16);
+}
 
-    SCL_Reset();
-    for (i = 0; i < 16; i++)
+#ifdef ENABLE_UART_BENCHMARK
+static uint32_t BenchTransactions(bool Write)
+{
+    enum { COUNT = 64 };
+    // Writes go around the shadow; rewriting the current interrupt mask is harmless
+    const uint16_t Mask = BK4819_ReadRegister(BK4819_REG_3F);
+    const uint32_t Start = SYSTICK_GetUs();
+
+    for (unsigned int i = 0; i < COUNT; i++)
     {
-        if ((Data & 0x8000) == 0)
-            SDA_Reset();
+        if (Write)
+        {
+            BusBegin();
+            BusWriteFrame(BK4819_REG_3F, Mask);
+            BusEnd();
+        }
         else
-            SDA_Set();
+        {
+            BK4819_ReadRegister(BK4819_REG_0C);
+        }
+    }
 
-        SYSTICK_DelayUs(1);
-        SCL_Set();
+    const uint32_t Elapsed = SYSTICK_GetUs() - Start;
+    return Elapsed ? (COUNT * 1000000u) / Elapsed : 0;
+}
 
-        Data <<= 1;
+// Transactions per second, with the old SysTick delays and with the tuned ones
+void BK4819_Benchmark(BK4819_Benchmark_t *pResult)
+{
+    LegacyTiming = true;
+    pResult->LegacyReads = BenchTransactions(false);
+    pResult->LegacyWrites = BenchTransactions(true);
 
-        SYSTICK_DelayUs(1);
-        SCL_Reset();
-        SYSTICK_DelayUs(1);
-    }
+    LegacyTiming = false;
+    pResult->Reads = BenchTransactions(false);
+    pResult->Writes = BenchTransactions(true);
 }
+#endif
 
 void BK4819_SetAGC(bool enable)
 {
@@ -845,11 +1193,7 @@ void BK4819_SetupSquelch(
 
 void BK4819_SetAF(BK4819_AF_Type_t AF)
 {
-    // AF Output Inverse Mode = Inverse
-    // Undocumented bits 0x2040
-    //
-    BK4819_WriteRegister(BK4819_REG_47, 0x6042 | (AF << 8));
-    // BK4819_WriteRegister(BK4819_REG_47, (6u << 12) | (AF << 8) | (1u << 6));
+    BK4819_WriteRegister(BK4819_REG_47, REG_47_AF(AF));
 }
 
 void BK4819_SetRegValue(RegisterSpec s, uint16_t v) {
@@ -1013,33 +1357,7 @@ void BK4819_EnableDTMF(void)
     // no idea what this does
     BK4819_WriteRegister(BK4819_REG_21, 0x06D8);        // 0000 0110 1101 1000
 
-    // REG_24
-    //
-    // <15>   1  ???
-    //
-    // <14:7> 24 Threshold
-    //
-    // <6>    1  ???
-    //
-    // <5>    0  DTMF/SelCall enable
-    //        1 = Enable
-    //        0 = Disable
-    //
-    // <4>    1  DTMF or SelCall detection mode
-    //        1 = for DTMF
-    //        0 = for SelCall
-    //
-    // <3:0>  14 Max symbol number for SelCall detection
-    //
-//  const uint16_t threshold = 24;    // default, but doesn't decode non-QS radios
-    const uint16_t threshold = 130;   // but 128 ~ 247 does
-    BK4819_WriteRegister(BK4819_REG_24,                      // 1 00011000 1 1 1 1110
-        (1u        << BK4819_REG_24_SHIFT_UNKNOWN_15) |
-        (threshold << BK4819_REG_24_SHIFT_THRESHOLD)  |      // 0 ~ 255
-        (1u        << BK4819_REG_24_SHIFT_UNKNOWN_6)  |
-                      BK4819_REG_24_ENABLE            |
-                      BK4819_REG_24_SELECT_DTMF       |
-        (15u       << BK4819_REG_24_SHIFT_MAX_SYMBOLS));     // 0 ~ 15
+    BK4819_WriteRegister(BK4819_REG_24, REG_24_DTMF_ON);  // 1 00011000 1 1 1 1110
 }
 
 void BK4819_PlayTone(uint16_t Frequency, bool bTuningGainSwitch)
@@ -1099,58 +1417,64 @@ void BK4819_PlaySingleTone(const unsigned int tone_Hz, const unsigned int delay,
 
 void BK4819_EnterTxMute(void)
 {
-    BK4819_WriteRegister(BK4819_REG_50, 0xBB18);
+    BK4819_WriteRegister(BK4819_REG_50, REG_50_TX_MUTE);
 }
 
 void BK4819_ExitTxMute(void)
 {
-    BK4819_WriteRegister(BK4819_REG_50, 0x3B18);
+    BK4819_WriteRegister(BK4819_REG_50, REG_50_TX_UNMUTE);
 }
 
 void BK4819_Sleep(void)
 {
-    BK4819_WriteRegister(BK4819_REG_30, 0);
-    BK4819_WriteRegister(BK4819_REG_37, 0x1D00);
+    static const BK4819_SeqStep_t Sequence[] = {
+        BK4819_SEQ_W(BK4819_REG_30, 0),
+        BK4819_SEQ_W(BK4819_REG_37, 0x1D00),
+    };
+
+    BK4819_RunSequence(Sequence, ARRAY_SIZE(Sequence));
 }
 
 void BK4819_TurnsOffTones_TurnsOnRX(void)
 {
-    BK4819_WriteRegister(BK4819_REG_70, 0);
-    BK4819_SetAF(BK4819_AF_MUTE);
-
-    BK4819_ExitTxMute();
+    static const BK4819_SeqStep_t Sequence[] = {
+        BK4819_SEQ_W(BK4819_REG_70, 0),
+        BK4819_SEQ_W(BK4819_REG_47, REG_47_AF(BK4819_AF_MUTE)),
+        BK4819_SEQ_W(BK4819_REG_50, REG_50_TX_UNMUTE),
+        BK4819_SEQ_W(BK4819_REG_30, 0),
+        BK4819_SEQ_W(BK4819_REG_30, REG_30_RX_ON),
+    };
 
-    BK4819_WriteRegister(BK4819_REG_30, 0);
-    BK4819_WriteRegister(BK4819_REG_30,
-        BK4819_REG_30_ENABLE_VCO_CALIB |
-        BK4819_REG_30_ENABLE_RX_LINK   |
-        BK4819_REG_30_ENABLE_AF_DAC    |
-        BK4819_REG_30_ENABLE_DISC_MODE |
-        BK4819_REG_30_ENABLE_PLL_VCO   |
-        BK4819_REG_30_ENABLE_RX_DSP);
+    BK4819_RunSequence(Sequence, ARRAY_SIZE(Sequence));
 }
 
 #ifdef ENABLE_AIRCOPY
     void BK4819_SetupAircopy(void)
     {
-        BK4819_WriteRegister(BK4819_REG_70, 0x00C3);    // Enable Tone2, tuning gain 48
-        BK4819_WriteRegister(BK4819_REG_72, 0x3065);    // Tone2 baudrate 1200
-        BK4819_WriteRegister(BK4819_REG_58, 0x00C1);    // FSK Enable, FSK 1.2K RX Bandwidth, Preamble 0xAA or 0x55, RX Gain 0, RX Mode
-                                                        // (FSK1.2K, FSK2.4K Rx and NOAA SAME Rx), TX Mode FSK 1.2K and FSK 2.4K Tx
-        BK4819_WriteRegister(BK4819_REG_5C, 0x5665);    // Enable CRC among other things we don't know yet
-        BK4819_WriteRegister(BK4819_REG_5D, 0x4700);    // FSK Data Length 72 Bytes (0xabcd + 2 byte length + 64 byte payload + 2 byte CRC + 0xdcba)
-        BK4819_WriteRegister(0x5E, 0x3204);
+        static const BK4819_SeqStep_t Sequence[] = {
+            BK4819_SEQ_W(BK4819_REG_70, 0x00C3),    // Enable Tone2, tuning gain 48
+            BK4819_SEQ_W(BK4819_REG_72, 0x3065),    // Tone2 baudrate 1200
+            BK4819_SEQ_W(BK4819_REG_58, 0x00C1),    // FSK Enable, FSK 1.2K RX Bandwidth, Preamble 0xAA or 0x55, RX Gain 0, RX Mode
+                                                    // (FSK1.2K, FSK2.4K Rx and NOAA SAME Rx), TX Mode FSK 1.2K and FSK 2.4K Tx
+            BK4819_SEQ_W(BK4819_REG_5C, 0x5665),    // Enable CRC among other things we don't know yet
+            BK4819_SEQ_W(BK4819_REG_5D, 0x4700),    // FSK Data Length 72 Bytes (0xabcd + 2 byte length + 64 byte payload + 2 byte CRC + 0xdcba)
+            BK4819_SEQ_W(0x5E, 0x3204),
+        };
+
+        BK4819_RunSequence(Sequence, ARRAY_SIZE(Sequence));
     }
 #endif
 
 void BK4819_ResetFSK(void)
 {
-    BK4819_WriteRegister(BK4819_REG_3F, 0x0000);        // Disable interrupts
-    BK4819_WriteRegister(BK4819_REG_59, 0x0068);        // Sync length 4 bytes, 7 byte preamble
-
-    SYSTEM_DelayMs(30);
+    static const BK4819_SeqStep_t Sequence[] = {
+        BK4819_SEQ_W(BK4819_REG_3F, 0x0000),        // Disable interrupts
+        BK4819_SEQ_W(BK4819_REG_59, 0x0068),        // Sync length 4 bytes, 7 byte preamble
+        BK4819_SEQ_DELAY_US(30000),
+        BK4819_SEQ_W(BK4819_REG_30, 0x0000),        // BK4819_Idle()
+    };
 
-    BK4819_Idle();
+    BK4819_RunSequence(Sequence, ARRAY_SIZE(Sequence));
 }
 
 void BK4819_Idle(void)
@@ -1160,8 +1484,6 @@ void BK4819_Idle(void)
 
 void BK4819_ExitBypass(void)
 {
-    BK4819_SetAF(BK4819_AF_MUTE);
-
     // REG_7E
     //
     // <15>    0 AGC fix mode
@@ -1188,15 +1510,14 @@ void BK4819_ExitBypass(void)
     //         0 ~ 7
     //         0 = bypass DC filter
     //
+    static const BK4819_SeqStep_t Sequence[] = {
+        BK4819_SEQ_W(BK4819_REG_47, REG_47_AF(BK4819_AF_MUTE)),
 
-    uint16_t regVal = BK4819_ReadRegister(BK4819_REG_7E);
-
-    // 0x302E / 0 011 000000 101 110
-    BK4819_WriteRegister(BK4819_REG_7E, (regVal & ~(0b111 << 3))
-
-        | (5u <<  3)       // 5  DC Filter band width for Tx (MIC In)
+        // 0x302E / 0 011 000000 101 110
+        BK4819_SEQ_M(BK4819_REG_7E, 0b111 << 3, 5u << 3),   // 5  DC Filter band width for Tx (MIC In)
+    };
 
-    );
+    BK4819_RunSequence(Sequence, ARRAY_SIZE(Sequence));
 }
 
 void BK4819_PrepareTransmit(void)
@@ -1208,11 +1529,15 @@ void BK4819_PrepareTransmit(void)
 
 void BK4819_TxOn_Beep(void)
 {
-    BK4819_WriteRegister(BK4819_REG_36, 0);
-    BK4819_WriteRegister(BK4819_REG_37, 0x9D1F);
-    BK4819_WriteRegister(BK4819_REG_52, 0x028F);
-    BK4819_WriteRegister(BK4819_REG_30, 0x0000);
-    BK4819_WriteRegister(BK4819_REG_30, 0xC1FE);
+    static const BK4819_SeqStep_t Sequence[] = {
+        BK4819_SEQ_W(BK4819_REG_36, 0),
+        BK4819_SEQ_W(BK4819_REG_37, 0x9D1F),
+        BK4819_SEQ_W(BK4819_REG_52, 0x028F),
+        BK4819_SEQ_W(BK4819_REG_30, 0x0000),
+        BK4819_SEQ_W(BK4819_REG_30, 0xC1FE),
+    };
+
+    BK4819_RunSequence(Sequence, ARRAY_SIZE(Sequence));
 }
 
 void BK4819_ExitSubAu(void)
@@ -1266,46 +1591,45 @@ void BK4819_Conditional_RX_TurnOn_and_GPIO6_Enable(void)
     }
 }
 
+#define DTMF_TX_SEQUENCE(AF) {                                          \
+    BK4819_SEQ_W(BK4819_REG_21, 0x06D8),            /* EnableDTMF */    \
+    BK4819_SEQ_W(BK4819_REG_24, REG_24_DTMF_ON),                        \
+    BK4819_SEQ_W(BK4819_REG_50, REG_50_TX_MUTE),                        \
+    BK4819_SEQ_W(BK4819_REG_47, REG_47_AF(AF)),                         \
+    BK4819_SEQ_W(BK4819_REG_70, 0xC3C3),            /* both tones */    \
+    BK4819_SEQ_W(BK4819_REG_30, REG_30_TX_LINK),    /* TODO: Delete? */ \
+}
+
 void BK4819_EnterDTMF_TX(bool bLocalLoopback)
 {
-    BK4819_EnableDTMF();
-    BK4819_EnterTxMute();
-    BK4819_SetAF(bLocalLoopback ? BK4819_AF_BEEP : BK4819_AF_MUTE);
-
-    BK4819_WriteRegister(BK4819_REG_70, 0xC3C3);
-        // BK4819_REG_70_MASK_ENABLE_TONE1                |
-        // (DTMF_TONE1_GAIN << BK4819_REG_70_SHIFT_TONE1_TUNING_GAIN) |
-        // BK4819_REG_70_MASK_ENABLE_TONE2                |
-        // (DTMF_TONE2_GAIN << BK4819_REG_70_SHIFT_TONE2_TUNING_GAIN));
+    // REG_70: BK4819_REG_70_MASK_ENABLE_TONE1 | (DTMF_TONE1_GAIN << BK4819_REG_70_SHIFT_TONE1_TUNING_GAIN) |
+    //         BK4819_REG_70_MASK_ENABLE_TONE2 | (DTMF_TONE2_GAIN << BK4819_REG_70_SHIFT_TONE2_TUNING_GAIN)
+    static const BK4819_SeqStep_t Sequences[2][6] = {
+        DTMF_TX_SEQUENCE(BK4819_AF_MUTE),
+        DTMF_TX_SEQUENCE(BK4819_AF_BEEP),
+    };
 
-    // TODO: Delete?
-    BK4819_EnableTXLink();
+    BK4819_RunSequence(Sequences[bLocalLoopback], ARRAY_SIZE(Sequences[0]));
 }
 
 void BK4819_ExitDTMF_TX(bool bKeep)
 {
-    BK4819_EnterTxMute();
-    BK4819_SetAF(BK4819_AF_MUTE);
-    BK4819_WriteRegister(BK4819_REG_70, 0x0000);
-    BK4819_DisableDTMF();
-    BK4819_WriteRegister(BK4819_REG_30, 0xC1FE);
+    static const BK4819_SeqStep_t Sequence[] = {
+        BK4819_SEQ_W(BK4819_REG_50, REG_50_TX_MUTE),
+        BK4819_SEQ_W(BK4819_REG_47, REG_47_AF(BK4819_AF_MUTE)),
+        BK4819_SEQ_W(BK4819_REG_70, 0x0000),
+        BK4819_SEQ_W(BK4819_REG_24, 0),                 // DisableDTMF
+        BK4819_SEQ_W(BK4819_REG_30, 0xC1FE),
+    };
+
+    BK4819_RunSequence(Sequence, ARRAY_SIZE(Sequence));
     if (!bKeep)
         BK4819_ExitTxMute();
 }
 
 void BK4819_EnableTXLink(void)
 {
-    BK4819_WriteRegister(BK4819_REG_30,
-        BK4819_REG_30_ENABLE_VCO_CALIB |
-        BK4819_REG_30_ENABLE_UNKNOWN   |
-        BK4819_REG_30_DISABLE_RX_LINK  |
-        BK4819_REG_30_ENABLE_AF_DAC    |
-        BK4819_REG_30_ENABLE_DISC_MODE |
-        BK4819_REG_30_ENABLE_PLL_VCO   |
-        BK4819_REG_30_ENABLE_PA_GAIN   |
-        BK4819_REG_30_DISABLE_MIC_ADC  |
-        BK4819_REG_30_ENABLE_TX_DSP    |
-        BK4819_REG_30_DISABLE_RX_DSP);
+    BK4819_WriteRegister(BK4819_REG_30, REG_30_TX_LINK);
 }
 
 void BK4819_PlayDTMF(char Code)
@@ -1716,7 +2040,6 @@ uint8_t BK4819_GetCTCType(void)
 
 void BK4819_SendFSKData(uint16_t *pData)
 {
-    unsigned int i;
     uint8_t Timeout = 200;
 
     SYSTEM_DelayMs(30);
@@ -1725,8 +2048,7 @@ void BK4819_SendFSKData(uint16_t *pData)
     BK4819_WriteRegister(BK4819_REG_59, 0x8068);
     BK4819_WriteRegister(BK4819_REG_59, 0x0068);
 
-    for (i = 0; i < 36; i++)
-        BK4819_WriteRegister(BK4819_REG_5F, pData[i]);
+    BK4819_WriteBurst(BK4819_REG_5F, pData, 36);
 
     SYSTEM_DelayMs(20);
 
@@ -1832,9 +2154,7 @@ void BK4819_PlayRogerMDC(void)
     }
 
     // Send the data from the roger table
-    for (unsigned int i = 0; i < ARRAY_SIZE(FSK_RogerTable); i++) {
-        BK4819_WriteRegister(BK4819_REG_5F, FSK_RogerTable[i]);
-    }
+    BK4819_WriteBurst(BK4819_REG_5F, FSK_RogerTable, ARRAY_SIZE(FSK_RogerTable));
 
     SYSTEM_DelayMs(20);
 
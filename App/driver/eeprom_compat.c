@@ -35,34 +35,58 @@ typedef struct
     uint16_t Size;
 } AddrMapping_t;
 
-#define _MK_MAPPING(PY25Q16_Addr, EEPROM_From, EEPROM_To) {PY25Q16_Addr, EEPROM_From, EEPROM_To - EEPROM_From}
-
-static const AddrMapping_t ADDR_MAPPINGS[] = {
-    // Sorted by EEPROM addr
-    _MK_MAPPING(0x000000, 0x0000, 0x0c80),  //
-    _MK_MAPPING(0x001000, 0x0c80, 0x0d60),  //
-    _MK_MAPPING(0x002000, 0x0d60, 0x0e30),  //
-    _MK_MAPPING(HOLE_ADDR, 0x0e30, 0x0e40), //
-    _MK_MAPPING(0x003000, 0x0e40, 0x0e68),  //
-    _MK_MAPPING(HOLE_ADDR, 0x0e68, 0x0e70), //
-    _MK_MAPPING(0x004000, 0x0e70, 0x0e80),  //
-    _MK_MAPPING(0x005000, 0x0e80, 0x0e88),  //
-    _MK_MAPPING(0x006000, 0x0e88, 0x0e90),  //
-    _MK_MAPPING(0x007000, 0x0e90, 0x0ee0),  //
-    _MK_MAPPING(0x008000, 0x0ee0, 0x0f18),  //
-    _MK_MAPPING(0x009000, 0x0f18, 0x0f20),  //
-    _MK_MAPPING(HOLE_ADDR, 0x0f20, 0x0f30), //
-    _MK_MAPPING(0x00a000, 0x0f30, 0x0f40),  //
-    _MK_MAPPING(0x00b000, 0x0f40, 0x0f48),  //
-    _MK_MAPPING(HOLE_ADDR, 0x0f48, 0x0f50), //
-    _MK_MAPPING(0x00e000, 0x0f50, 0x1bd0),  //
-    _MK_MAPPING(HOLE_ADDR, 0x1bd0, 0x1c00), //
-    _MK_MAPPING(0x00f000, 0x1c00, 0x1d00),  //
-    _MK_MAPPING(HOLE_ADDR, 0x1d00, 0x1e00), //
-    _MK_MAPPING(0x010000, 0x1e00, 0x1f90),  //
-    _MK_MAPPING(HOLE_ADDR, 0x1f90, 0x1ff0), //
-    _MK_MAPPING(0x00c000, 0x1ff0, 0x2000),  //
-};
+#define EEPROM_SIZE 0x2000
+
+// Sorted by EEPROM addr, contiguous
+#define ADDR_MAPPING_LIST(X, A)           \
+    X(0x000000, 0x0000, 0x0c80, A)        \
+    X(0x001000, 0x0c80, 0x0d60, A)        \
+    X(0x002000, 0x0d60, 0x0e30, A)        \
+    X(HOLE_ADDR, 0x0e30, 0x0e40, A)       \
+    X(0x003000, 0x0e40, 0x0e68, A)        \
+    X(HOLE_ADDR, 0x0e68, 0x0e70, A)       \
+    X(0x004000, 0x0e70, 0x0e80, A)        \
+    X(0x005000, 0x0e80, 0x0e88, A)        \
+    X(0x006000, 0x0e88, 0x0e90, A)        \
+    X(0x007000, 0x0e90, 0x0ee0, A)        \
+    X(0x008000, 0x0ee0, 0x0f18, A)        \
+    X(0x009000, 0x0f18, 0x0f20, A)        \
+    X(HOLE_ADDR, 0x0f20, 0x0f30, A)       \
+    X(0x00a000, 0x0f30, 0x0f40, A)        \
+    X(0x00b000, 0x0f40, 0x0f48, A)        \
+    X(HOLE_ADDR, 0x0f48, 0x0f50, A)       \
+    X(0x00e000, 0x0f50, 0x1bd0, A)        \
+    X(HOLE_ADDR, 0x1bd0, 0x1c00, A)       \
+    X(0x00f000, 0x1c00, 0x1d00, A)        \
+    X(HOLE_ADDR, 0x1d00, 0x1e00, A)       \
+    X(0x010000, 0x1e00, 0x1f90, A)        \
+    X(HOLE_ADDR, 0x1f90, 0x1ff0, A)       \
+    X(0x00c000, 0x1ff0, EEPROM_SIZE, A)
+
+#define _MK_MAPPING(PY25Q16_Addr, EEPROM_From, EEPROM_To, A) {PY25Q16_Addr, EEPROM_From, EEPROM_To - EEPROM_From},
+
+static const AddrMapping_t ADDR_MAPPINGS[] = {ADDR_MAPPING_LIST(_MK_MAPPING, 0)};
+
+#define MAPPING_COUNT (sizeof(ADDR_MAPPINGS) / sizeof(AddrMapping_t))
+
+// Double-buffered sectors keep their bank footer at the end
+#define _BELOW_FOOTER(PY25Q16_Addr, EEPROM_From, EEPROM_To, A) \
+    &&((PY25Q16_Addr) >= PY25Q16_BANK_END || (PY25Q16_Addr) % 0x1000 + ((EEPROM_To) - (EEPROM_From)) <= PY25Q16_BANK_DATA_SIZE)
+_Static_assert(1 ADDR_MAPPING_LIST(_BELOW_FOOTER, 0), "mapping overlaps a bank footer");
+
+// Index of the mapping containing EEPROM addr A, as a constant expression
+#define _STARTS_AT_OR_BELOW(PY25Q16_Addr, EEPROM_From, EEPROM_To, A) +((EEPROM_From) <= (A))
+#define _FIRST_MAPPING(A) (ADDR_MAPPING_LIST(_STARTS_AT_OR_BELOW, A) - 1)
+
+#define _BLOCKS_4(A) _FIRST_MAPPING(A), _FIRST_MAPPING(A + 0x40), _FIRST_MAPPING(A + 0x80), _FIRST_MAPPING(A + 0xc0)
+#define _BLOCKS_16(A) _BLOCKS_4(A), _BLOCKS_4(A + 0x100), _BLOCKS_4(A + 0x200), _BLOCKS_4(A + 0x300)
+#define _BLOCKS_64(A) _BLOCKS_16(A), _BLOCKS_16(A + 0x400), _BLOCKS_16(A + 0x800), _BLOCKS_16(A + 0xc00)
+
+#define BLOCK_SHIFT 6
+
+// Mapping containing the start of each 64 byte EEPROM block. A block spans
+// at most 3 mappings, so lookup is a table read plus a couple of steps.
+static const uint8_t BLOCK_MAPPING[EEPROM_SIZE >> BLOCK_SHIFT] = {_BLOCKS_64(0x0000), _BLOCKS_64(0x1000)};
 
 static void AddrTranslate(uint16_t EEPROM_Addr, uint16_t Size, uint32_t *PY25Q16_Addr_out, uint16_t *Size_out, bool *End_out);
 
@@ -110,23 +134,36 @@ void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer)
 
 static void AddrTranslate(uint16_t EEPROM_Addr, uint16_t Size, uint32_t *PY25Q16_Addr_out, uint16_t *Size_out, bool *End_out)
 {
-    const AddrMapping_t *p = NULL;
-    for (uint32_t i = 0, N = sizeof(ADDR_MAPPINGS) / sizeof(AddrMapping_t); i < N; i++)
+    if (EEPROM_Addr >= EEPROM_SIZE)
     {
-        p = ADDR_MAPPINGS + i;
-        if (p->EEPROM_Addr <= EEPROM_Addr && EEPROM_Addr < (p->EEPROM_Addr + p->Size))
-        {
-            goto HIT;
-        }
+        *PY25Q16_Addr_out = HOLE_ADDR;
+        *Size_out = Size;
+        return;
     }
 
-    *PY25Q16_Addr_out = HOLE_ADDR;
-    *Size_out = Size;
-    return;
+    uint32_t i = BLOCK_MAPPING[EEPROM_Addr >> BLOCK_SHIFT];
+    while (EEPROM_Addr >= ADDR_MAPPINGS[i].EEPROM_Addr + ADDR_MAPPINGS[i].Size)
+    {
+        i++;
+    }
 
-HIT:
+    const AddrMapping_t *p = ADDR_MAPPINGS + i;
     const uint16_t Off = EEPROM_Addr - p->EEPROM_Addr;
-    const uint16_t Rem = p->Size - Off;
+    uint16_t Rem = p->Size - Off;
+
+    // Coalesce following mappings that continue in flash (or are holes too),
+    // so a large access is one flash transaction
+    while (Size > Rem && ++i < MAPPING_COUNT)
+    {
+        const AddrMapping_t *q = ADDR_MAPPINGS + i;
+        const uint32_t Next = HOLE_ADDR == p->PY25Q16_Addr ? HOLE_ADDR : (p->PY25Q16_Addr + (q->EEPROM_Addr - p->EEPROM_Addr));
+        if (q->PY25Q16_Addr != Next)
+        {
+            break;
+        }
+        Rem += q->Size;
+    }
+
     if (Size > Rem)
     {
         Size = Rem;
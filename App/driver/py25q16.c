@@ -14,9 +14,12 @@
  *     limitations under the License.
  */
 
+#include <stddef.h>
 #include <string.h>
 
+#include "driver/crc.h"
 #include "driver/py25q16.h"
+#include "driver/py25q16_journal.h"
 #include "driver/gpio.h"
 #include "py32f071_ll_bus.h"
 #include "py32f071_ll_system.h"
@@ -37,11 +40,58 @@
 #define SECTOR_SIZE 0x1000
 #define PAGE_SIZE 0x100
 
-static uint32_t SectorCacheAddr = 0x1000000;
-static uint8_t SectorCache[SECTOR_SIZE];
+#define NO_ADDR 0x1000000
+
+// Config sectors 0x000000..0x010fff are double-buffered: each has its home
+// sector and an alternate copy at BANK_ADDR. A write that needs an erase goes
+// to the copy not in use and the footer (sequence number + CRC) is programmed
+// last, so one valid copy exists at every point. A bit-clear write programs
+// the CRC of the new contents in the next free check slot of the footer, then
+// the data in place in the copy in use. If either is torn, that copy fails
+// its check and the other one takes over, as it was before the last write
+// that needed an erase. At boot the newest copy whose last check matches wins.
+#define BANK_ADDR 0x030000
+#define BANK_SECTORS (PY25Q16_BANK_END / SECTOR_SIZE)
+#define BANK_MAGIC 0x4b4e4142 // "BANK"
+#define BANK_CHECKS 6
+#define FOOTER_OFFSET PY25Q16_BANK_DATA_SIZE
+
+typedef struct
+{
+    uint16_t Size; // Bytes covered by Crc, the rest is blank
+    uint16_t Crc;
+} BankCheck_t;
+
+typedef struct
+{
+    uint32_t Magic;
+    uint32_t Seq;
+    BankCheck_t Check[BANK_CHECKS]; // [0] from the erase, then one per update in place
+} BankFooter_t;
+
+_Static_assert(FOOTER_OFFSET + sizeof(BankFooter_t) == SECTOR_SIZE, "bank footer ends the sector");
+
+static uint32_t BankSeq[BANK_SECTORS];
+static uint32_t BankAlt; // Bit set: the alternate copy is in use
+static uint8_t BankNextCheck[BANK_SECTORS]; // Of the copy in use, BANK_CHECKS: none left
+
+static uint32_t SectorCacheAddr = NO_ADDR;
+static uint8_t SectorCache[SECTOR_SIZE] __attribute__((aligned(4)));
+static bool SectorCacheLent;
 static uint8_t BlackHole[1];
 static volatile bool TC_Flag;
 
+// Where the flash is streaming from while CS stays asserted between two
+// queued reads: a read starting there just keeps clocking instead of
+// sending a new command and address. NO_ADDR whenever CS is released, which
+// every read does once the queue is empty, so the flash is back in standby.
+static uint32_t SeqAddr = NO_ADDR;
+
+// 0x0b (fast read, one dummy byte) or 0x03 (read). Dual output read (0x3b)
+// needs MOSI turned around as a second input, which SPI2 in full duplex
+// can't do, and bit-banging both lines is far slower than DMA at PCLK/2.
+static uint8_t ReadOpcode = 0x0b;
+
 static inline void CS_Assert()
 {
     GPIO_ResetOutputPin(CS_PIN);
@@ -50,6 +100,7 @@ static inline void CS_Assert()
 static inline void CS_Release()
 {
     GPIO_SetOutputPin(CS_PIN);
+    SeqAddr = NO_ADDR;
 }
 
 static void SPI_Init()
@@ -102,7 +153,7 @@ static void SPI_Init()
     LL_SPI_Enable(SPIx);
 }
 
-static void SPI_ReadBuf(uint8_t *Buf, uint32_t Size)
+static void SPI_StartReadBuf(uint8_t *Buf, uint32_t Size)
 {
     LL_SPI_Disable(SPIx);
     LL_DMA_DisableChannel(DMA1, CHANNEL_RD);
@@ -146,9 +197,6 @@ static void SPI_ReadBuf(uint8_t *Buf, uint32_t Size)
     LL_SPI_EnableDMAReq_RX(SPIx);
     LL_SPI_Enable(SPIx);
     LL_SPI_EnableDMAReq_TX(SPIx);
-
-    while (!TC_Flag)
-        ;
 }
 
 static void SPI_WriteBuf(const uint8_t *Buf, uint32_t Size)
@@ -210,6 +258,42 @@ static uint8_t SPI_WriteByte(uint8_t Value)
     return LL_SPI_ReceiveData8(SPIx);
 }
 
+static void SPI_ReadBytes(uint8_t *Buf, uint32_t Size)
+{
+    // Keep the next byte queued in the TX FIFO so SCK doesn't idle between bytes
+    while (!LL_SPI_IsActiveFlag_TXE(SPIx))
+        ;
+    LL_SPI_TransmitData8(SPIx, 0xff);
+
+    for (uint32_t i = 0; i < Size; i++)
+    {
+        if (i + 1 < Size)
+        {
+            while (!LL_SPI_IsActiveFlag_TXE(SPIx))
+                ;
+            LL_SPI_TransmitData8(SPIx, 0xff);
+        }
+        while (!LL_SPI_IsActiveFlag_RXNE(SPIx))
+            ;
+        Buf[i] = LL_SPI_ReceiveData8(SPIx);
+    }
+}
+
+typedef struct
+{
+    uint32_t Address;
+    void *pBuffer;
+    uint32_t Size;
+    PY25Q16_Callback_t Callback;
+} ReadRequest_t;
+
+#define READ_QUEUE_LEN 4
+
+// Head is the transfer in flight, if any
+static ReadRequest_t ReadQueue[READ_QUEUE_LEN];
+static volatile uint8_t ReadQueueHead;
+static volatile uint8_t ReadQueueCount;
+
 static void WriteAddr(uint32_t Addr);
 static uint8_t ReadStatusReg(uint32_t Which);
 static void WaitWIP();
@@ -217,43 +301,214 @@ static void WriteEnable();
 static void SectorErase(uint32_t Addr);
 static void SectorProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size);
 static void PageProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size);
+static bool WriteSectors(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append);
+static bool PlanProgram(const uint8_t *pOld, const uint8_t *pNew, uint32_t Size, uint32_t *pFirst, uint32_t *pLast);
+static void BankInit();
+static void BankCommit(uint32_t SecAddr, const uint8_t *pImage, uint32_t Size);
+static void BankUpdate(uint32_t SecIndex, uint32_t Offset, const uint8_t *pData, uint32_t Size, uint32_t Used);
+static void PhysRead(uint32_t Address, void *pBuffer, uint32_t Size);
+
+static inline bool IsBanked(uint32_t Address)
+{
+    return Address < BANK_SECTORS * SECTOR_SIZE;
+}
+
+static inline uint32_t BankPhysAddr(uint32_t SecIndex)
+{
+    return ((BankAlt >> SecIndex) & 1) ? (BANK_ADDR + SecIndex * SECTOR_SIZE) : (SecIndex * SECTOR_SIZE);
+}
 
 void PY25Q16_Init()
 {
     CS_Release();
     SPI_Init();
+    BankInit();
+    JOURNAL_Init();
 }
 
 void PY25Q16_ReadBuffer(uint32_t Address, void *pBuffer, uint32_t Size)
 {
-#ifdef DEBUG
-    printf("spi flash read: %06x %ld\n", Address, Size);
-#endif
+    PY25Q16_RawRead(Address, pBuffer, Size);
+    JOURNAL_Overlay(Address, pBuffer, Size);
+}
+
+static void ReadCommand(uint32_t Address)
+{
+    if (Address == SeqAddr)
+    {
+        // Flash is still streaming from here
+        SeqAddr = NO_ADDR;
+        return;
+    }
+
+    // Ends the previous queued read if it was left open
+    CS_Release();
     CS_Assert();
 
-    SPI_WriteByte(0x03); // Fast read
+    SPI_WriteByte(ReadOpcode);
     WriteAddr(Address);
+    if (0x0b == ReadOpcode)
+    {
+        SPI_WriteByte(0xff); // Dummy
+    }
+}
 
-    if (Size >= 16)
+static void StartRead(const ReadRequest_t *pRequest)
+{
+#ifdef DEBUG
+    printf("spi flash read: %06x %ld\n", pRequest->Address, pRequest->Size);
+#endif
+    ReadCommand(pRequest->Address);
+    SPI_StartReadBuf((uint8_t *)pRequest->pBuffer, pRequest->Size);
+}
+
+static bool QueueRead(uint32_t Address, void *pBuffer, uint32_t Size, PY25Q16_Callback_t Callback)
+{
+    __disable_irq();
+
+    if (ReadQueueCount >= READ_QUEUE_LEN)
     {
-        SPI_ReadBuf((uint8_t *)pBuffer, Size);
+        __enable_irq();
+        return false;
     }
-    else
+
+    ReadRequest_t *pRequest = ReadQueue + (ReadQueueHead + ReadQueueCount) % READ_QUEUE_LEN;
+    pRequest->Address = Address;
+    pRequest->pBuffer = pBuffer;
+    pRequest->Size = Size;
+    pRequest->Callback = Callback;
+
+    if (1 == ++ReadQueueCount)
     {
-        for (uint32_t i = 0; i < Size; i++)
+        StartRead(pRequest);
+    }
+
+    __enable_irq();
+    return true;
+}
+
+static inline void WaitIdle()
+{
+    while (ReadQueueCount)
+        ;
+}
+
+bool PY25Q16_ReadAsync(uint32_t Address, void *pBuffer, uint32_t Size, PY25Q16_Callback_t Callback)
+{
+    bool Journaled;
+
+    if (0 == Size)
+    {
+        return false;
+    }
+
+    const bool OneSector = Address / SECTOR_SIZE == (Address + Size - 1) / SECTOR_SIZE;
+
+    if ((IsBanked(Address) && !OneSector) || JOURNAL_Span(Address, Size, &Journaled) != Size || Journaled)
+    {
+        // Needs the journal overlay or spans bank copies: done synchronously
+        PY25Q16_ReadBuffer(Address, pBuffer, Size);
+        if (Callback)
         {
-            ((uint8_t *)(pBuffer))[i] = SPI_WriteByte(0xff);
+            Callback(pBuffer, Size);
         }
+        return true;
+    }
+
+    if (IsBanked(Address))
+    {
+        Address = BankPhysAddr(Address / SECTOR_SIZE) + Address % SECTOR_SIZE;
+    }
+
+    return QueueRead(Address, pBuffer, Size, Callback);
+}
+
+bool PY25Q16_IsBusy()
+{
+    return ReadQueueCount != 0;
+}
+
+void PY25Q16_RawRead(uint32_t Address, void *pBuffer, uint32_t Size)
+{
+    while (Size && IsBanked(Address))
+    {
+        const uint32_t Offset = Address % SECTOR_SIZE;
+        const uint32_t Len = Size < SECTOR_SIZE - Offset ? Size : SECTOR_SIZE - Offset;
+
+        PhysRead(BankPhysAddr(Address / SECTOR_SIZE) + Offset, pBuffer, Len);
+
+        Address += Len;
+        pBuffer += Len;
+        Size -= Len;
+    }
+
+    if (Size)
+    {
+        PhysRead(Address, pBuffer, Size);
+    }
+}
+
+static void PhysRead(uint32_t Address, void *pBuffer, uint32_t Size)
+{
+    WaitIdle();
+
+    if (Size >= 16)
+    {
+        QueueRead(Address, pBuffer, Size, NULL);
+        WaitIdle();
+        return;
     }
 
+#ifdef DEBUG
+    printf("spi flash read: %06x %ld\n", Address, Size);
+#endif
+    ReadCommand(Address);
+    SPI_ReadBytes(pBuffer, Size);
     CS_Release();
 }
 
-void PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append)
+bool PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append)
 {
 #ifdef DEBUG
     printf("spi flash write: %06x %ld %d\n", Address, Size, Append);
 #endif
+    bool Written = true;
+
+    while (Size)
+    {
+        bool Journaled;
+        const uint32_t Len = JOURNAL_Span(Address, Size, &Journaled);
+
+        if (Journaled)
+        {
+            JOURNAL_Write(Address, pBuffer, Len);
+        }
+        else
+        {
+            Written &= WriteSectors(Address, pBuffer, Len, Append && Len == Size);
+        }
+
+        Address += Len;
+        pBuffer += Len;
+        Size -= Len;
+    }
+
+    return Written;
+}
+
+static bool WriteSectors(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append)
+{
+    // Refused: the cache holds someone else's data until it is returned
+    if (SectorCacheLent)
+    {
+#ifdef DEBUG
+        printf("spi flash write refused, cache lent: %06x %ld\n", Address, Size);
+#endif
+        return false;
+    }
+
+    WaitIdle();
+
     uint32_t SecIndex = Address / SECTOR_SIZE;
     uint32_t SecAddr = SecIndex * SECTOR_SIZE;
     uint32_t SecOffset = Address % SECTOR_SIZE;
@@ -268,25 +523,42 @@ void PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, b
 
         if (SecAddr != SectorCacheAddr)
         {
-            PY25Q16_ReadBuffer(SecAddr, SectorCache, SECTOR_SIZE);
+            PY25Q16_RawRead(SecAddr, SectorCache, SECTOR_SIZE);
             SectorCacheAddr = SecAddr;
         }
 
-        if (0 != memcmp(pBuffer, (char *)SectorCache + SecOffset, SecSize))
+        uint32_t First;
+        uint32_t Last;
+        if (PlanProgram(SectorCache + SecOffset, pBuffer, SecSize, &First, &Last))
         {
-            bool Erase = false;
-            for (uint32_t i = 0; i < SecSize; i++)
+            // Only bits that have to go from 0 to 1 need an erase
+            const bool Erase = First > Last;
+
+            memcpy(SectorCache + SecOffset, pBuffer, SecSize);
+
+            if (IsBanked(SecAddr))
             {
-                if (0xff != SectorCache[SecOffset + i])
+                if (Erase && Append)
                 {
-                    Erase = true;
-                    break;
+                    memset(SectorCache + SecOffset + SecSize, 0xff, SECTOR_SIZE - SecOffset - SecSize);
+                }
+                // Blank tail needs no programming
+                uint32_t Used = FOOTER_OFFSET;
+                while (Used && 0xff == SectorCache[Used - 1])
+                {
+                    Used--;
                 }
-            }
-
-            memcpy(SectorCache + SecOffset, pBuffer, SecSize);
 
-            if (Erase)
+                if (!Erase && BankNextCheck[SecIndex] < BANK_CHECKS && SecOffset + Last < FOOTER_OFFSET)
+                {
+                    BankUpdate(SecIndex, SecOffset + First, pBuffer + First, Last - First + 1, Used);
+                }
+                else
+                {
+                    BankCommit(SecAddr, SectorCache, Used);
+                }
+            }
+            else if (Erase)
             {
                 SectorErase(SecAddr);
                 if (Append)
@@ -301,7 +573,8 @@ void PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, b
             }
             else
             {
-                SectorProgram(Address, pBuffer, SecSize);
+                // Bit-clear only: program just the changed bytes
+                SectorProgram(Address + First, pBuffer + First, Last - First + 1);
             }
         }
 
@@ -309,22 +582,272 @@ void PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, b
         pBuffer += SecSize;
         Size -= SecSize;
 
+        SecIndex++;
         SecAddr += SECTOR_SIZE;
         SecOffset = 0;
         SecSize = SECTOR_SIZE;
     } // while
+
+    return true;
+}
+
+// Returns false if pNew is already in flash. Otherwise the changed bytes are
+// pNew[*pFirst..*pLast], or *pFirst > *pLast if some bit has to be set back to 1,
+// which programming can't do.
+static bool PlanProgram(const uint8_t *pOld, const uint8_t *pNew, uint32_t Size, uint32_t *pFirst, uint32_t *pLast)
+{
+    bool Changed = false;
+
+    for (uint32_t i = 0; i < Size; i++)
+    {
+        if (pOld[i] == pNew[i])
+        {
+            continue;
+        }
+
+        if ((pOld[i] & pNew[i]) != pNew[i])
+        {
+            *pFirst = 1;
+            *pLast = 0;
+            return true;
+        }
+
+        if (!Changed)
+        {
+            *pFirst = i;
+            Changed = true;
+        }
+        *pLast = i;
+    }
+
+    return Changed;
 }
 
 void PY25Q16_SectorErase(uint32_t Address)
 {
     Address -= (Address % SECTOR_SIZE);
-    SectorErase(Address);
+    PY25Q16_RawSectorErase(Address);
+    JOURNAL_Discard(Address, SECTOR_SIZE);
+}
+
+void PY25Q16_RawSectorErase(uint32_t Address)
+{
+    WaitIdle();
+
+    Address -= (Address % SECTOR_SIZE);
     if (SectorCacheAddr == Address)
     {
         memset(SectorCache, 0xff, SECTOR_SIZE);
     }
+
+    if (IsBanked(Address))
+    {
+        // Blank copy, the old one stays valid until its footer is superseded
+        BankCommit(Address, NULL, 0);
+        return;
+    }
+
+    SectorErase(Address);
+}
+
+void *PY25Q16_BorrowSectorCache(void)
+{
+    WaitIdle();
+
+    // Forget the cached sector: the next write reads it again
+    SectorCacheAddr = NO_ADDR;
+    SectorCacheLent = true;
+    return SectorCache;
+}
+
+void PY25Q16_ReturnSectorCache(void)
+{
+    SectorCacheLent = false;
+}
+
+bool PY25Q16_IsSectorCacheLent(void)
+{
+    return SectorCacheLent;
+}
+
+static bool BankReadFooter(uint32_t PhysAddr, BankFooter_t *pFooter)
+{
+    PhysRead(PhysAddr + FOOTER_OFFSET, pFooter, sizeof(*pFooter));
+    return BANK_MAGIC == pFooter->Magic && pFooter->Check[0].Size <= FOOTER_OFFSET;
+}
+
+// Slots are programmed in order: the last one not blank is current, even
+// torn, which then fails the check
+static uint32_t BankLastCheck(const BankFooter_t *pFooter)
+{
+    uint32_t i = BANK_CHECKS - 1;
+
+    while (i && 0xffff == pFooter->Check[i].Size && 0xffff == pFooter->Check[i].Crc)
+    {
+        i--;
+    }
+    return i;
+}
+
+static bool BankVerify(uint32_t PhysAddr, const BankFooter_t *pFooter)
+{
+    const BankCheck_t *pCheck = pFooter->Check + BankLastCheck(pFooter);
+
+    if (pCheck->Size > FOOTER_OFFSET)
+    {
+        return false;
+    }
+    PhysRead(PhysAddr, SectorCache, pCheck->Size);
+    return pCheck->Crc == CRC_Calculate(SectorCache, pCheck->Size);
 }
 
+static void BankInit()
+{
+    BankAlt = 0;
+
+    for (uint32_t i = 0; i < BANK_SECTORS; i++)
+    {
+        BankFooter_t Home;
+        BankFooter_t Alt;
+        const bool HomeValid = BankReadFooter(i * SECTOR_SIZE, &Home);
+        const bool AltValid = BankReadFooter(BANK_ADDR + i * SECTOR_SIZE, &Alt);
+
+        // No footer at home is a sector from before double-buffering: sequence 0
+        BankSeq[i] = HomeValid ? Home.Seq : 0;
+        if (AltValid && Alt.Seq > BankSeq[i])
+        {
+            BankSeq[i] = Alt.Seq;
+        }
+
+        // Newest copy with a good CRC, falling back to the other one
+        bool UseAlt = AltValid && (!HomeValid || Alt.Seq > Home.Seq);
+        if (UseAlt)
+        {
+            UseAlt = BankVerify(BANK_ADDR + i * SECTOR_SIZE, &Alt);
+        }
+        else if (HomeValid && !BankVerify(i * SECTOR_SIZE, &Home))
+        {
+            UseAlt = AltValid && BankVerify(BANK_ADDR + i * SECTOR_SIZE, &Alt);
+        }
+
+        // A home sector without footer takes its first write as a commit
+        if (UseAlt)
+        {
+            BankAlt |= 1u << i;
+            BankNextCheck[i] = BankLastCheck(&Alt) + 1;
+        }
+        else
+        {
+            BankNextCheck[i] = HomeValid ? BankLastCheck(&Home) + 1 : BANK_CHECKS;
+        }
+
+#ifdef DEBUG
+        printf("spi flash bank %d: %s seq %ld\n", i, ((BankAlt >> i) & 1) ? "alt" : "home", BankSeq[i]);
+#endif
+    }
+
+    SectorCacheAddr = NO_ADDR;
+}
+
+static void BankCommit(uint32_t SecAddr, const uint8_t *pImage, uint32_t Size)
+{
+    const uint32_t SecIndex = SecAddr / SECTOR_SIZE;
+    const uint32_t Target = ((BankAlt >> SecIndex) & 1) ? SecAddr : (BANK_ADDR + SecAddr);
+    BankFooter_t Footer;
+
+    memset(&Footer, 0xff, sizeof(Footer));
+    Footer.Magic = BANK_MAGIC;
+    Footer.Seq = BankSeq[SecIndex] + 1;
+    Footer.Check[0].Size = Size;
+    Footer.Check[0].Crc = CRC_Calculate(pImage, Size);
+
+    SectorErase(Target);
+    SectorProgram(Target, pImage, Size);
+    SectorProgram(Target + FOOTER_OFFSET, (const uint8_t *)&Footer, sizeof(Footer));
+
+    BankSeq[SecIndex] = Footer.Seq;
+    BankAlt ^= 1u << SecIndex;
+    BankNextCheck[SecIndex] = 1;
+}
+
+// Bit-clear write to the copy in use, SectorCache holds its new contents.
+// The check goes first: the old one may not cover the bytes written, so a
+// torn write would pass it.
+static void BankUpdate(uint32_t SecIndex, uint32_t Offset, const uint8_t *pData, uint32_t Size, uint32_t Used)
+{
+    const uint32_t Phys = BankPhysAddr(SecIndex);
+    const BankCheck_t Check = {Used, CRC_Calculate(SectorCache, Used)};
+
+    SectorProgram(Phys + FOOTER_OFFSET + offsetof(BankFooter_t, Check) + BankNextCheck[SecIndex] * sizeof(Check),
+                  (const uint8_t *)&Check, sizeof(Check));
+    SectorProgram(Phys + Offset, pData, Size);
+
+    BankNextCheck[SecIndex]++;
+}
+
+void PY25Q16_RawProgram(uint32_t Address, const void *pBuffer, uint32_t Size)
+{
+    // No erase: only clears bits of the target bytes
+    WaitIdle();
+
+    if (SectorCacheAddr == Address - (Address % SECTOR_SIZE))
+    {
+        SectorCacheAddr = NO_ADDR;
+    }
+    SectorProgram(Address, pBuffer, Size);
+}
+
+#ifdef ENABLE_UART_BENCHMARK
+static uint32_t BenchRead(uint32_t Chunk, bool Queued)
+{
+    // Reads 64 KiB of the voice area, returns bytes/s
+    const uint32_t Total = 0x10000;
+    const uint32_t Start = SYSTICK_GetUs();
+
+    for (uint32_t Offset = 0; Offset < Total; Offset += Chunk)
+    {
+        if (Queued)
+        {
+            // Back to back in the queue, each continues the previous one
+            while (!QueueRead(0x14c000 + Offset, SectorCache + Offset % SECTOR_SIZE, Chunk, NULL))
+                ;
+        }
+        else
+        {
+            PY25Q16_RawRead(0x14c000 + Offset, SectorCache, Chunk);
+        }
+    }
+    WaitIdle();
+
+    const uint32_t Elapsed = SYSTICK_GetUs() - Start;
+    return Elapsed ? (uint64_t)Total * 1000000 / Elapsed : 0;
+}
+
+void PY25Q16_Benchmark(PY25Q16_Benchmark_t *pResult)
+{
+    const uint8_t Opcode = ReadOpcode;
+
+    // Reads into the sector cache
+    if (SectorCacheLent)
+    {
+        memset(pResult, 0, sizeof(*pResult));
+        return;
+    }
+
+    WaitIdle();
+    SectorCacheAddr = NO_ADDR;
+
+    ReadOpcode = 0x03;
+    pResult->Read = BenchRead(256, false);
+    ReadOpcode = 0x0b;
+    pResult->FastRead = BenchRead(256, false);
+    pResult->Sequential = BenchRead(16, true);
+    pResult->Small = BenchRead(8, false);
+
+    ReadOpcode = Opcode;
+}
+#endif
+
 static inline void WriteAddr(uint32_t Addr)
 {
     SPI_WriteByte(0xff & (Addr >> 16));
@@ -465,5 +988,27 @@ void DMA1_Channel4_5_6_7_IRQHandler()
         LL_SPI_DisableDMAReq_RX(SPIx);
 
         TC_Flag = true;
+
+        if (ReadQueueCount)
+        {
+            // Queued read done: chain the next one before notifying
+            const ReadRequest_t Done = ReadQueue[ReadQueueHead];
+
+            ReadQueueHead = (ReadQueueHead + 1) % READ_QUEUE_LEN;
+            if (--ReadQueueCount)
+            {
+                SeqAddr = Done.Address + Done.Size;
+                StartRead(ReadQueue + ReadQueueHead);
+            }
+            else
+            {
+                CS_Release();
+            }
+
+            if (Done.Callback)
+            {
+                Done.Callback(Done.pBuffer, Done.Size);
+            }
+        }
     }
 }
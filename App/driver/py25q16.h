@@ -20,9 +20,46 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Config sectors below PY25Q16_BANK_END are double-buffered, with a footer
+// after the first PY25Q16_BANK_DATA_SIZE bytes of each: data stays below it
+#define PY25Q16_BANK_END 0x011000
+#define PY25Q16_BANK_DATA_SIZE 0xfe0
+
+// Called from the DMA interrupt once the data is in the buffer
+typedef void (*PY25Q16_Callback_t)(void *pBuffer, uint32_t Size);
+
 void PY25Q16_Init();
+bool PY25Q16_ReadAsync(uint32_t Address, void *pBuffer, uint32_t Size, PY25Q16_Callback_t Callback);
+bool PY25Q16_IsBusy();
 void PY25Q16_ReadBuffer(uint32_t Address, void *pBuffer, uint32_t Size);
-void PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append);
+bool PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append);
 void PY25Q16_SectorErase(uint32_t Address);
 
+// Raw access, bypassing the settings journal (see py25q16_journal.c).
+// Double-buffered config sectors are not for RawProgram.
+void PY25Q16_RawRead(uint32_t Address, void *pBuffer, uint32_t Size);
+void PY25Q16_RawProgram(uint32_t Address, const void *pBuffer, uint32_t Size);
+void PY25Q16_RawSectorErase(uint32_t Address);
+
+// The 4 KB sector buffer, word aligned, as scratch RAM. Until it is
+// returned, PY25Q16_WriteBuffer() refuses writes outside the journal and
+// returns false.
+void *PY25Q16_BorrowSectorCache(void);
+void PY25Q16_ReturnSectorCache(void);
+bool PY25Q16_IsSectorCacheLent(void);
+
+#ifdef ENABLE_UART_BENCHMARK
+// Read throughput in bytes/s
+typedef struct
+{
+    uint32_t Read;       // 0x03, new command per 256 bytes
+    uint32_t FastRead;   // 0x0b, new command per 256 bytes
+    uint32_t Sequential; // 16 byte queued reads continuing the previous one
+    uint32_t Small;      // 8 byte reads, new command each
+} PY25Q16_Benchmark_t;
+
+// All zero while the sector cache is lent
+void PY25Q16_Benchmark(PY25Q16_Benchmark_t *pResult);
+#endif
+
 #endif
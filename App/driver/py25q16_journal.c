@@ -0,0 +1,539 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+/**
+ * -----------------------------------
+ * Settings journal
+ *
+ *    The small, frequently saved config blocks (see RANGES) are never
+ *    rewritten in place. Every changed 8-byte chunk is appended as a 16-byte
+ *    record to the active journal sector, which costs a single page program
+ *    instead of a sector read-modify-write.
+ *
+ *    A RAM index remembers the newest record of each chunk; reads of the home
+ *    address are patched from there (JOURNAL_Overlay). When the active sector
+ *    is full, the live records are copied to the next sector of the ring, so
+ *    there is one erase per ~170 saves, spread over JOURNAL_SECTORS sectors.
+ *
+ *    The sector header is programmed last: a sector without a valid header is
+ *    ignored at boot and the previous one is used instead. A record torn by
+ *    a power cut fails its CRC and is skipped; its slot is not reused.
+ *
+ *    Writes are deferred: changed chunks wait in a small write-back table,
+ *    where repeated saves of the same chunk coalesce, and are committed one
+ *    record per 10 ms tick by JOURNAL_FlushStep(). Call JOURNAL_FlushAll()
+ *    before a reset.
+ * ------------------------------------
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "driver/crc.h"
+#include "driver/py25q16.h"
+#include "driver/py25q16_journal.h"
+
+// #define DEBUG
+
+#ifdef DEBUG
+    #include "external/printf/printf.h"
+#endif
+
+#define SECTOR_SIZE 0x1000
+#define RECORD_SIZE 16
+#define CHUNK_SIZE 8
+#define RECORDS_PER_SECTOR (SECTOR_SIZE / RECORD_SIZE) // slot 0 is the header
+#define RECORDS_PER_PAGE 16
+
+#define JOURNAL_MAGIC 0x4c4e524a // "JRNL"
+
+#define PENDING_COUNT 8
+#define PENDING_HOLD_10ms 50 // coalescing window
+
+typedef struct
+{
+    uint32_t Magic;
+    uint32_t Seq;
+    uint32_t Reserved[2];
+} JournalHeader_t;
+
+typedef struct
+{
+    uint32_t Addr; // Home address of the chunk
+    uint8_t Data[CHUNK_SIZE];
+    uint16_t Crc; // Over Addr and Data
+    uint16_t Reserved;
+} JournalRecord_t;
+
+typedef struct
+{
+    uint32_t Addr;
+    uint16_t Size;
+    uint16_t Base; // Index of the first chunk
+} JournalRange_t;
+
+typedef struct
+{
+    uint32_t Addr; // Home address of the chunk, 0 = free
+    uint8_t Data[CHUNK_SIZE];
+    uint8_t Age; // In 10 ms ticks since the last update
+} Pending_t;
+
+static const JournalRange_t RANGES[] = {
+    // Sorted by address
+    {0x001000, 0xe0, 0},  // 0C80..0D60 VFOs
+    {0x002000, 0xe0, 28}, // 0D60..0E40 channel attributes
+    {0x003000, 0x28, 56}, // 0E40..0E68 FM channels
+    {0x004000, 0x10, 61}, // 0E70..0E80
+    {0x005000, 0x08, 63}, // 0E80..0E88
+    {0x006000, 0x08, 64}, // 0E88..0E90
+    {0x007000, 0x50, 65}, // 0E90..0EE0
+    {0x009000, 0x08, 75}, // 0F18..0F20
+    {0x00b000, 0x08, 76}, // 0F40..0F48
+    {0x00c000, 0x10, 77}, // 1FF0..2000
+};
+
+#define CHUNK_COUNT 79
+#define RANGES_END 0x00c010
+
+_Static_assert(sizeof(JournalHeader_t) == RECORD_SIZE, "journal header size");
+_Static_assert(sizeof(JournalRecord_t) == RECORD_SIZE, "journal record size");
+
+// Position of the newest record of each chunk: sector * RECORDS_PER_SECTOR + slot, 0 = none
+static uint16_t Index[CHUNK_COUNT];
+
+static uint8_t ActiveSector;
+static uint16_t NextSlot;
+static uint32_t ActiveSeq;
+
+static Pending_t Pending[PENDING_COUNT];
+
+static inline uint32_t SectorAddr(uint8_t Sector)
+{
+    return JOURNAL_ADDR + Sector * SECTOR_SIZE;
+}
+
+static inline uint32_t RecordAddr(uint16_t Pos)
+{
+    return SectorAddr(Pos / RECORDS_PER_SECTOR) + (Pos % RECORDS_PER_SECTOR) * RECORD_SIZE;
+}
+
+static const JournalRange_t *FindRange(uint32_t Address)
+{
+    if (Address >= RANGES_END)
+    {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < sizeof(RANGES) / sizeof(RANGES[0]); i++)
+    {
+        const JournalRange_t *p = RANGES + i;
+        if (p->Addr <= Address && Address < p->Addr + p->Size)
+        {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+static uint16_t RecordCrc(const JournalRecord_t *pRecord)
+{
+    return CRC_Calculate(pRecord, offsetof(JournalRecord_t, Crc));
+}
+
+static bool IsBlank(const JournalRecord_t *pRecord)
+{
+    const uint32_t *p = (const uint32_t *)pRecord;
+
+    for (uint32_t i = 0; i < sizeof(*pRecord) / sizeof(uint32_t); i++)
+    {
+        if (0xffffffff != p[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void WriteHeader(uint8_t Sector, uint32_t Seq)
+{
+    const JournalHeader_t Header = {JOURNAL_MAGIC, Seq, {0xffffffff, 0xffffffff}};
+    PY25Q16_RawProgram(SectorAddr(Sector), &Header, sizeof(Header));
+}
+
+static void Compact(void)
+{
+    const uint8_t Sector = (ActiveSector + 1) % JOURNAL_SECTORS;
+    uint16_t Slot = 1;
+
+#ifdef DEBUG
+    printf("journal compact: %d -> %d\n", ActiveSector, Sector);
+#endif
+
+    PY25Q16_RawSectorErase(SectorAddr(Sector));
+
+    for (uint32_t i = 0; i < CHUNK_COUNT; i++)
+    {
+        if (0 == Index[i])
+        {
+            continue;
+        }
+
+        JournalRecord_t Record;
+        PY25Q16_RawRead(RecordAddr(Index[i]), &Record, sizeof(Record));
+
+        const uint16_t Pos = Sector * RECORDS_PER_SECTOR + Slot;
+        PY25Q16_RawProgram(RecordAddr(Pos), &Record, sizeof(Record));
+        Index[i] = Pos;
+        Slot++;
+    }
+
+    WriteHeader(Sector, ActiveSeq + 1);
+
+    ActiveSector = Sector;
+    ActiveSeq++;
+    NextSlot = Slot;
+}
+
+static void Append(const JournalRange_t *pRange, uint32_t ChunkAddr, const uint8_t *pData)
+{
+    if (NextSlot >= RECORDS_PER_SECTOR)
+    {
+        Compact();
+    }
+
+    JournalRecord_t Record;
+    Record.Addr = ChunkAddr;
+    memcpy(Record.Data, pData, CHUNK_SIZE);
+    Record.Crc = RecordCrc(&Record);
+    Record.Reserved = 0xffff;
+
+    const uint16_t Pos = ActiveSector * RECORDS_PER_SECTOR + NextSlot;
+    PY25Q16_RawProgram(RecordAddr(Pos), &Record, sizeof(Record));
+    NextSlot++;
+
+    Index[pRange->Base + (ChunkAddr - pRange->Addr) / CHUNK_SIZE] = Pos;
+}
+
+static void ReadCommitted(uint32_t ChunkAddr, uint8_t *pData)
+{
+    PY25Q16_RawRead(ChunkAddr, pData, CHUNK_SIZE);
+
+    const JournalRange_t *pRange = FindRange(ChunkAddr);
+    const uint16_t Pos = Index[pRange->Base + (ChunkAddr - pRange->Addr) / CHUNK_SIZE];
+    if (Pos)
+    {
+        PY25Q16_RawRead(RecordAddr(Pos) + offsetof(JournalRecord_t, Data), pData, CHUNK_SIZE);
+    }
+}
+
+static void Commit(Pending_t *pPending)
+{
+    uint8_t Data[CHUNK_SIZE];
+
+    ReadCommitted(pPending->Addr, Data);
+    if (0 != memcmp(Data, pPending->Data, CHUNK_SIZE))
+    {
+        Append(FindRange(pPending->Addr), pPending->Addr, pPending->Data);
+    }
+
+    pPending->Addr = 0;
+}
+
+static Pending_t *Oldest(uint8_t MinAge)
+{
+    Pending_t *pOldest = NULL;
+
+    for (uint32_t i = 0; i < PENDING_COUNT; i++)
+    {
+        Pending_t *p = Pending + i;
+        if (p->Addr && p->Age >= MinAge && (NULL == pOldest || p->Age > pOldest->Age))
+        {
+            pOldest = p;
+        }
+    }
+
+    return pOldest;
+}
+
+static void Enqueue(uint32_t ChunkAddr, const uint8_t *pData)
+{
+    Pending_t *pFree = NULL;
+
+    for (uint32_t i = 0; i < PENDING_COUNT; i++)
+    {
+        Pending_t *p = Pending + i;
+        if (ChunkAddr == p->Addr)
+        {
+            memcpy(p->Data, pData, CHUNK_SIZE);
+            p->Age = 0;
+            return;
+        }
+        if (0 == p->Addr && NULL == pFree)
+        {
+            pFree = p;
+        }
+    }
+
+    if (NULL == pFree)
+    {
+        // Table full: make room synchronously
+        pFree = Oldest(0);
+        Commit(pFree);
+    }
+
+    pFree->Addr = ChunkAddr;
+    memcpy(pFree->Data, pData, CHUNK_SIZE);
+    pFree->Age = 0;
+}
+
+void JOURNAL_Init(void)
+{
+    bool Found = false;
+
+    memset(Index, 0, sizeof(Index));
+    memset(Pending, 0, sizeof(Pending));
+
+    for (uint8_t i = 0; i < JOURNAL_SECTORS; i++)
+    {
+        JournalHeader_t Header;
+        PY25Q16_RawRead(SectorAddr(i), &Header, sizeof(Header));
+        if (JOURNAL_MAGIC == Header.Magic && (!Found || Header.Seq > ActiveSeq))
+        {
+            Found = true;
+            ActiveSector = i;
+            ActiveSeq = Header.Seq;
+        }
+    }
+
+    if (!Found)
+    {
+        // Virgin journal: nothing to replay
+        ActiveSector = 0;
+        ActiveSeq = 1;
+        NextSlot = 1;
+        PY25Q16_RawSectorErase(SectorAddr(ActiveSector));
+        WriteHeader(ActiveSector, ActiveSeq);
+        return;
+    }
+
+    // Append after the last slot holding anything: a torn record, even one
+    // whose Addr never got programmed, can't be programmed over
+    NextSlot = 1;
+
+    for (uint16_t Slot = 0; Slot < RECORDS_PER_SECTOR; Slot += RECORDS_PER_PAGE)
+    {
+        JournalRecord_t Page[RECORDS_PER_PAGE];
+        PY25Q16_RawRead(SectorAddr(ActiveSector) + Slot * RECORD_SIZE, Page, sizeof(Page));
+
+        for (uint16_t i = (0 == Slot) ? 1 : 0; i < RECORDS_PER_PAGE; i++)
+        {
+            const JournalRecord_t *pRecord = Page + i;
+
+            if (IsBlank(pRecord))
+            {
+                continue;
+            }
+
+            NextSlot = Slot + i + 1;
+
+            if (pRecord->Crc != RecordCrc(pRecord))
+            {
+                // Torn write, skip it
+                continue;
+            }
+
+            const JournalRange_t *pRange = FindRange(pRecord->Addr);
+            if (pRange)
+            {
+                Index[pRange->Base + (pRecord->Addr - pRange->Addr) / CHUNK_SIZE] = ActiveSector * RECORDS_PER_SECTOR + Slot + i;
+            }
+        }
+    }
+
+#ifdef DEBUG
+    printf("journal init: sector %d, seq %ld, next %d\n", ActiveSector, ActiveSeq, NextSlot);
+#endif
+    return;
+}
+
+uint32_t JOURNAL_Span(uint32_t Address, uint32_t Size, bool *pJournaled)
+{
+    uint32_t Next = RANGES_END;
+
+    for (uint32_t i = 0; i < sizeof(RANGES) / sizeof(RANGES[0]); i++)
+    {
+        const JournalRange_t *p = RANGES + i;
+        if (p->Addr <= Address && Address < p->Addr + p->Size)
+        {
+            *pJournaled = true;
+            const uint32_t Rem = p->Addr + p->Size - Address;
+            return Size < Rem ? Size : Rem;
+        }
+        if (p->Addr > Address && p->Addr < Next)
+        {
+            Next = p->Addr;
+        }
+    }
+
+    *pJournaled = false;
+    if (Address < Next && Next - Address < Size)
+    {
+        return Next - Address;
+    }
+    return Size;
+}
+
+void JOURNAL_Overlay(uint32_t Address, void *pBuffer, uint32_t Size)
+{
+    if (Address >= RANGES_END)
+    {
+        return;
+    }
+
+    const uint32_t End = Address + Size;
+
+    for (uint32_t i = 0; i < sizeof(RANGES) / sizeof(RANGES[0]); i++)
+    {
+        const JournalRange_t *p = RANGES + i;
+        const uint32_t From = Address > p->Addr ? Address : p->Addr;
+        const uint32_t To = End < p->Addr + p->Size ? End : p->Addr + p->Size;
+
+        for (uint32_t ChunkAddr = From & ~(CHUNK_SIZE - 1); ChunkAddr < To; ChunkAddr += CHUNK_SIZE)
+        {
+            const uint16_t Pos = Index[p->Base + (ChunkAddr - p->Addr) / CHUNK_SIZE];
+            if (0 == Pos)
+            {
+                continue;
+            }
+
+            uint8_t Data[CHUNK_SIZE];
+            PY25Q16_RawRead(RecordAddr(Pos) + offsetof(JournalRecord_t, Data), Data, CHUNK_SIZE);
+
+            const uint32_t Lo = From > ChunkAddr ? From : ChunkAddr;
+            const uint32_t Hi = To < ChunkAddr + CHUNK_SIZE ? To : ChunkAddr + CHUNK_SIZE;
+            memcpy((uint8_t *)pBuffer + (Lo - Address), Data + (Lo - ChunkAddr), Hi - Lo);
+        }
+    }
+
+    for (uint32_t i = 0; i < PENDING_COUNT; i++)
+    {
+        const Pending_t *p = Pending + i;
+        if (0 == p->Addr || p->Addr + CHUNK_SIZE <= Address || p->Addr >= End)
+        {
+            continue;
+        }
+
+        const uint32_t Lo = Address > p->Addr ? Address : p->Addr;
+        const uint32_t Hi = End < p->Addr + CHUNK_SIZE ? End : p->Addr + CHUNK_SIZE;
+        memcpy((uint8_t *)pBuffer + (Lo - Address), p->Data + (Lo - p->Addr), Hi - Lo);
+    }
+}
+
+void JOURNAL_Write(uint32_t Address, const void *pBuffer, uint32_t Size)
+{
+    // Caller guarantees [Address, Address + Size) lies in a single range (see JOURNAL_Span)
+
+    if (NULL == FindRange(Address))
+    {
+        return;
+    }
+
+    const uint32_t End = Address + Size;
+
+    for (uint32_t ChunkAddr = Address & ~(CHUNK_SIZE - 1); ChunkAddr < End; ChunkAddr += CHUNK_SIZE)
+    {
+        uint8_t Data[CHUNK_SIZE];
+        uint8_t New[CHUNK_SIZE];
+
+        PY25Q16_ReadBuffer(ChunkAddr, Data, CHUNK_SIZE);
+        memcpy(New, Data, CHUNK_SIZE);
+
+        const uint32_t Lo = Address > ChunkAddr ? Address : ChunkAddr;
+        const uint32_t Hi = End < ChunkAddr + CHUNK_SIZE ? End : ChunkAddr + CHUNK_SIZE;
+        memcpy(New + (Lo - ChunkAddr), (const uint8_t *)pBuffer + (Lo - Address), Hi - Lo);
+
+        if (0 != memcmp(New, Data, CHUNK_SIZE))
+        {
+            Enqueue(ChunkAddr, New);
+        }
+    }
+}
+
+void JOURNAL_Discard(uint32_t Address, uint32_t Size)
+{
+    // The home sector is being erased: mask older records with blank ones
+
+    static const uint8_t Blank[CHUNK_SIZE] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    const uint32_t End = Address + Size;
+
+    for (uint32_t i = 0; i < PENDING_COUNT; i++)
+    {
+        if (Pending[i].Addr >= Address && Pending[i].Addr < End)
+        {
+            Pending[i].Addr = 0;
+        }
+    }
+
+    for (uint32_t i = 0; i < sizeof(RANGES) / sizeof(RANGES[0]); i++)
+    {
+        const JournalRange_t *p = RANGES + i;
+        if (p->Addr + p->Size <= Address || p->Addr >= End)
+        {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < p->Size / CHUNK_SIZE; j++)
+        {
+            if (0 == Index[p->Base + j])
+            {
+                continue;
+            }
+
+            uint8_t Data[CHUNK_SIZE];
+            PY25Q16_RawRead(RecordAddr(Index[p->Base + j]) + offsetof(JournalRecord_t, Data), Data, CHUNK_SIZE);
+            if (0 != memcmp(Data, Blank, CHUNK_SIZE))
+            {
+                Append(p, p->Addr + j * CHUNK_SIZE, Blank);
+            }
+        }
+    }
+}
+
+void JOURNAL_FlushStep(void)
+{
+    for (uint32_t i = 0; i < PENDING_COUNT; i++)
+    {
+        if (Pending[i].Addr && Pending[i].Age < 0xff)
+        {
+            Pending[i].Age++;
+        }
+    }
+
+    // At most one page program per tick
+    Pending_t *p = Oldest(PENDING_HOLD_10ms);
+    if (p)
+    {
+        Commit(p);
+    }
+}
+
+void JOURNAL_FlushAll(void)
+{
+    Pending_t *p;
+    while ((p = Oldest(0)))
+    {
+        Commit(p);
+    }
+}
@@ -0,0 +1,32 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef DRIVER_PY25Q16_JOURNAL_H
+#define DRIVER_PY25Q16_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Ring of sectors holding the settings journal (free area below the voice data)
+#define JOURNAL_ADDR    0x020000
+#define JOURNAL_SECTORS 4
+
+void     JOURNAL_Init(void);
+uint32_t JOURNAL_Span(uint32_t Address, uint32_t Size, bool *pJournaled);
+void     JOURNAL_Overlay(uint32_t Address, void *pBuffer, uint32_t Size);
+void     JOURNAL_Write(uint32_t Address, const void *pBuffer, uint32_t Size);
+void     JOURNAL_Discard(uint32_t Address, uint32_t Size);
+void     JOURNAL_FlushStep(void);
+void     JOURNAL_FlushAll(void);
+
+#endif
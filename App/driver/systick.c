@@ -49,3 +49,23 @@ void SYSTICK_DelayUs(uint32_t Delay)
         Previous = Current;
     } while (elapsed_ticks < ticks);
 }
+
+// Microseconds since boot, wraps after ~71 minutes
+uint32_t SYSTICK_GetUs(void)
+{
+    uint32_t Ticks;
+    uint32_t Val;
+    bool     Pending;
+
+    do {
+        Ticks   = gGlobalSysTickCounter;
+        Val     = SysTick->VAL;
+        Pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+    } while (Ticks != gGlobalSysTickCounter);
+
+    // Counter reloaded but the interrupt not taken yet (IRQs masked)
+    if (Pending && Val > SysTick->LOAD / 2)
+        Ticks++;
+
+    return (Ticks * 10000) + (SysTick->LOAD - Val) / gTickMultiplier;
+}
@@ -19,8 +19,11 @@
 
 #include <stdint.h>
 
+extern volatile uint32_t gGlobalSysTickCounter; // 10 ms ticks, see scheduler.c
+
 void SYSTICK_Init(void);
 void SYSTICK_DelayUs(uint32_t Delay);
+uint32_t SYSTICK_GetUs(void);
 
 #endif
 
@@ -117,6 +117,26 @@ void UART_Send(const void *pBuffer, uint32_t Size)
     }
 }
 
+uint32_t UART_TrySend(const void *pBuffer, uint32_t Size)
+{
+    const uint8_t *pData = (const uint8_t *)pBuffer;
+    uint32_t i;
+
+    // Only what the transmitter takes without waiting
+    for (i = 0; i < Size && LL_USART_IsActiveFlag_TXE(USARTx); i++)
+    {
+        LL_USART_TransmitData8(USARTx, pData[i]);
+    }
+
+    return i;
+}
+
+// Where the DMA writes the next byte into UART_DMA_Buffer
+uint16_t UART_GetRxIndex(void)
+{
+    return sizeof(UART_DMA_Buffer) - LL_DMA_GetDataLength(DMA1, DMA_CHANNEL);
+}
+
 void UART_LogSend(const void *pBuffer, uint32_t Size)
 {
     if (UART_IsLogEnabled) {
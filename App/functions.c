@@ -32,6 +32,9 @@
 #include "driver/st7565.h"
 #include "frequencies.h"
 #include "functions.h"
+#ifdef ENABLE_HEARD_LOG
+    #include "heardlog.h"
+#endif
 #include "helper/battery.h"
 #include "misc.h"
 #include "radio.h"
@@ -248,6 +251,12 @@ void FUNCTION_Select(FUNCTION_Type_t Function)
 
     gCurrentFunction = Function;
 
+#ifdef ENABLE_HEARD_LOG
+    // squelch closed, or RX cut short by TX, scanning, etc.
+    if (PreviousFunction == FUNCTION_RECEIVE && Function != FUNCTION_RECEIVE)
+        HEARDLOG_Close();
+#endif
+
     if (bWasPowerSave && Function != FUNCTION_POWER_SAVE) {
         BK4819_Conditional_RX_TurnOn_and_GPIO6_Enable();
         gRxIdleMode = false;
@@ -0,0 +1,345 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+/**
+ * -----------------------------------
+ * Heard log
+ *
+ *    One HeardRecord_t per reception, from squelch open to squelch close,
+ *    kept in a ring of HEARDLOG_SECTORS sectors. Closed records wait in a
+ *    RAM page buffer and are programmed a page at a time (16 records).
+ *
+ *    The sector after the one being filled is erased as soon as the head
+ *    enters it, so at boot the head is found from the last record of each
+ *    sector plus a binary search in the head sector: no sequence numbers
+ *    and no full scan.
+ * ------------------------------------
+ */
+
+#include <stddef.h>
+
+#include "dcs.h"
+#include "driver/bk4819.h"
+#include "driver/py25q16.h"
+#include "driver/systick.h"
+#include "functions.h"
+#include "heardlog.h"
+#include "misc.h"
+#include "radio.h"
+#include "settings.h"
+
+// Free area above the channel store
+#define HEARDLOG_ADDR 0x052000
+#define HEARDLOG_SECTORS 8
+
+#define SECTOR_SIZE 0x1000
+#define PAGE_SIZE 0x100
+#define RECORDS_PER_SECTOR (SECTOR_SIZE / sizeof(HeardRecord_t))
+#define RECORDS_PER_PAGE (PAGE_SIZE / sizeof(HeardRecord_t))
+#define SLOTS (HEARDLOG_SECTORS * RECORDS_PER_SECTOR)
+
+#define SAMPLE_10ms 10
+
+_Static_assert(sizeof(HeardRecord_t) == 16, "heard record size");
+
+static uint16_t Head; // Next free slot
+static bool Wrapped;  // The sectors after the head one hold old records
+static uint8_t Boot;
+
+static HeardRecord_t Buffer[RECORDS_PER_PAGE]; // Records for Head.., up to the page end
+static uint8_t Buffered;
+
+static HeardRecord_t Current;
+static bool IsOpen;
+static uint8_t SampleCountdown;
+
+static inline uint32_t SlotAddr(uint16_t Slot)
+{
+    return HEARDLOG_ADDR + Slot * sizeof(HeardRecord_t);
+}
+
+static bool IsWritten(uint16_t Slot)
+{
+    uint32_t Frequency;
+
+    PY25Q16_ReadBuffer(SlotAddr(Slot) + offsetof(HeardRecord_t, Frequency), &Frequency, sizeof(Frequency));
+    return 0xffffffff != Frequency;
+}
+
+static inline uint16_t Stored(void)
+{
+    return Wrapped ? (HEARDLOG_SECTORS - 1) * RECORDS_PER_SECTOR + Head % RECORDS_PER_SECTOR : Head;
+}
+
+static inline uint16_t Oldest(void)
+{
+    return Wrapped ? ((Head / RECORDS_PER_SECTOR + 1) % HEARDLOG_SECTORS) * RECORDS_PER_SECTOR : 0;
+}
+
+static inline uint8_t Room(void)
+{
+    return RECORDS_PER_PAGE - Head % RECORDS_PER_PAGE;
+}
+
+// Boot wraps at 256: sessions in the ring are far fewer apart
+static bool IsNewer(const HeardRecord_t *pA, const HeardRecord_t *pB)
+{
+    const int8_t Boots = pA->Boot - pB->Boot;
+    return Boots > 0 || (0 == Boots && pA->Time > pB->Time);
+}
+
+static void ReadFirst(uint8_t Sector, HeardRecord_t *pRecord)
+{
+    PY25Q16_ReadBuffer(SlotAddr(Sector * RECORDS_PER_SECTOR), pRecord, sizeof(*pRecord));
+}
+
+void HEARDLOG_Init(void)
+{
+    uint8_t Full = 0;
+    for (uint8_t i = 0; i < HEARDLOG_SECTORS; i++)
+    {
+        if (IsWritten((i + 1) * RECORDS_PER_SECTOR - 1))
+        {
+            Full |= 1u << i;
+        }
+    }
+
+    if (Full == (1u << HEARDLOG_SECTORS) - 1)
+    {
+        // Power was lost before the head sector got erased, or half way
+        // through. It follows the newest one: half erased, or the first
+        // not newer than the one before. First records are compared, the
+        // last one can be torn.
+        uint8_t Sector = HEARDLOG_SECTORS;
+        for (uint8_t i = 0; i < HEARDLOG_SECTORS && Sector == HEARDLOG_SECTORS; i++)
+        {
+            if (!IsWritten(i * RECORDS_PER_SECTOR))
+            {
+                Sector = i;
+            }
+        }
+
+        HeardRecord_t This;
+        HeardRecord_t Next;
+        ReadFirst(0, &This);
+        for (uint8_t i = 1; i <= HEARDLOG_SECTORS && Sector == HEARDLOG_SECTORS; i++)
+        {
+            ReadFirst(i % HEARDLOG_SECTORS, &Next);
+            if (!IsNewer(&Next, &This))
+            {
+                Sector = i % HEARDLOG_SECTORS;
+            }
+            This = Next;
+        }
+
+        Head = (Sector % HEARDLOG_SECTORS) * RECORDS_PER_SECTOR;
+        Wrapped = true;
+        PY25Q16_RawSectorErase(SlotAddr(Head));
+    }
+    else
+    {
+        // Head sector: not full after a full one, else the first one
+        uint8_t Sector = 0;
+        for (uint8_t i = 0; i < HEARDLOG_SECTORS; i++)
+        {
+            const uint8_t Prev = (i + HEARDLOG_SECTORS - 1) % HEARDLOG_SECTORS;
+            if (!(Full & (1u << i)) && (Full & (1u << Prev)))
+            {
+                Sector = i;
+                break;
+            }
+        }
+
+        uint16_t Low = Sector * RECORDS_PER_SECTOR;
+        uint16_t High = Low + RECORDS_PER_SECTOR - 1; // Known blank
+        while (Low < High)
+        {
+            const uint16_t Mid = (Low + High) / 2;
+            if (IsWritten(Mid))
+                Low = Mid + 1;
+            else
+                High = Mid;
+        }
+
+        Head = Low;
+        Wrapped = IsWritten(((Sector + 1) % HEARDLOG_SECTORS) * RECORDS_PER_SECTOR);
+    }
+
+    Boot = 0;
+    if (Head || Wrapped)
+    {
+        HeardRecord_t Last;
+        PY25Q16_ReadBuffer(SlotAddr((Head + SLOTS - 1) % SLOTS), &Last, sizeof(Last));
+        Boot = Last.Boot + 1;
+    }
+
+    Buffered = 0;
+    IsOpen = false;
+}
+
+void HEARDLOG_Open(void)
+{
+    HEARDLOG_Close();
+
+    Current.Time = gGlobalSysTickCounter;
+    Current.Frequency = gRxVfo->pRX->Frequency;
+    Current.Rssi = 0;
+    Current.Channel = gRxVfo->CHANNEL_SAVE;
+    Current.Boot = Boot;
+
+    // With a code set the squelch only opens on it, otherwise it is detected while listening
+    Current.Flags = gRxVfo->pRX->CodeType;
+    Current.Code = gRxVfo->pRX->CodeType == CODE_TYPE_OFF ? 0 : gRxVfo->pRX->Code;
+#ifdef ENABLE_CHANNEL_ZONES
+    Current.Flags |= gEeprom.CHANNEL_ZONE << 4;
+#endif
+
+    SampleCountdown = 0;
+    IsOpen = true;
+}
+
+void HEARDLOG_Close(void)
+{
+    if (!IsOpen)
+    {
+        return;
+    }
+
+    IsOpen = false;
+
+    const uint32_t Duration = gGlobalSysTickCounter - Current.Time;
+    Current.Duration = Duration > 0xffff ? 0xffff : Duration;
+
+    if (Buffered == Room())
+    {
+        HEARDLOG_Flush();
+    }
+    Buffer[Buffered++] = Current;
+}
+
+static void Sample(void)
+{
+    const uint16_t Rssi = BK4819_GetRSSI();
+    if (Rssi > Current.Rssi)
+    {
+        Current.Rssi = Rssi;
+    }
+
+    if ((Current.Flags & 0x0f) != CODE_TYPE_OFF)
+    {
+        return;
+    }
+
+    uint32_t CdcssFreq;
+    uint16_t CtcssFreq;
+    uint8_t Code;
+    switch (BK4819_GetCxCSSScanResult(&CdcssFreq, &CtcssFreq))
+    {
+        case BK4819_CSS_RESULT_CDCSS:
+            Code = DCS_GetCdcssCode(CdcssFreq);
+            if (Code != 0xff)
+            {
+                Current.Flags |= CODE_TYPE_DIGITAL;
+                Current.Code = Code;
+            }
+            break;
+
+        case BK4819_CSS_RESULT_CTCSS:
+            Code = DCS_GetCtcssCode(CtcssFreq);
+            if (Code != 0xff)
+            {
+                Current.Flags |= CODE_TYPE_CONTINUOUS_TONE;
+                Current.Code = Code;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void HEARDLOG_TimeSlice10ms(void)
+{
+    if (IsOpen && gCurrentFunction == FUNCTION_RECEIVE && SampleCountdown-- == 0)
+    {
+        SampleCountdown = SAMPLE_10ms - 1;
+        Sample();
+    }
+
+    // Page full: one page program
+    if (Buffered && Buffered == Room())
+    {
+        HEARDLOG_Flush();
+    }
+}
+
+void HEARDLOG_Flush(void)
+{
+    if (!Buffered)
+    {
+        return;
+    }
+
+    // A partly filled page is completed later, programming only clears bits
+    PY25Q16_RawProgram(SlotAddr(Head), Buffer, Buffered * sizeof(HeardRecord_t));
+    Head += Buffered;
+    Buffered = 0;
+
+    if (Head % RECORDS_PER_SECTOR == 0)
+    {
+        if (Head == SLOTS)
+        {
+            Head = 0;
+            Wrapped = true;
+        }
+
+        // Drops the oldest sector once wrapped, and marks the head for HEARDLOG_Init()
+        PY25Q16_RawSectorErase(SlotAddr(Head));
+    }
+}
+
+uint16_t HEARDLOG_Count(void)
+{
+    return Stored() + Buffered;
+}
+
+uint8_t HEARDLOG_Read(uint16_t Index, HeardRecord_t *pRecords, uint8_t Max)
+{
+    const uint16_t InFlash = Stored();
+    const uint16_t Total = InFlash + Buffered;
+    uint8_t Count = 0;
+
+    // Index 0 is the oldest record
+    while (Count < Max && Index < Total)
+    {
+        if (Index < InFlash)
+        {
+            const uint16_t Slot = (Oldest() + Index) % SLOTS;
+            uint16_t Run = Max - Count;
+            if (Run > InFlash - Index)
+                Run = InFlash - Index;
+            if (Run > SLOTS - Slot)
+                Run = SLOTS - Slot;
+
+            PY25Q16_ReadBuffer(SlotAddr(Slot), pRecords + Count, Run * sizeof(HeardRecord_t));
+            Count += Run;
+            Index += Run;
+        }
+        else
+        {
+            pRecords[Count++] = Buffer[Index++ - InFlash];
+        }
+    }
+
+    return Count;
+}
@@ -0,0 +1,40 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef HEARDLOG_H
+#define HEARDLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    uint32_t Time;      // 10 ms ticks since boot at squelch open
+    uint32_t Frequency; // 10 Hz units
+    uint16_t Duration;  // 10 ms ticks, saturates at 0xffff
+    uint16_t Rssi;      // Peak BK4819_GetRSSI()
+    uint8_t  Channel;   // CHANNEL_SAVE
+    uint8_t  Flags;     // <3:0> CODE_TYPE_t, <7:4> channel zone
+    uint8_t  Code;      // CTCSS/DCS option index
+    uint8_t  Boot;      // Session counter, tells Time bases apart
+} HeardRecord_t;
+
+void     HEARDLOG_Init(void);
+void     HEARDLOG_Open(void);
+void     HEARDLOG_Close(void);
+void     HEARDLOG_TimeSlice10ms(void);
+void     HEARDLOG_Flush(void);
+uint16_t HEARDLOG_Count(void);
+uint8_t  HEARDLOG_Read(uint16_t Index, HeardRecord_t *pRecords, uint8_t Max);
+
+#endif
@@ -24,6 +24,9 @@
 
 #include "audio.h"
 #include "board.h"
+#ifdef ENABLE_HEARD_LOG
+    #include "heardlog.h"
+#endif
 #include "misc.h"
 #include "radio.h"
 #include "settings.h"
@@ -45,6 +48,9 @@
 
 #include "driver/backlight.h"
 #include "driver/bk4819.h"
+#ifdef ENABLE_BK4819_IRQ
+    #include "driver/bk4819_irq.h"
+#endif
 #include "driver/gpio.h"
 #include "driver/system.h"
 #include "driver/systick.h"
@@ -93,11 +99,14 @@ void Main(void)
     memset(gDTMF_String, '-', sizeof(gDTMF_String));
     gDTMF_String[sizeof(gDTMF_String) - 1] = 0;
 
-    BK4819_Init();
+    BOOT_PROFILE(BK4819_Init, BK4819_Init());
+#ifdef ENABLE_BK4819_IRQ
+    BK4819_IRQ_Init();
+#endif
 
     BOARD_ADC_GetBatteryInfo(&gBatteryCurrentVoltage, &gBatteryCurrent);
 
-    SETTINGS_InitEEPROM();
+    BOOT_PROFILE(SETTINGS_InitEEPROM, SETTINGS_InitEEPROM());
 
     #ifdef ENABLE_FEAT_F4HWN
         gDW = gEeprom.DUAL_WATCH;
@@ -107,12 +116,21 @@ void Main(void)
     SETTINGS_WriteBuildOptions();
     SETTINGS_LoadCalibration();
 
-    RADIO_ConfigureChannel(0, VFO_CONFIGURE_RELOAD);
-    RADIO_ConfigureChannel(1, VFO_CONFIGURE_RELOAD);
+#ifdef ENABLE_HEARD_LOG
+    HEARDLOG_Init();
+#endif
+
+    BOOT_PROFILE(RADIO_ConfigureChannel,
+        RADIO_ConfigureChannel(0, VFO_CONFIGURE_RELOAD);
+        RADIO_ConfigureChannel(1, VFO_CONFIGURE_RELOAD));
 
     RADIO_SelectVfos();
 
-    RADIO_SetupRegisters(true);
+    BOOT_PROFILE(RADIO_SetupRegisters, RADIO_SetupRegisters(true));
+
+#ifdef ENABLE_UART_BENCHMARK
+    gBootProfile.Total = SYSTICK_GetUs();
+#endif
 
     for (unsigned int i = 0; i < ARRAY_SIZE(gBatteryVoltages); i++)
         BOARD_ADC_GetBatteryInfo(&gBatteryVoltages[i], &gBatteryCurrent);
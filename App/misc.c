@@ -320,6 +320,10 @@ uint8_t           gIsLocked = 0xFF;
     uint32_t      gBlinkCounter = 0;
 #endif
 
+#ifdef ENABLE_UART_BENCHMARK
+    BootProfile_t gBootProfile;
+#endif
+
 inline void FUNCTION_NOP() { ; }
 
 
@@ -389,6 +389,31 @@ extern volatile uint8_t      boot_counter_10ms;
     extern uint32_t              gBlinkCounter;
 #endif
 
+#ifdef ENABLE_UART_BENCHMARK
+    // Cold start cost in us, filled in by BOARD_Init() and Main()
+    typedef struct
+    {
+        uint32_t PY25Q16_Init;           // Bank copies checked here
+        uint32_t BK4819_Init;
+        uint32_t SETTINGS_InitEEPROM;
+        uint32_t RADIO_ConfigureChannel;
+        uint32_t RADIO_SetupRegisters;
+        uint32_t Total;                  // SYSTICK_Init() up to here
+    } BootProfile_t;
+
+    extern BootProfile_t         gBootProfile;
+
+    // Needs driver/systick.h
+    #define BOOT_PROFILE(Phase, ...)                      \
+        do {                                              \
+            const uint32_t Start = SYSTICK_GetUs();       \
+            __VA_ARGS__;                                  \
+            gBootProfile.Phase = SYSTICK_GetUs() - Start; \
+        } while (0)
+#else
+    #define BOOT_PROFILE(Phase, ...) do { __VA_ARGS__; } while (0)
+#endif
+
 int32_t NUMBER_AddWithWraparound(int32_t Base, int32_t Add, int32_t LowerLimit, int32_t UpperLimit);
 unsigned long StrToUL(const char * str);
 
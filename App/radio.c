@@ -23,11 +23,13 @@
     #include "app/fm.h"
 #endif
 #include "audio.h"
+#include "chstore.h"
 #include "dcs.h"
 #include "driver/bk4819.h"
 #include "driver/py25q16.h"
 #include "driver/gpio.h"
 #include "driver/system.h"
+#include "driver/systick.h"
 #include "frequencies.h"
 #include "functions.h"
 #include "helper/battery.h"
@@ -240,11 +242,8 @@ void RADIO_ConfigureChannel(const unsigned int VFO, const unsigned int configure
     pVfo->SCANLIST3_PARTICIPATION = bParticipation3;
     pVfo->CHANNEL_SAVE            = channel;
 
-    uint32_t base;
-    if (IS_MR_CHANNEL(channel))
-        base = channel * 16;
-    else
-        base = 0x001000 + ((channel - FREQ_CHANNEL_FIRST) * 32) + (VFO * 16);
+    // memory channels come from the channel store, VFOs from their own block
+    const uint32_t base = 0x001000 + ((channel - FREQ_CHANNEL_FIRST) * 32) + (VFO * 16);
 
     if (configure == VFO_CONFIGURE_RELOAD || IS_FREQ_CHANNEL(channel))
     {
@@ -253,7 +252,10 @@ void RADIO_ConfigureChannel(const unsigned int VFO, const unsigned int configure
         
         // ***************
 
-        PY25Q16_ReadBuffer(base + 8, data, sizeof(data));
+        if (IS_MR_CHANNEL(channel))
+            CHSTORE_ReadRecord(channel, 8, data, sizeof(data));
+        else
+            PY25Q16_ReadBuffer(base + 8, data, sizeof(data));
 
         tmp = data[3] & 0x0F;
         if (tmp > TX_OFFSET_FREQUENCY_DIRECTION_SUB)
@@ -362,7 +364,10 @@ void RADIO_ConfigureChannel(const unsigned int VFO, const unsigned int configure
             uint32_t Frequency;
             uint32_t Offset;
         } __attribute__((packed)) info;
-        PY25Q16_ReadBuffer(base, &info, sizeof(info));
+        if (IS_MR_CHANNEL(channel))
+            CHSTORE_ReadRecord(channel, 0, &info, sizeof(info));
+        else
+            PY25Q16_ReadBuffer(base, &info, sizeof(info));
         if(info.Frequency==0xFFFFFFFF)
             pVfo->freq_config_RX.Frequency = frequencyBandTable[band].lower;
         else
@@ -678,9 +683,43 @@ void RADIO_SelectVfos(void)
     RADIO_SelectCurrentVfo();
 }
 
-void RADIO_SetupRegisters(bool switchToForeground)
+// RX parameters as programmed by RADIO_SetupRegisters() / RADIO_QuickRetune()
+typedef struct
+{
+    uint32_t Frequency;
+    uint8_t  Bandwidth;     // BK4819_FilterBandwidth_t, BK4819_FILTER_BW_AM for AM
+    uint8_t  Squelch[6];    // open/close RSSI, open/close noise, close/open glitch
+    uint8_t  CodeType;
+    uint8_t  Code;
+
+    // Not handled by the fast path, any difference takes the full setup
+    struct {
+        uint8_t Modulation;
+        uint8_t Scramble;   // SCRAMBLING_TYPE, 0 = off
+        uint8_t Compander;
+        uint8_t MicGain;
+        uint8_t VolumeGain;
+        uint8_t DacGain;
+        bool    Vox;
+        bool    Noaa;
+    } Fixed;
+} RxSetup_t;
+
+static RxSetup_t gRxSetup;
+static bool      gRxSetupValid;
+static uint32_t  gRxSetupWrites;   // BK4819_GetRxSetupWrites() once gRxSetup was programmed
+
+#ifdef ENABLE_UART_BENCHMARK
+    RADIO_RetuneStats_t gRadioRetuneStats;
+#endif
+
+static void GetRxSetup(RxSetup_t *pSetup)
 {
-    BK4819_FilterBandwidth_t Bandwidth = gRxVfo->CHANNEL_BANDWIDTH;
+    const VFO_Info_t *pVfo = gRxVfo;
+    BK4819_FilterBandwidth_t Bandwidth = pVfo->CHANNEL_BANDWIDTH;
+
+    // compared with memcmp(), padding included
+    memset(pSetup, 0, sizeof(*pSetup));
 
     #ifdef ENABLE_FEAT_F4HWN_NARROWER
         if(Bandwidth == BK4819_FILTER_BW_NARROW && gSetting_set_nfm == 1)
@@ -689,34 +728,142 @@ void RADIO_SetupRegisters(bool switchToForeground)
         }
     #endif
 
-    AUDIO_AudioPathOff();
+    if (pVfo->Modulation == MODULATION_AM)
+        Bandwidth = BK4819_FILTER_BW_AM;
+    else if (Bandwidth != BK4819_FILTER_BW_NARROW && Bandwidth != BK4819_FILTER_BW_NARROWER)
+        Bandwidth = BK4819_FILTER_BW_WIDE;
 
-    gEnableSpeaker = false;
+    pSetup->Bandwidth = Bandwidth;
 
-    BK4819_ToggleGpioOut(BK4819_GPIO6_PIN2_GREEN, false);
+    #ifdef ENABLE_NOAA
+        if (!IS_NOAA_CHANNEL(pVfo->CHANNEL_SAVE) || !gIsNoaaMode)
+            pSetup->Frequency = pVfo->pRX->Frequency;
+        else
+            pSetup->Frequency = NoaaFrequencyTable[gNoaaChannel];
+
+        pSetup->Fixed.Noaa = IS_NOAA_CHANNEL(pVfo->CHANNEL_SAVE);
+    #else
+        pSetup->Frequency = pVfo->pRX->Frequency;
+    #endif
+
+    pSetup->Squelch[0] = pVfo->SquelchOpenRSSIThresh;
+    pSetup->Squelch[1] = pVfo->SquelchCloseRSSIThresh;
+    pSetup->Squelch[2] = pVfo->SquelchOpenNoiseThresh;
+    pSetup->Squelch[3] = pVfo->SquelchCloseNoiseThresh;
+    pSetup->Squelch[4] = pVfo->SquelchCloseGlitchThresh;
+    pSetup->Squelch[5] = pVfo->SquelchOpenGlitchThresh;
+
+    pSetup->CodeType = pVfo->pRX->CodeType;
+    pSetup->Code     = pVfo->pRX->Code;
 
-    if (gRxVfo->Modulation == MODULATION_AM)
+    pSetup->Fixed.Modulation = pVfo->Modulation;
+    pSetup->Fixed.Scramble   = (pVfo->SCRAMBLING_TYPE > 0 && gSetting_ScrambleEnable) ? pVfo->SCRAMBLING_TYPE : 0;
+    pSetup->Fixed.Compander  = (pVfo->Modulation == MODULATION_FM && pVfo->Compander >= 2) ? pVfo->Compander : 0;
+    pSetup->Fixed.MicGain    = gEeprom.MIC_SENSITIVITY_TUNING & 0x1f;
+    pSetup->Fixed.VolumeGain = gEeprom.VOLUME_GAIN;
+    pSetup->Fixed.DacGain    = gEeprom.DAC_GAIN;
+
+#ifdef ENABLE_VOX
+    pSetup->Fixed.Vox = gEeprom.VOX_SWITCH && gCurrentVfo->Modulation == MODULATION_FM
+#ifdef ENABLE_NOAA
+        && !IS_NOAA_CHANNEL(gCurrentVfo->CHANNEL_SAVE)
+#endif
+#ifdef ENABLE_FMRADIO
+        && !gFmRadioMode
+#endif
+        ;
+#endif
+}
+
+static void SetupFilterBandwidth(BK4819_FilterBandwidth_t Bandwidth)
+{
+    if (Bandwidth == BK4819_FILTER_BW_AM)
         BK4819_SetFilterBandwidth(BK4819_FILTER_BW_AM, true);
     else
+        #ifdef ENABLE_AM_FIX__
+//          BK4819_SetFilterBandwidth(Bandwidth, gRxVfo->Modulation == MODULATION_AM && gSetting_AM_fix);
+            BK4819_SetFilterBandwidth(Bandwidth, true);
+        #else
+            BK4819_SetFilterBandwidth(Bandwidth, false);
+        #endif
+}
+
+// FM CTCSS/DCS decoder
+static void SetupCss(uint8_t CodeType, uint8_t Code)
+{
+    switch (CodeType)
     {
-        switch (Bandwidth)
+        default:
+        case CODE_TYPE_OFF:
+            BK4819_SetCTCSSFrequency(SQL_TONE);
+            BK4819_SetTailDetection(SQL_TONE); // Default 550 = QS's 55Hz tone method
+            break;
+
+        case CODE_TYPE_CONTINUOUS_TONE:
+            BK4819_SetCTCSSFrequency(CTCSS_Options[Code]);
+
+            //#ifndef ENABLE_CTCSS_TAIL_PHASE_SHIFT
+            //    BK4819_SetTailDetection(550);       // QS's 55Hz tone method
+            //#else
+            //  BK4819_SetTailDetection(CTCSS_Options[Code]);
+            //#endif
+            break;
+
+        case CODE_TYPE_DIGITAL:
+        case CODE_TYPE_REVERSE_DIGITAL:
+            BK4819_SetCDCSSCodeWord(DCS_GetGolayCodeWord(CodeType, Code));
+            break;
+    }
+}
+
+static uint16_t RxInterruptMask(const RxSetup_t *pSetup)
+{
+    uint16_t InterruptMask = BK4819_REG_3F_SQUELCH_FOUND | BK4819_REG_3F_SQUELCH_LOST;
+
+    if (pSetup->Fixed.Noaa)
+    {
+        InterruptMask |= BK4819_REG_3F_CTCSS_FOUND | BK4819_REG_3F_CTCSS_LOST;
+    }
+    else if (pSetup->Fixed.Modulation == MODULATION_FM)
+    {
+        switch (pSetup->CodeType)
         {
             default:
-                Bandwidth = BK4819_FILTER_BW_WIDE;
-                [[fallthrough]];
-            case BK4819_FILTER_BW_WIDE:
-            case BK4819_FILTER_BW_NARROW:
-            case BK4819_FILTER_BW_NARROWER:
-                #ifdef ENABLE_AM_FIX__
-    //              BK4819_SetFilterBandwidth(Bandwidth, gRxVfo->Modulation == MODULATION_AM && gSetting_AM_fix);
-                    BK4819_SetFilterBandwidth(Bandwidth, true);
-                #else
-                    BK4819_SetFilterBandwidth(Bandwidth, false);
-                #endif
+            case CODE_TYPE_OFF:
+                InterruptMask |= BK4819_REG_3F_CxCSS_TAIL;
+                break;
+
+            case CODE_TYPE_CONTINUOUS_TONE:
+                InterruptMask |= BK4819_REG_3F_CxCSS_TAIL | BK4819_REG_3F_CTCSS_FOUND | BK4819_REG_3F_CTCSS_LOST;
+                break;
+
+            case CODE_TYPE_DIGITAL:
+            case CODE_TYPE_REVERSE_DIGITAL:
+                InterruptMask |= BK4819_REG_3F_CxCSS_TAIL | BK4819_REG_3F_CDCSS_FOUND | BK4819_REG_3F_CDCSS_LOST;
                 break;
         }
     }
 
+    if (pSetup->Fixed.Vox)
+        InterruptMask |= BK4819_REG_3F_VOX_FOUND | BK4819_REG_3F_VOX_LOST;
+
+    return InterruptMask | BK4819_REG_3F_DTMF_5TONE_FOUND;
+}
+
+void RADIO_SetupRegisters(bool switchToForeground)
+{
+    RxSetup_t Setup;
+
+    GetRxSetup(&Setup);
+
+    AUDIO_AudioPathOff();
+
+    gEnableSpeaker = false;
+
+    BK4819_ToggleGpioOut(BK4819_GPIO6_PIN2_GREEN, false);
+
+    SetupFilterBandwidth(Setup.Bandwidth);
+
     BK4819_ToggleGpioOut(BK4819_GPIO5_PIN1_RED, false);
 
     BK4819_SetupPowerAmplifier(0, 0);
@@ -735,25 +882,16 @@ void RADIO_SetupRegisters(bool switchToForeground)
     BK4819_WriteRegister(BK4819_REG_3F, 0);
 
     // mic gain 0.5dB/step 0 to 31
-    BK4819_WriteRegister(BK4819_REG_7D, 0xE940 | (gEeprom.MIC_SENSITIVITY_TUNING & 0x1f));
+    BK4819_WriteRegister(BK4819_REG_7D, 0xE940 | Setup.Fixed.MicGain);
 
-    uint32_t Frequency;
-    #ifdef ENABLE_NOAA
-        if (!IS_NOAA_CHANNEL(gRxVfo->CHANNEL_SAVE) || !gIsNoaaMode)
-            Frequency = gRxVfo->pRX->Frequency;
-        else
-            Frequency = NoaaFrequencyTable[gNoaaChannel];
-    #else
-        Frequency = gRxVfo->pRX->Frequency;
-    #endif
-    BK4819_SetFrequency(Frequency);
+    BK4819_SetFrequency(Setup.Frequency);
 
     BK4819_SetupSquelch(
         gRxVfo->SquelchOpenRSSIThresh,    gRxVfo->SquelchCloseRSSIThresh,
         gRxVfo->SquelchOpenNoiseThresh,   gRxVfo->SquelchCloseNoiseThresh,
         gRxVfo->SquelchCloseGlitchThresh, gRxVfo->SquelchOpenGlitchThresh);
 
-    BK4819_PickRXFilterPathBasedOnFrequency(Frequency);
+    BK4819_PickRXFilterPathBasedOnFrequency(Setup.Frequency);
 
     // what does this in do ?
     BK4819_ToggleGpioOut(BK4819_GPIO0_PIN28_RX_ENABLE, true);
@@ -766,90 +904,28 @@ void RADIO_SetupRegisters(bool switchToForeground)
         (gEeprom.VOLUME_GAIN << 4) |     // AF Rx Gain-2
         (gEeprom.DAC_GAIN    << 0));     // AF DAC Gain (after Gain-1 and Gain-2)
 
-
-    uint16_t InterruptMask = BK4819_REG_3F_SQUELCH_FOUND | BK4819_REG_3F_SQUELCH_LOST;
-
-    #ifdef ENABLE_NOAA
-        if (!IS_NOAA_CHANNEL(gRxVfo->CHANNEL_SAVE))
-    #endif
+    if (!Setup.Fixed.Noaa)
     {
-        if (gRxVfo->Modulation == MODULATION_FM)
+        if (Setup.Fixed.Modulation == MODULATION_FM)
         {   // FM
-            uint8_t CodeType = gRxVfo->pRX->CodeType;
-            uint8_t Code     = gRxVfo->pRX->Code;
+            SetupCss(Setup.CodeType, Setup.Code);
 
-            switch (CodeType)
-            {
-                default:
-                case CODE_TYPE_OFF:
-                    BK4819_SetCTCSSFrequency(SQL_TONE);
-                    BK4819_SetTailDetection(SQL_TONE); // Default 550 = QS's 55Hz tone method
-
-                    InterruptMask = BK4819_REG_3F_CxCSS_TAIL | BK4819_REG_3F_SQUELCH_FOUND | BK4819_REG_3F_SQUELCH_LOST;
-                    break;
-
-                case CODE_TYPE_CONTINUOUS_TONE:
-                    BK4819_SetCTCSSFrequency(CTCSS_Options[Code]);
-
-                    //#ifndef ENABLE_CTCSS_TAIL_PHASE_SHIFT
-                    //    BK4819_SetTailDetection(550);       // QS's 55Hz tone method
-                    //#else
-                    //  BK4819_SetTailDetection(CTCSS_Options[Code]);
-                    //#endif
-
-                    InterruptMask = 0
-                        | BK4819_REG_3F_CxCSS_TAIL
-                        | BK4819_REG_3F_CTCSS_FOUND
-                        | BK4819_REG_3F_CTCSS_LOST
-                        | BK4819_REG_3F_SQUELCH_FOUND
-                        | BK4819_REG_3F_SQUELCH_LOST;
-
-                    break;
-
-                case CODE_TYPE_DIGITAL:
-                case CODE_TYPE_REVERSE_DIGITAL:
-                    BK4819_SetCDCSSCodeWord(DCS_GetGolayCodeWord(CodeType, Code));
-                    InterruptMask = 0
-                        | BK4819_REG_3F_CxCSS_TAIL
-                        | BK4819_REG_3F_CDCSS_FOUND
-                        | BK4819_REG_3F_CDCSS_LOST
-                        | BK4819_REG_3F_SQUELCH_FOUND
-                        | BK4819_REG_3F_SQUELCH_LOST;
-                    break;
-            }
-
-
-            if (gRxVfo->SCRAMBLING_TYPE > 0 && gSetting_ScrambleEnable)
-                BK4819_EnableScramble(gRxVfo->SCRAMBLING_TYPE - 1);
+            if (Setup.Fixed.Scramble)
+                BK4819_EnableScramble(Setup.Fixed.Scramble - 1);
             else
                 BK4819_DisableScramble();
-
         }
     }
     #ifdef ENABLE_NOAA
         else
         {
             BK4819_SetCTCSSFrequency(2625);
-            InterruptMask = 0
-                | BK4819_REG_3F_CTCSS_FOUND
-                | BK4819_REG_3F_CTCSS_LOST
-                | BK4819_REG_3F_SQUELCH_FOUND
-                | BK4819_REG_3F_SQUELCH_LOST;
         }
     #endif
 
 #ifdef ENABLE_VOX
-    if (gEeprom.VOX_SWITCH  && gCurrentVfo->Modulation == MODULATION_FM
-#ifdef ENABLE_NOAA
-        && !IS_NOAA_CHANNEL(gCurrentVfo->CHANNEL_SAVE)
-#endif
-#ifdef ENABLE_FMRADIO
-        && !gFmRadioMode
-#endif
-    ){
+    if (Setup.Fixed.Vox)
         BK4819_EnableVox(gEeprom.VOX1_THRESHOLD, gEeprom.VOX0_THRESHOLD);
-        InterruptMask |= BK4819_REG_3F_VOX_FOUND | BK4819_REG_3F_VOX_LOST;
-    }
     else
 #endif
     {
@@ -857,15 +933,18 @@ void RADIO_SetupRegisters(bool switchToForeground)
     }
 
     // RX expander
-    BK4819_SetCompander((gRxVfo->Modulation == MODULATION_FM && gRxVfo->Compander >= 2) ? gRxVfo->Compander : 0);
+    BK4819_SetCompander(Setup.Fixed.Compander);
 
     BK4819_EnableDTMF();
-    InterruptMask |= BK4819_REG_3F_DTMF_5TONE_FOUND;
 
-    RADIO_SetupAGC(gRxVfo->Modulation == MODULATION_AM, false);
+    RADIO_SetupAGC(Setup.Fixed.Modulation == MODULATION_AM, false);
 
     // enable/disable BK4819 selected interrupts
-    BK4819_WriteRegister(BK4819_REG_3F, InterruptMask);
+    BK4819_WriteRegister(BK4819_REG_3F, RxInterruptMask(&Setup));
+
+    gRxSetup       = Setup;
+    gRxSetupValid  = true;
+    gRxSetupWrites = BK4819_GetRxSetupWrites();
 
     FUNCTION_Init();
 
@@ -873,6 +952,81 @@ void RADIO_SetupRegisters(bool switchToForeground)
         FUNCTION_Select(FUNCTION_FOREGROUND);
 }
 
+bool RADIO_QuickRetune(bool switchToForeground)
+{
+#ifdef ENABLE_UART_BENCHMARK
+    const uint32_t Start = SYSTICK_GetUs();
+#endif
+    RxSetup_t Next;
+
+    GetRxSetup(&Next);
+
+    // AM retunes also reset the AGC, NOAA has its own tone setup. Anything
+    // else that touched the RX registers since (spectrum, menu, AM fix, TX)
+    // leaves them unknown.
+    const bool Quick = gRxSetupValid && BK4819_GetRxSetupWrites() == gRxSetupWrites &&
+        Next.Fixed.Modulation == MODULATION_FM && !Next.Fixed.Noaa &&
+        memcmp(&Next.Fixed, &gRxSetup.Fixed, sizeof(Next.Fixed)) == 0;
+
+    if (!Quick)
+    {
+        RADIO_SetupRegisters(switchToForeground);
+    }
+    else
+    {
+        AUDIO_AudioPathOff();
+
+        gEnableSpeaker = false;
+
+        BK4819_ToggleGpioOut(BK4819_GPIO6_PIN2_GREEN, false);
+
+        // nothing from the old channel while retuning, stale flags are
+        // cleared below instead of draining REG_0C
+        BK4819_WriteRegister(BK4819_REG_3F, 0);
+
+        if (Next.Bandwidth != gRxSetup.Bandwidth)
+            SetupFilterBandwidth(Next.Bandwidth);
+
+        BK4819_SetFrequency(Next.Frequency);
+
+        if (memcmp(Next.Squelch, gRxSetup.Squelch, sizeof(Next.Squelch)) != 0)
+            BK4819_SetupSquelch(
+                Next.Squelch[0], Next.Squelch[1],
+                Next.Squelch[2], Next.Squelch[3],
+                Next.Squelch[4], Next.Squelch[5]);      // restarts RX as well
+        else
+            BK4819_RX_TurnOn();
+
+        BK4819_PickRXFilterPathBasedOnFrequency(Next.Frequency);
+
+        if (Next.CodeType != gRxSetup.CodeType || Next.Code != gRxSetup.Code)
+            SetupCss(Next.CodeType, Next.Code);
+
+        BK4819_WriteRegister(BK4819_REG_02, 0);
+        BK4819_WriteRegister(BK4819_REG_3F, RxInterruptMask(&Next));
+
+        gRxSetup       = Next;
+        gRxSetupWrites = BK4819_GetRxSetupWrites();
+
+        FUNCTION_Init();
+
+        if (switchToForeground)
+            FUNCTION_Select(FUNCTION_FOREGROUND);
+    }
+
+#ifdef ENABLE_UART_BENCHMARK
+    const uint32_t Elapsed = SYSTICK_GetUs() - Start;
+    RADIO_HopTime_t *pTime = Quick ? &gRadioRetuneStats.Quick : &gRadioRetuneStats.Full;
+
+    pTime->Count++;
+    pTime->TotalUs += Elapsed;
+    if (Elapsed > pTime->MaxUs)
+        pTime->MaxUs = Elapsed;
+#endif
+
+    return Quick;
+}
+
 #ifdef ENABLE_NOAA
     void RADIO_ConfigureNOAA(void)
     {
@@ -922,6 +1076,9 @@ void RADIO_SetTxParameters(void)
 {
     BK4819_FilterBandwidth_t Bandwidth = gCurrentVfo->CHANNEL_BANDWIDTH;
 
+    // TX reprograms the filter, frequency and PA
+    gRxSetupValid = false;
+
     #ifdef ENABLE_FEAT_F4HWN_NARROWER
         if(Bandwidth == BK4819_FILTER_BW_NARROW && gSetting_set_nfm == 1)
         {
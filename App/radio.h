@@ -150,6 +150,24 @@ extern DCS_CodeType_t gCurrentCodeType;
 
 extern VfoState_t     VfoState[2];
 
+#ifdef ENABLE_UART_BENCHMARK
+    typedef struct
+    {
+        uint32_t Count;
+        uint32_t TotalUs;
+        uint32_t MaxUs;
+    } RADIO_HopTime_t;
+
+    // RADIO_QuickRetune() time per hop, by the path taken
+    typedef struct
+    {
+        RADIO_HopTime_t Quick;
+        RADIO_HopTime_t Full;
+    } RADIO_RetuneStats_t;
+
+    extern RADIO_RetuneStats_t gRadioRetuneStats;
+#endif
+
 bool     RADIO_CheckValidChannel(uint16_t channel, bool checkScanList, uint8_t scanList);
 uint8_t  RADIO_FindNextChannel(uint8_t ChNum, int8_t Direction, bool bCheckScanList, uint8_t RadioNum);
 void     RADIO_InitInfo(VFO_Info_t *pInfo, const uint8_t ChannelSave, const uint32_t Frequency);
@@ -158,6 +176,7 @@ void     RADIO_ConfigureSquelchAndOutputPower(VFO_Info_t *pInfo);
 void     RADIO_ApplyOffset(VFO_Info_t *pInfo);
 void     RADIO_SelectVfos(void);
 void     RADIO_SetupRegisters(bool switchToForeground);
+bool     RADIO_QuickRetune(bool switchToForeground);
 #ifdef ENABLE_NOAA
     void RADIO_ConfigureNOAA(void);
 #endif
@@ -0,0 +1,278 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+/**
+ * -----------------------------------
+ * Scan plans
+ *
+ *    When a memory scan starts, every channel of its scan list (and the
+ *    list's priority channels) is configured once and what the RX side
+ *    needs of it is kept in a 6 byte plan: frequency, bandwidth, CSS type
+ *    and code, and whether it takes the VHF or UHF squelch thresholds. The
+ *    thresholds themselves, the scrambler and the compander are the same
+ *    for the whole session. The filter path follows from the frequency.
+ *
+ *    A hop writes these into the VFO and RADIO_QuickRetune() programs them,
+ *    without a flash read. The rest of the VFO (TX side, power, name) still
+ *    holds an earlier channel, so the channel is configured in full when
+ *    the scan lands on it (SCANPLAN_Complete()) or stops.
+ *
+ *    Only FM channels with the session's scrambler and compander get a
+ *    plan, anything else takes the full setup anyway. So do channels past
+ *    the first PLAN_SLOTS of a longer list.
+ *
+ *    Plans are dropped on channel writes, EEPROM writes over UART
+ *    (calibration) and changes to the settings RADIO_ConfigureChannel()
+ *    reads besides the channel: squelch level, power setting, 350 MHz
+ *    enable and the rescue options. They are built again on the next
+ *    SCANPLAN_Start(), as on a change of scan list or direction.
+ * ------------------------------------
+ */
+
+#include <string.h>
+
+#include "frequencies.h"
+#include "misc.h"
+#include "radio.h"
+#include "scanplan.h"
+#include "settings.h"
+
+#define PLAN_SLOTS     128
+#define PLAN_FREQ_BITS 27   // 1342 MHz in 10 Hz units
+
+typedef struct
+{
+    uint32_t Frequency : PLAN_FREQ_BITS; // pRX
+    uint32_t CodeType  : 2;              // pRX, DCS_CodeType_t
+    uint32_t Bandwidth : 2;              // CHANNEL_BANDWIDTH
+    uint32_t Uhf       : 1;              // Squelch[1] rather than Squelch[0]
+    uint8_t  Code;                       // pRX
+    uint8_t  Channel;
+} __attribute__((packed)) Plan_t;
+
+_Static_assert(sizeof(Plan_t) == 6, "scan plan grew");
+
+// Session wide inputs of RADIO_ConfigureChannel()
+typedef struct
+{
+    uint8_t SquelchLevel;
+    uint8_t PowerSetting;
+    bool    Enable350;
+#ifdef ENABLE_FEAT_F4HWN_RESCUE_OPS
+    bool    PowerHigh;
+    bool    RemoveOffset;
+#endif
+} Inputs_t;
+
+static Plan_t   Plans[PLAN_SLOTS];  // by channel
+static uint8_t  Count;
+static bool     Active;
+static bool     Built;              // Plans[] hold the session's list
+static bool     Partial;            // the VFO was last set from a plan
+static uint8_t  SessionVfo;
+static uint8_t  SessionList;
+static Inputs_t Inputs;
+
+// Shared by all plans of a session
+static uint8_t  Squelch[2][6];      // VHF, UHF
+static uint8_t  Scramble;
+static uint8_t  Compander;
+
+static void GetInputs(Inputs_t *pInputs)
+{
+    memset(pInputs, 0, sizeof(*pInputs));
+    pInputs->SquelchLevel = gEeprom.SQUELCH_LEVEL;
+    pInputs->PowerSetting = gSetting_set_pwr;
+    pInputs->Enable350    = gSetting_350EN;
+#ifdef ENABLE_FEAT_F4HWN_RESCUE_OPS
+    pInputs->PowerHigh    = gPowerHigh;
+    pInputs->RemoveOffset = gRemoveOffset;
+#endif
+}
+
+static bool SessionValid(void)
+{
+    if (!Active || !Built || SessionVfo != gEeprom.RX_VFO)
+        return false;
+
+    Inputs_t Now;
+    GetInputs(&Now);
+    if (memcmp(&Now, &Inputs, sizeof(Now)) != 0)
+        SCANPLAN_Invalidate();
+
+    return Built;
+}
+
+// The channels NextMemChannel() visits
+static bool InList(uint8_t Channel)
+{
+    const uint8_t List = SessionList;
+
+    if (RADIO_CheckValidChannel(Channel, true, List))
+        return true;
+
+    return List > 0 && List < 4 && RADIO_CheckValidChannel(Channel, false, List) &&
+        (Channel == gEeprom.SCANLIST_PRIORITY_CH1[List - 1] || Channel == gEeprom.SCANLIST_PRIORITY_CH2[List - 1]);
+}
+
+static void Build(void)
+{
+    const uint8_t     Vfo    = SessionVfo;
+    VFO_Info_t       *pInfo  = &gEeprom.VfoInfo[Vfo];
+    const VFO_Info_t  Saved  = *pInfo;              // pRX/pTX point into it
+    const uint8_t     Screen = gEeprom.ScreenChannel[Vfo];
+    const uint8_t     Mr     = gEeprom.MrChannel[Vfo];
+    const uint8_t     Freq   = gEeprom.FreqChannel[Vfo];
+
+    Count = 0;
+
+    for (uint8_t Channel = MR_CHANNEL_FIRST; IS_MR_CHANNEL(Channel) && Count < PLAN_SLOTS; Channel++)
+    {
+        if (!InList(Channel))
+            continue;
+
+        gEeprom.ScreenChannel[Vfo] = Channel;
+        RADIO_ConfigureChannel(Vfo, VFO_CONFIGURE_RELOAD);
+
+        const FREQ_Config_t *pRX = pInfo->pRX;
+
+        if (pInfo->CHANNEL_SAVE != Channel || pInfo->Modulation != MODULATION_FM ||
+            (pRX->Frequency >> PLAN_FREQ_BITS) != 0 || pInfo->CHANNEL_BANDWIDTH > 3)
+            continue;
+
+        if (Count == 0)
+        {
+            Scramble  = pInfo->SCRAMBLING_TYPE;
+            Compander = pInfo->Compander;
+        }
+        else if (pInfo->SCRAMBLING_TYPE != Scramble || pInfo->Compander != Compander)
+            continue;
+
+        // RADIO_ConfigureSquelchAndOutputPower() only tells VHF from UHF
+        const bool Uhf      = FREQUENCY_GetBand(pRX->Frequency) >= BAND4_174MHz;
+        uint8_t   *pSquelch = Squelch[Uhf];
+
+        pSquelch[0] = pInfo->SquelchOpenRSSIThresh;
+        pSquelch[1] = pInfo->SquelchCloseRSSIThresh;
+        pSquelch[2] = pInfo->SquelchOpenNoiseThresh;
+        pSquelch[3] = pInfo->SquelchCloseNoiseThresh;
+        pSquelch[4] = pInfo->SquelchCloseGlitchThresh;
+        pSquelch[5] = pInfo->SquelchOpenGlitchThresh;
+
+        Plan_t *pPlan = &Plans[Count++];
+
+        pPlan->Frequency = pRX->Frequency;
+        pPlan->CodeType  = pRX->CodeType;
+        pPlan->Bandwidth = pInfo->CHANNEL_BANDWIDTH;
+        pPlan->Uhf       = Uhf;
+        pPlan->Code      = pRX->Code;
+        pPlan->Channel   = Channel;
+    }
+
+    *pInfo = Saved;
+    gEeprom.ScreenChannel[Vfo] = Screen;
+    gEeprom.MrChannel[Vfo]     = Mr;
+    gEeprom.FreqChannel[Vfo]   = Freq;
+
+    Built = true;
+}
+
+static const Plan_t *Find(uint8_t Channel)
+{
+    uint8_t Low  = 0;
+    uint8_t High = Count;
+
+    while (Low < High)
+    {
+        const uint8_t Mid = (Low + High) / 2;
+
+        if (Plans[Mid].Channel == Channel)
+            return &Plans[Mid];
+
+        if (Plans[Mid].Channel < Channel)
+            Low = Mid + 1;
+        else
+            High = Mid;
+    }
+
+    return NULL;
+}
+
+void SCANPLAN_Invalidate(void)
+{
+    Built = false;
+    Count = 0;
+}
+
+void SCANPLAN_Start(void)
+{
+    // Same list on the same VFO, as on a change of direction: keep it
+    if (SessionValid() && SessionList == gEeprom.SCAN_LIST_DEFAULT)
+        return;
+
+    SessionVfo  = gEeprom.RX_VFO;
+    SessionList = gEeprom.SCAN_LIST_DEFAULT;
+    Active      = true;
+    GetInputs(&Inputs);
+    Build();
+}
+
+void SCANPLAN_Stop(void)
+{
+    Active  = false;
+    Partial = false;
+}
+
+bool SCANPLAN_Load(uint8_t Vfo, uint8_t Channel)
+{
+    Partial = false;
+
+    if (Vfo != SessionVfo || !SessionValid())
+        return false;
+
+    const Plan_t *pPlan = Find(Channel);
+    if (pPlan == NULL)
+        return false;
+
+    VFO_Info_t    *pInfo    = &gEeprom.VfoInfo[Vfo];
+    FREQ_Config_t *pRX      = pInfo->pRX;
+    const uint8_t *pSquelch = Squelch[pPlan->Uhf];
+
+    pRX->Frequency = pPlan->Frequency;
+    pRX->CodeType  = pPlan->CodeType;
+    pRX->Code      = pPlan->Code;
+
+    pInfo->CHANNEL_SAVE             = Channel;
+    pInfo->CHANNEL_BANDWIDTH        = pPlan->Bandwidth;
+    pInfo->Modulation               = MODULATION_FM;
+    pInfo->SCRAMBLING_TYPE          = Scramble;
+    pInfo->Compander                = Compander;
+    pInfo->SquelchOpenRSSIThresh    = pSquelch[0];
+    pInfo->SquelchCloseRSSIThresh   = pSquelch[1];
+    pInfo->SquelchOpenNoiseThresh   = pSquelch[2];
+    pInfo->SquelchCloseNoiseThresh  = pSquelch[3];
+    pInfo->SquelchCloseGlitchThresh = pSquelch[4];
+    pInfo->SquelchOpenGlitchThresh  = pSquelch[5];
+
+    Partial = true;
+    return true;
+}
+
+void SCANPLAN_Complete(void)
+{
+    if (!Partial)
+        return;
+
+    Partial = false;
+    RADIO_ConfigureChannel(SessionVfo, VFO_CONFIGURE_RELOAD);
+}
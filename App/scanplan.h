@@ -0,0 +1,32 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef SCANPLAN_H
+#define SCANPLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "radio.h"
+
+// RX setup of the memory channels of a scan list, worked out when the scan
+// starts, so hops skip the channel store and calibration reads and go
+// straight to RADIO_QuickRetune().
+
+void SCANPLAN_Start(void);
+void SCANPLAN_Stop(void);
+void SCANPLAN_Invalidate(void);
+bool SCANPLAN_Load(uint8_t Vfo, uint8_t Channel);
+void SCANPLAN_Complete(void);
+
+#endif
@@ -18,6 +18,7 @@
 #include <string.h>
 
 #include "app/dtmf.h"
+#include "chstore.h"
 #ifdef ENABLE_FMRADIO
     #include "app/fm.h"
 #endif
@@ -25,6 +26,9 @@
 #include "driver/bk4819.h"
 #include "driver/py25q16.h"
 #include "misc.h"
+#ifdef ENABLE_SCAN_PLAN
+    #include "scanplan.h"
+#endif
 #include "settings.h"
 #include "ui/menu.h"
 
@@ -43,9 +47,15 @@ EEPROM_Config_t gEeprom = { 0 };
 
 void SETTINGS_InitEEPROM(void)
 {
-    uint8_t Data[16] = {0};
+    // Each backing sector is read in one go, fields are parsed from here
+    uint8_t Region[0x50];
+    uint8_t *Data;
+
+    // 0E70..0E7F
+    PY25Q16_ReadBuffer(0x004000, Region, 0x10);
+
     // 0E70..0E77
-    PY25Q16_ReadBuffer(0x004000, Data, 8);
+    Data = Region;
     gEeprom.CHAN_1_CALL          = IS_MR_CHANNEL(Data[0]) ? Data[0] : MR_CHANNEL_FIRST;
     gEeprom.SQUELCH_LEVEL        = (Data[1] < 10) ? Data[1] : 1;
     gEeprom.TX_TIMEOUT_TIMER     = (Data[2] > 4 && Data[2] < 180) ? Data[2] : 11;
@@ -66,7 +76,7 @@ void SETTINGS_InitEEPROM(void)
     gEeprom.MIC_SENSITIVITY      = (Data[7] <  5) ? Data[7] : 4;
 
     // 0E78..0E7F
-    PY25Q16_ReadBuffer(0x004008, Data, 8);
+    Data = Region + 0x8;
     gEeprom.BACKLIGHT_MAX         = (Data[0] & 0xF) <= 10 ? (Data[0] & 0xF) : 10;
     gEeprom.BACKLIGHT_MIN         = (Data[0] >> 4) < gEeprom.BACKLIGHT_MAX ? (Data[0] >> 4) : 0;
 #ifdef ENABLE_BLMIN_TMP_OFF
@@ -93,7 +103,8 @@ void SETTINGS_InitEEPROM(void)
     #endif
 
     // 0E80..0E87
-    PY25Q16_ReadBuffer(0x005000, Data, 8);
+    PY25Q16_ReadBuffer(0x005000, Region, 8);
+    Data = Region;
     gEeprom.ScreenChannel[0]   = IS_VALID_CHANNEL(Data[0]) ? Data[0] : (FREQ_CHANNEL_FIRST + BAND6_400MHz);
     gEeprom.ScreenChannel[1]   = IS_VALID_CHANNEL(Data[3]) ? Data[3] : (FREQ_CHANNEL_FIRST + BAND6_400MHz);
     gEeprom.MrChannel[0]       = IS_MR_CHANNEL(Data[1])    ? Data[1] : MR_CHANNEL_FIRST;
@@ -132,8 +143,11 @@ void SETTINGS_InitEEPROM(void)
     FM_ConfigureChannelState();
 #endif
 
+    // 0E90..0EDF
+    PY25Q16_ReadBuffer(0x007000, Region, 0x50);
+
     // 0E90..0E97
-    PY25Q16_ReadBuffer(0x007000, Data, 8);
+    Data = Region;
     gEeprom.BEEP_CONTROL                 = Data[0] & 1;
     gEeprom.KEY_M_LONG_PRESS_ACTION      = ((Data[0] >> 1) < ACTION_OPT_LEN) ? (Data[0] >> 1) : ACTION_OPT_NONE;
     gEeprom.KEY_1_SHORT_PRESS_ACTION     = (Data[1] < ACTION_OPT_LEN) ? Data[1] : ACTION_OPT_MONITOR;
@@ -150,12 +164,12 @@ void SETTINGS_InitEEPROM(void)
 
     // 0E98..0E9F
     #ifdef ENABLE_PWRON_PASSWORD
-        PY25Q16_ReadBuffer(0x007000 + 0x8, Data, 8);
+        Data = Region + 0x8;
         memcpy(&gEeprom.POWER_ON_PASSWORD, Data, 4);
     #endif
 
     // 0EA0..0EA7
-    PY25Q16_ReadBuffer(0x007000 + 0x10, Data, 8);
+    Data = Region + 0x10;
     #ifdef ENABLE_VOICE
     gEeprom.VOICE_PROMPT = (Data[0] < 3) ? Data[0] : VOICE_PROMPT_ENGLISH;
     #endif
@@ -171,7 +185,7 @@ void SETTINGS_InitEEPROM(void)
     #endif
 
     // 0EA8..0EAF
-    PY25Q16_ReadBuffer(0x007000 + 0x18, Data, 8);
+    Data = Region + 0x18;
     #ifdef ENABLE_ALARM
         gEeprom.ALARM_MODE                 = (Data[0] <  2) ? Data[0] : true;
     #endif
@@ -181,7 +195,7 @@ void SETTINGS_InitEEPROM(void)
     gEeprom.BATTERY_TYPE                   = (Data[4] < BATTERY_TYPE_UNKNOWN) ? Data[4] : BATTERY_TYPE_1600_MAH;
 
     // 0ED0..0ED7
-    PY25Q16_ReadBuffer(0x007000 + 0x40, Data, 8);
+    Data = Region + 0x40;
     gEeprom.DTMF_SIDE_TONE               = (Data[0] <   2) ? Data[0] : true;
 
 #ifdef ENABLE_DTMF_CALLING
@@ -195,15 +209,20 @@ void SETTINGS_InitEEPROM(void)
     gEeprom.DTMF_HASH_CODE_PERSIST_TIME  = (Data[7] < 101) ? Data[7] * 10 : 100;
 
     // 0ED8..0EDF
-    PY25Q16_ReadBuffer(0x007000 + 0x48, Data, 8);
+    Data = Region + 0x48;
     gEeprom.DTMF_CODE_PERSIST_TIME  = (Data[0] < 101) ? Data[0] * 10 : 100;
     gEeprom.DTMF_CODE_INTERVAL_TIME = (Data[1] < 101) ? Data[1] * 10 : 100;
 #ifdef ENABLE_DTMF_CALLING
     gEeprom.PERMIT_REMOTE_KILL      = (Data[2] <   2) ? Data[2] : true;
 
-    // 0EE0..0EE7
+#endif
+
+    // 0EE0..0F17
+    PY25Q16_ReadBuffer(0x008000, Region, 0x38);
 
-    PY25Q16_ReadBuffer(0x008000, Data, sizeof(gEeprom.ANI_DTMF_ID));
+#ifdef ENABLE_DTMF_CALLING
+    // 0EE0..0EE7
+    Data = Region;
     if (DTMF_ValidateCodes((char *)Data, sizeof(gEeprom.ANI_DTMF_ID))) {
         memcpy(gEeprom.ANI_DTMF_ID, Data, sizeof(gEeprom.ANI_DTMF_ID));
     } else {
@@ -212,7 +231,7 @@ void SETTINGS_InitEEPROM(void)
 
 
     // 0EE8..0EEF
-    PY25Q16_ReadBuffer(0x008000 + 0x8, Data, sizeof(gEeprom.KILL_CODE));
+    Data = Region + 0x8;
     if (DTMF_ValidateCodes((char *)Data, sizeof(gEeprom.KILL_CODE))) {
         memcpy(gEeprom.KILL_CODE, Data, sizeof(gEeprom.KILL_CODE));
     } else {
@@ -220,7 +239,7 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0EF0..0EF7
-    PY25Q16_ReadBuffer(0x008000 + 0x10, Data, sizeof(gEeprom.REVIVE_CODE));
+    Data = Region + 0x10;
     if (DTMF_ValidateCodes((char *)Data, sizeof(gEeprom.REVIVE_CODE))) {
         memcpy(gEeprom.REVIVE_CODE, Data, sizeof(gEeprom.REVIVE_CODE));
     } else {
@@ -229,7 +248,7 @@ void SETTINGS_InitEEPROM(void)
 #endif
 
     // 0EF8..0F07
-    PY25Q16_ReadBuffer(0x008000 + 0x18, Data, sizeof(gEeprom.DTMF_UP_CODE));
+    Data = Region + 0x18;
     if (DTMF_ValidateCodes((char *)Data, sizeof(gEeprom.DTMF_UP_CODE))) {
         memcpy(gEeprom.DTMF_UP_CODE, Data, sizeof(gEeprom.DTMF_UP_CODE));
     } else {
@@ -237,7 +256,7 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0F08..0F17
-    PY25Q16_ReadBuffer(0x008000 + 0x28, Data, sizeof(gEeprom.DTMF_DOWN_CODE));
+    Data = Region + 0x28;
     if (DTMF_ValidateCodes((char *)Data, sizeof(gEeprom.DTMF_DOWN_CODE))) {
         memcpy(gEeprom.DTMF_DOWN_CODE, Data, sizeof(gEeprom.DTMF_DOWN_CODE));
     } else {
@@ -245,7 +264,8 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0F18..0F1F
-    PY25Q16_ReadBuffer(0x009000, Data, 8);
+    PY25Q16_ReadBuffer(0x009000, Region, 8);
+    Data = Region;
     gEeprom.SCAN_LIST_DEFAULT = (Data[0] < 6) ? Data[0] : 0;  // we now have 'all' channel scan option
 
     // Fake data
@@ -278,7 +298,8 @@ void SETTINGS_InitEEPROM(void)
     }
 
     // 0F40..0F47
-    PY25Q16_ReadBuffer(0x00b000, Data, 8);
+    PY25Q16_ReadBuffer(0x00b000, Region, 8);
+    Data = Region;
     gSetting_F_LOCK            = (Data[0] < F_LOCK_LEN) ? Data[0] : F_LOCK_DEF;
 #ifndef ENABLE_FEAT_F4HWN
     gSetting_350TX             = (Data[1] < 2) ? Data[1] : false;  // was true
@@ -316,16 +337,13 @@ void SETTINGS_InitEEPROM(void)
         gEeprom.ScreenChannel[1] = gEeprom.MrChannel[1];
     }
 
-    // 0D60..0E27
-    PY25Q16_ReadBuffer(0x002000, gMR_ChannelAttributes, sizeof(gMR_ChannelAttributes));
-    for(uint16_t i = 0; i < sizeof(gMR_ChannelAttributes); i++) {
-        ChannelAttributes_t *att = &gMR_ChannelAttributes[i];
-        if(att->__val == 0xff){
-            att->__val = 0;
-            att->band = 0x7;
-        }
-        gMR_ChannelExclude[i] = false;
-    }
+#ifdef ENABLE_CHANNEL_ZONES
+    // 1FF8..1FFF
+    PY25Q16_ReadBuffer(0x00c008, Region, 8);
+    gEeprom.CHANNEL_ZONE = (Region[0] < CHSTORE_ZONES) ? Region[0] : 0;
+#endif
+
+    CHSTORE_LoadAttributes();
 
         // 0F30..0F3F
         PY25Q16_ReadBuffer(0x00a000, gCustomAesKey, sizeof(gCustomAesKey));
@@ -344,7 +362,8 @@ void SETTINGS_InitEEPROM(void)
     #ifdef ENABLE_FEAT_F4HWN
         // 1FF0..0x1FF7
         // TODO: address TBD
-        PY25Q16_ReadBuffer(0x00c000, Data, 8);
+        PY25Q16_ReadBuffer(0x00c000, Region, 8);
+        Data = Region;
         gSetting_set_pwr = (((Data[7] & 0xF0) >> 4) < 7) ? ((Data[7] & 0xF0) >> 4) : 0;
         gSetting_set_ptt = (((Data[7] & 0x0F)) < 2) ? ((Data[7] & 0x0F)) : 0;
 
@@ -399,20 +418,27 @@ void SETTINGS_InitEEPROM(void)
 void SETTINGS_LoadCalibration(void)
 {
 //  uint8_t Mic;
+    uint8_t Region[0x50];
+
+    // 0x1EC0..0x1ECF
+    PY25Q16_ReadBuffer(0x010000 + 0xc0, Region, 0x10);
 
     // 0x1EC0
-    PY25Q16_ReadBuffer(0x010000 + 0xc0, gEEPROM_RSSI_CALIB[3], 8);
+    memcpy(gEEPROM_RSSI_CALIB[3], Region, 8);
     memcpy(gEEPROM_RSSI_CALIB[4], gEEPROM_RSSI_CALIB[3], 8);
     memcpy(gEEPROM_RSSI_CALIB[5], gEEPROM_RSSI_CALIB[3], 8);
     memcpy(gEEPROM_RSSI_CALIB[6], gEEPROM_RSSI_CALIB[3], 8);
 
     // 0x1EC8
-    PY25Q16_ReadBuffer(0x010000 + 0xc8, gEEPROM_RSSI_CALIB[0], 8);
+    memcpy(gEEPROM_RSSI_CALIB[0], Region + 0x8, 8);
     memcpy(gEEPROM_RSSI_CALIB[1], gEEPROM_RSSI_CALIB[0], 8);
     memcpy(gEEPROM_RSSI_CALIB[2], gEEPROM_RSSI_CALIB[0], 8);
 
+    // 0x1F40..0x1F8F
+    PY25Q16_ReadBuffer(0x010000 + 0x140, Region, 0x50);
+
     // 0x1F40
-    PY25Q16_ReadBuffer(0x010000 + 0x140, gBatteryCalibration, 12);
+    memcpy(gBatteryCalibration, Region, 12);
     if (gBatteryCalibration[0] >= 5000)
     {
         gBatteryCalibration[0] = 1900;
@@ -422,9 +448,9 @@ void SETTINGS_LoadCalibration(void)
 
     #ifdef ENABLE_VOX
         // 0x1F50
-        PY25Q16_ReadBuffer(0x010000 + 0x150 + (gEeprom.VOX_LEVEL * 2), &gEeprom.VOX1_THRESHOLD, 2);
+        memcpy(&gEeprom.VOX1_THRESHOLD, Region + 0x10 + (gEeprom.VOX_LEVEL * 2), 2);
         // 0x1F68
-        PY25Q16_ReadBuffer(0x010000 + 0x168 + (gEeprom.VOX_LEVEL * 2), &gEeprom.VOX0_THRESHOLD, 2);
+        memcpy(&gEeprom.VOX0_THRESHOLD, Region + 0x28 + (gEeprom.VOX_LEVEL * 2), 2);
     #endif
 
     //PY25Q16_ReadBuffer(0x1F80 + gEeprom.MIC_SENSITIVITY, &Mic, 1);
@@ -444,7 +470,7 @@ void SETTINGS_LoadCalibration(void)
         // radio 1 .. 04 00 46 00 50 00 2C 0E
         // radio 2 .. 05 00 46 00 50 00 2C 0E
         // 0x1F88
-        PY25Q16_ReadBuffer(0x010000 + 0x188, &Misc, 8);
+        memcpy(&Misc, Region + 0x48, 8);
 
         gEeprom.BK4819_XTAL_FREQ_LOW = (Misc.BK4819_XtalFreqLow >= -1000 && Misc.BK4819_XtalFreqLow <= 1000) ? Misc.BK4819_XtalFreqLow : 0;
         gEEPROM_1F8A                 = Misc.EEPROM_1F8A & 0x01FF;
@@ -469,7 +495,7 @@ uint32_t SETTINGS_FetchChannelFrequency(const int channel)
         uint32_t offset;
     } __attribute__((packed)) info;
 
-    PY25Q16_ReadBuffer(channel * 16, &info, sizeof(info));
+    CHSTORE_ReadRecord(channel, 0, &info, sizeof(info));
 
     return info.frequency;
 }
@@ -488,7 +514,7 @@ void SETTINGS_FetchChannelName(char *s, const int channel)
         return;
 
     // 0x0F50
-    PY25Q16_ReadBuffer(0x00e000 + (channel * 16), s, 10);
+    PY25Q16_ReadBuffer(CHSTORE_NameAddr(channel), s, 10);
 
     int i;
     for (i = 0; i < 10; i++)
@@ -549,6 +575,9 @@ void SETTINGS_FactoryReset(bool bIsAll)
     if (bIsAll)
     {
         PY25Q16_SectorErase(0x00e000);
+        #ifdef ENABLE_CHANNEL_ZONES
+            CHSTORE_EraseZones();
+        #endif
     }
     // 1c00 - 1d00 : keep
 
@@ -573,6 +602,8 @@ void SETTINGS_FactoryReset(bool bIsAll)
         #endif
     }
 
+    CHSTORE_Invalidate();
+
     // Prevent reset to restart in RO mode...
     #ifdef ENABLE_FEAT_F4HWN_RESCUE_OPS
         {
@@ -966,7 +997,10 @@ void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
         State -> _8[7] =  pVFO->SCRAMBLING_TYPE;
 #endif
 
-        PY25Q16_WriteBuffer(OffsetVFO, Buf, 0x10, false);
+        if (IS_MR_CHANNEL(Channel))
+            CHSTORE_WriteRecord(Channel, Buf);
+        else
+            PY25Q16_WriteBuffer(OffsetVFO, Buf, 0x10, false);
 
         SETTINGS_UpdateChannel(Channel, pVFO, true, true, true);
 
@@ -982,6 +1016,9 @@ void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
         }
     }
 
+#ifdef ENABLE_SCAN_PLAN
+    SCANPLAN_Invalidate();
+#endif
 }
 
 void SETTINGS_SaveBatteryCalibration(const uint16_t * batteryCalibration)
@@ -992,11 +1029,10 @@ void SETTINGS_SaveBatteryCalibration(const uint16_t * batteryCalibration)
 
 void SETTINGS_SaveChannelName(uint8_t channel, const char * name)
 {
-    uint16_t offset = channel * 16;
     uint8_t buf[16] = {0};
     memcpy(buf, name, MIN(strlen(name), 10u));
     // 0x0F50
-    PY25Q16_WriteBuffer(0x00e000 + offset, buf, 0x10, false);
+    PY25Q16_WriteBuffer(CHSTORE_NameAddr(channel), buf, 0x10, false);
 }
 
 void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep, bool check, bool save)
@@ -1015,7 +1051,7 @@ void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep,
             };        // default attributes
 
         // 0x0D60
-        PY25Q16_ReadBuffer(0x002000 + channel, &state, 1);
+        PY25Q16_ReadBuffer(CHSTORE_AttributeAddr(channel), &state, 1);
 
         if (keep) {
             att.band = pVFO->Band;
@@ -1034,10 +1070,7 @@ void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep,
 #endif
         if(save)
         {
-            uint8_t buf[224];
-            PY25Q16_ReadBuffer(0x002000, buf, sizeof(buf));
-            buf[channel] = state.__val;
-            PY25Q16_WriteBuffer(0x002000, buf, sizeof(buf), true);
+            PY25Q16_WriteBuffer(CHSTORE_AttributeAddr(channel), &state, 1, false);
         }
 
         gMR_ChannelAttributes[channel] = att;
@@ -1150,7 +1183,7 @@ void SETTINGS_ResetTxLock(void)
     for (uint32_t i = 0; i < SETTINGS_ResetTxLock_BATCH; i++)
     {
         uint32_t Offset = i * BatchSize;
-        PY25Q16_ReadBuffer(0 + Offset, Buf, sizeof(Buf));
+        PY25Q16_ReadBuffer(CHSTORE_RecordAddr(0) + Offset, Buf, sizeof(Buf));
 
         uint8_t *State;
         for (uint8_t channel = 0; channel < BatchChCnt; channel++)
@@ -1160,9 +1193,11 @@ void SETTINGS_ResetTxLock(void)
             State[4] |= (1 << 6);
         }
 
-        PY25Q16_WriteBuffer(0 + Offset, Buf, sizeof(Buf), false);
+        PY25Q16_WriteBuffer(CHSTORE_RecordAddr(0) + Offset, Buf, sizeof(Buf), false);
     }
 
+    CHSTORE_Invalidate();
+
 #undef SETTINGS_ResetTxLock_BATCH
 }
 #endif
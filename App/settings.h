@@ -126,6 +126,9 @@ enum ACTION_OPT_t {
 #ifdef ENABLE_REGA
     ACTION_OPT_REGA_ALARM,
     ACTION_OPT_REGA_TEST,
+#endif
+#ifdef ENABLE_CHANNEL_ZONES
+    ACTION_OPT_ZONE,
 #endif
     ACTION_OPT_LEN
 };
@@ -165,6 +168,9 @@ typedef struct {
     uint8_t               ScreenChannel[2]; // current channels set in the radio (memory or frequency channels)
     uint8_t               FreqChannel[2]; // last frequency channels used
     uint8_t               MrChannel[2]; // last memory channels used
+#ifdef ENABLE_CHANNEL_ZONES
+    uint8_t               CHANNEL_ZONE; // memory channel zone shown, see chstore.c
+#endif
 #ifdef ENABLE_NOAA
     uint8_t           NoaaChannel[2];
 #endif
@@ -0,0 +1,206 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+/**
+ * -----------------------------------
+ * Cooperative tasks
+ *
+ *    Full-screen apps (spectrum, breakout) loop on their own instead of
+ *    returning to the main loop, so APP_Update() and APP_TimeSlice10ms()
+ *    do not run. Such an app hands its step function to TASK_RunApp(),
+ *    which runs it in turn with the system services below, each when its
+ *    period has passed. A service waits at most one app step.
+ *
+ *    Only services that leave the BK4819 and the display alone run here:
+ *    the app owns both. Dual watch, scanning, screenshots and the main
+ *    screen resume when the app returns.
+ *
+ *    Of the UART commands, only reads run while the app does (see
+ *    UART_IsAppSafeCommand()); anything else waits for the app to return.
+ *    While the app has the flash sector cache lent, journal flushes wait
+ *    too.
+ *
+ *    The time each task takes is summed per 10 ms slice into gTASK_Stats.
+ * ------------------------------------
+ */
+
+#include <string.h>
+
+#include "app/uart.h"
+#include "board.h"
+#include "driver/py25q16.h"
+#include "driver/py25q16_journal.h"
+#include "driver/systick.h"
+#include "functions.h"
+#include "helper/battery.h"
+#include "misc.h"
+#include "task.h"
+
+typedef struct
+{
+    TASK_Step_t Step;
+    uint8_t Period10ms;
+} Service_t;
+
+static void Commands(void);
+static void Journal(void);
+static void Battery(void);
+
+static const Service_t Services[] = {
+    [TASK_COMMANDS - 1] = {Commands, 1},
+    [TASK_JOURNAL - 1] = {Journal, 1},
+    [TASK_BATTERY - 1] = {Battery, 100},
+};
+
+_Static_assert(sizeof(Services) / sizeof(Services[0]) == TASK_COUNT - 1, "one service per task");
+
+TASK_Stats_t gTASK_Stats;
+
+static uint32_t Used[TASK_COUNT]; // in the current slice
+static uint32_t Slice;            // gGlobalSysTickCounter of the current slice
+static uint32_t LastRun[TASK_COUNT];
+
+static bool Held[2]; // per port: a command waits in its buffer
+
+static void Serve(uint32_t Port)
+{
+    if (!Held[Port] && !UART_IsCommandAvailable(Port))
+    {
+        return;
+    }
+
+    // The rest would write the flash, the BK4819 or the VFOs under the app
+    Held[Port] = !UART_IsAppSafeCommand(Port);
+    if (!Held[Port])
+    {
+        UART_HandleCommand(Port);
+    }
+}
+
+static void Commands(void)
+{
+#if defined(ENABLE_UART)
+    Serve(UART_PORT_UART);
+#endif
+#if defined(ENABLE_USB)
+    Serve(UART_PORT_VCP);
+#endif
+}
+
+// Journal sectors are programmed directly, but a flush may compact and
+// erase; that waits too
+static void Journal(void)
+{
+    if (!PY25Q16_IsSectorCacheLent())
+    {
+        JOURNAL_FlushStep();
+    }
+}
+
+// As APP_TimeSlice500ms() does every second, without drawing
+static void Battery(void)
+{
+    if (gCurrentFunction == FUNCTION_TRANSMIT)
+    {
+        return;
+    }
+
+    BOARD_ADC_GetBatteryInfo(&gBatteryVoltages[gBatteryVoltageIndex++], &gBatteryCurrent);
+    if (gBatteryVoltageIndex > 3)
+    {
+        gBatteryVoltageIndex = 0;
+    }
+    BATTERY_GetReadings(false);
+}
+
+static void EndSlice(void)
+{
+    const uint32_t Now = gGlobalSysTickCounter;
+
+    if (Now == Slice)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < TASK_COUNT; i++)
+    {
+        const uint16_t Us = Used[i] < 0xffff ? Used[i] : 0xffff;
+
+        gTASK_Stats.SliceUs[i] = Us;
+        if (Us > gTASK_Stats.PeakUs[i])
+        {
+            gTASK_Stats.PeakUs[i] = Us;
+        }
+        Used[i] = 0;
+    }
+
+    Slice = Now;
+}
+
+static void Run(TASK_Id_t Id, TASK_Step_t Step)
+{
+    const uint32_t Start = SYSTICK_GetUs();
+
+    Step();
+
+    Used[Id] += SYSTICK_GetUs() - Start;
+    gTASK_Stats.Runs[Id]++;
+    LastRun[Id] = gGlobalSysTickCounter;
+    EndSlice();
+}
+
+void TASK_RunApp(TASK_Step_t Step, const bool *pRunning)
+{
+    memset(Used, 0, sizeof(Used));
+    Slice = gGlobalSysTickCounter;
+
+    uint32_t ServedUs = SYSTICK_GetUs();
+
+    while (*pRunning)
+    {
+        Run(TASK_APP, Step);
+
+        const uint32_t Now = SYSTICK_GetUs();
+        if (Now - ServedUs > gTASK_Stats.MaxGapUs)
+        {
+            gTASK_Stats.MaxGapUs = Now - ServedUs;
+        }
+        ServedUs = Now;
+
+        for (uint8_t i = TASK_APP + 1; i < TASK_COUNT; i++)
+        {
+            const Service_t *pService = &Services[i - 1];
+
+            if (gGlobalSysTickCounter - LastRun[i] >= pService->Period10ms)
+            {
+                Run(i, pService->Step);
+            }
+        }
+    }
+
+    // The app is done: held commands run now, before the main loop reads
+    // the next ones over them
+    for (uint32_t Port = 0; Port < 2; Port++)
+    {
+        if (Held[Port])
+        {
+            Held[Port] = false;
+            UART_HandleCommand(Port);
+        }
+    }
+}
+
+void TASK_ResetStats(void)
+{
+    memset(&gTASK_Stats, 0, sizeof(gTASK_Stats));
+}
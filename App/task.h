@@ -0,0 +1,45 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef void (*TASK_Step_t)(void);
+
+typedef enum
+{
+    TASK_APP,       // the full-screen app
+    TASK_COMMANDS,  // UART and USB commands
+    TASK_JOURNAL,   // deferred settings writes
+    TASK_BATTERY,
+    TASK_COUNT
+} TASK_Id_t;
+
+// Layout read by tools/serialtool/_tasks.py
+typedef struct
+{
+    uint16_t SliceUs[TASK_COUNT];  // time used in the last 10 ms slice, saturating
+    uint16_t PeakUs[TASK_COUNT];   // most used in one slice since the last reset
+    uint32_t Runs[TASK_COUNT];
+    uint32_t MaxGapUs;             // longest wait of the services for the app
+} TASK_Stats_t;
+
+extern TASK_Stats_t gTASK_Stats;
+
+void TASK_RunApp(TASK_Step_t Step, const bool *pRunning);
+void TASK_ResetStats(void);
+
+#endif
@@ -37,6 +37,7 @@
 #include "ui/main.h"
 #include "ui/ui.h"
 #include "audio.h"
+#include "chstore.h"
 
 #ifdef ENABLE_FEAT_F4HWN
     #include "driver/system.h"
@@ -802,7 +803,7 @@ void UI_DisplayMain(void)
             const unsigned int x = 2;
             const bool inputting = gInputBoxIndex != 0 && gEeprom.TX_VFO == vfo_num;
             if (!inputting)
-                sprintf(String, "M%u", gEeprom.ScreenChannel[vfo_num] + 1);
+                sprintf(String, "M%u", CHSTORE_Number(gEeprom.ScreenChannel[vfo_num]));
             else
                 sprintf(String, "M%.3s", INPUTBOX_GetAscii());  // show the input text
             UI_PrintStringSmallNormal(String, x, 0, line + 1);
@@ -956,7 +957,7 @@ void UI_DisplayMain(void)
                         break;
 
                     case MDF_CHANNEL:   // show the channel number
-                        sprintf(String, "CH-%03u", gEeprom.ScreenChannel[vfo_num] + 1);
+                        sprintf(String, "CH-%03u", CHSTORE_Number(gEeprom.ScreenChannel[vfo_num]));
                         UI_PrintString(String, 32, 0, line, 8);
                         break;
 
@@ -966,7 +967,7 @@ void UI_DisplayMain(void)
                         SETTINGS_FetchChannelName(String, gEeprom.ScreenChannel[vfo_num]);
                         if (String[0] == 0)
                         {   // no channel name, show the channel number instead
-                            sprintf(String, "CH-%03u", gEeprom.ScreenChannel[vfo_num] + 1);
+                            sprintf(String, "CH-%03u", CHSTORE_Number(gEeprom.ScreenChannel[vfo_num]));
                         }
 
                         if (gEeprom.CHANNEL_DISPLAY_MODE == MDF_NAME) {
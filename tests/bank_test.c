@@ -0,0 +1,251 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// Double-buffered config sectors (driver/py25q16.c) on the fake flash chip
+
+#include <string.h>
+
+#include "driver/py25q16.h"
+#include "fake_flash.h"
+#include "test.h"
+
+#define NAMES 0x00e000 // Banked, not journaled
+#define NAMES_ALT (0x030000 + NAMES)
+#define IMAGE_SIZE 0xc80
+
+typedef struct
+{
+    uint16_t Offset;
+    uint8_t Value;
+    uint8_t Size;
+} Step_t;
+
+// Bit-clear writes in place, and some that need an erase
+static const Step_t STEPS[] = {
+    {0x000, 'A', 16},  // First one: commit
+    {0x100, 0x7f, 32}, // Blank to data
+    {0x100, 0x3f, 32}, // Bit-clear
+    {0x010, 'z', 16},
+    {0x000, 'B', 16},  // 'A' -> 'B' sets a bit
+    {0x200, 0x55, 64},
+    {0x200, 0x11, 64},
+    {0xc70, 0x01, 16}, // End of the mapping
+    {0x200, 0x01, 8},
+    {0x300, 0x00, 8},
+    {0x400, 0x00, 8},  // Out of check slots
+    {0x100, 0xff, 32}, // Back to blank
+};
+
+#define STEP_COUNT (sizeof(STEPS) / sizeof(STEPS[0]))
+
+static uint8_t States[STEP_COUNT + 1][IMAGE_SIZE];
+static uint32_t EraseSteps; // Bit set: that step erased
+
+static void Boot(void)
+{
+    PY25Q16_Init();
+}
+
+static bool Apply(const Step_t *pStep)
+{
+    uint8_t Data[64];
+
+    memset(Data, pStep->Value, pStep->Size);
+    return PY25Q16_WriteBuffer(NAMES + pStep->Offset, Data, pStep->Size, false);
+}
+
+static void Load(uint8_t *pImage)
+{
+    PY25Q16_ReadBuffer(NAMES, pImage, IMAGE_SIZE);
+}
+
+static void TestInPlace(void)
+{
+    FakeFlash_Init();
+    Boot();
+    memset(&gFakeFlash_Counts, 0, sizeof(gFakeFlash_Counts));
+
+    // Blank at home, no footer yet: the first write commits
+    Apply(STEPS + 0);
+    CHECK_EQ(gFakeFlash_Counts.Erases, 1);
+    CHECK_EQ(gFakeFlash_SectorErases[NAMES_ALT / FAKE_FLASH_SECTOR], 1);
+
+    // Then bit-clear writes program the copy in use, no erase
+    for (uint32_t i = 1; i <= 3; i++)
+    {
+        Apply(STEPS + i);
+    }
+    CHECK_EQ(gFakeFlash_Counts.Erases, 1);
+    CHECK(0 == memcmp(FakeFlash + NAMES_ALT + 0x100, "\x3f\x3f\x3f\x3f", 4));
+
+    // Setting a bit commits to the other copy
+    Apply(STEPS + 4);
+    CHECK_EQ(gFakeFlash_Counts.Erases, 2);
+    CHECK_EQ(gFakeFlash_SectorErases[NAMES / FAKE_FLASH_SECTOR], 1);
+
+    uint8_t Image[IMAGE_SIZE];
+    Load(Image);
+    CHECK_EQ(Image[0], 'B');
+    CHECK_EQ(Image[0x10], 'z');
+    CHECK_EQ(Image[0x100], 0x3f);
+
+    Boot();
+    uint8_t Again[IMAGE_SIZE];
+    Load(Again);
+    CHECK(0 == memcmp(Image, Again, IMAGE_SIZE));
+}
+
+static void TestCheckSlots(void)
+{
+    FakeFlash_Init();
+    Boot();
+    Apply(STEPS + 0);
+
+    // One check slot per update in place, then a commit frees them
+    uint8_t Mask = 0xff;
+    uint32_t Erases = gFakeFlash_Counts.Erases;
+    uint32_t InPlace = 0;
+    while (Erases == gFakeFlash_Counts.Erases)
+    {
+        Mask >>= 1;
+        PY25Q16_WriteBuffer(NAMES + 0x800, &Mask, 1, false);
+        InPlace++;
+    }
+    CHECK_EQ(InPlace, 6); // 5 slots after the commit's own
+
+    Boot();
+    uint8_t Value;
+    PY25Q16_ReadBuffer(NAMES + 0x800, &Value, 1);
+    CHECK_EQ(Value, Mask);
+}
+
+static void TestLentCache(void)
+{
+    FakeFlash_Init();
+    Boot();
+    Apply(STEPS + 0);
+
+    // Writes are refused while the cache is scratch somewhere else
+    uint8_t *pScratch = PY25Q16_BorrowSectorCache();
+    memset(pScratch, 0x5a, 4096);
+    const uint32_t Programs = gFakeFlash_Counts.Programs;
+    CHECK(!Apply(STEPS + 4));
+    CHECK_EQ(gFakeFlash_Counts.Programs, Programs);
+    CHECK_EQ(pScratch[4095], 0x5a);
+
+    uint8_t Image[IMAGE_SIZE];
+    Load(Image);
+    CHECK_EQ(Image[0], 'A');
+
+    PY25Q16_ReturnSectorCache();
+    CHECK(Apply(STEPS + 4));
+    Load(Image);
+    CHECK_EQ(Image[0], 'B');
+}
+
+// Reference run: the image after each step, and which steps erased
+static void Record(void)
+{
+    FakeFlash_Init();
+    Boot();
+    Load(States[0]);
+
+    EraseSteps = 0;
+    for (uint32_t i = 0; i < STEP_COUNT; i++)
+    {
+        const uint32_t Erases = gFakeFlash_Counts.Erases;
+        Apply(STEPS + i);
+        Load(States[i + 1]);
+        if (gFakeFlash_Counts.Erases != Erases)
+        {
+            EraseSteps |= 1u << i;
+        }
+    }
+}
+
+static int FindState(const uint8_t *pImage)
+{
+    for (int i = STEP_COUNT; i >= 0; i--)
+    {
+        if (0 == memcmp(pImage, States[i], IMAGE_SIZE))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void TestPowerCut(void)
+{
+    Record();
+
+    for (uint32_t Cut = 1;; Cut++)
+    {
+        FakeFlash_Init();
+        Boot();
+
+        jmp_buf Resume;
+        volatile uint32_t Step = 0;
+        if (0 == setjmp(Resume))
+        {
+            FakeFlash_CutPowerAt(Cut, &Resume);
+            for (; Step < STEP_COUNT; Step++)
+            {
+                Apply(STEPS + Step);
+            }
+            FakeFlash_CutPowerAt(0, NULL);
+            break; // Every erase and program of the run has been cut once
+        }
+        FakeFlash_CutPowerAt(0, NULL);
+
+        // Step was cut: its old or new image, or one since the copy not in
+        // use was last written, from before the last step that erased
+        uint32_t Floor = 0;
+        for (uint32_t i = 0; i < Step; i++)
+        {
+            if ((EraseSteps >> i) & 1)
+            {
+                Floor = i;
+            }
+        }
+
+        Boot();
+        uint8_t Image[IMAGE_SIZE];
+        Load(Image);
+        const int State = FindState(Image);
+        if (State < (int)Floor || State > (int)Step + 1)
+        {
+            printf("  cut %u in step %u: state %d\n", Cut, Step, State);
+            CHECK(false);
+            continue;
+        }
+
+        // Still writable: redo the lost steps, survive a reboot
+        for (uint32_t i = State; i < STEP_COUNT; i++)
+        {
+            Apply(STEPS + i);
+        }
+        Boot();
+        Load(Image);
+        CHECK(0 == memcmp(Image, States[STEP_COUNT], IMAGE_SIZE));
+    }
+}
+
+int main(void)
+{
+    RUN(TestInPlace);
+    RUN(TestCheckSlots);
+    RUN(TestLentCache);
+    RUN(TestPowerCut);
+    return TEST_RESULT();
+}
@@ -0,0 +1,127 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// BK4819 bit-banged bus (driver/bk4829.c) on the fake chip, and what a
+// spectrum hop costs on it
+
+#include <string.h>
+
+#include "driver/bk4819.h"
+#include "fake_bk4819.h"
+#include "settings.h"
+#include "test.h"
+
+EEPROM_Config_t gEeprom;
+
+static void Setup(void)
+{
+    FakeBK4819_Init();
+    BK4819_Init();
+    FakeBK4819_Reset();
+}
+
+static void TestWriteRead(void)
+{
+    Setup();
+
+    BK4819_WriteRegister(BK4819_REG_38, 0x1234);
+    CHECK_EQ(gFakeBK4819_Regs[0x38], 0x1234);
+    CHECK_EQ(gFakeBK4819_Counts.Writes, 1);
+    CHECK(!FakeBK4819_IsSelected());
+
+    gFakeBK4819_Regs[0x67] = 0xa5a5;
+    CHECK_EQ(BK4819_GetRSSI(), 0x01a5);
+    CHECK_EQ(BK4819_ReadRegister(BK4819_REG_38), 0x1234);
+    CHECK_EQ(gFakeBK4819_Counts.Reads, 2);
+
+    CHECK_EQ(gFakeBK4819_Counts.Bad, 0);
+    CHECK_EQ(gFakeBK4819_Counts.Clocks, 3 * 24);
+    CHECK(!FakeBK4819_IsSelected());
+}
+
+// As app/spectrum.c: retune, restart the RX chain, read glitch and RSSI
+static void Hop(uint32_t Frequency)
+{
+    BK4819_SetFrequency(Frequency);
+    BK4819_PickRXFilterPathBasedOnFrequency(Frequency);
+    BK4819_WriteRegister(BK4819_REG_30, 0);
+    BK4819_WriteRegister(BK4819_REG_30, 0xbff1);
+    BK4819_GetGlitchIndicator();
+    BK4819_GetRSSI();
+}
+
+static void TestHopCycles(void)
+{
+    enum { HOPS = 100 };
+
+    Setup();
+    Hop(14400000);
+    FakeBK4819_Reset();
+
+    // 12.5 kHz steps: REG_38 changes, REG_39 and the LNA path mostly don't
+    uint32_t HighChanges = 0;
+    for (uint32_t i = 1; i <= HOPS; i++)
+    {
+        const uint32_t Frequency = 14400000 + i * 1250;
+        HighChanges += (Frequency >> 16) != ((Frequency - 1250) >> 16);
+        Hop(Frequency);
+    }
+
+    const FakeBK4819_Counts_t *pCounts = &gFakeBK4819_Counts;
+    const uint32_t Frames = pCounts->Writes + pCounts->Reads;
+
+    printf("  per hop: %.2f frames, %.1f bus cycles, %.1f pin writes\n",
+           (double)Frames / HOPS, (double)pCounts->Clocks / HOPS, (double)pCounts->Pins / HOPS);
+
+    CHECK_EQ(pCounts->Bad, 0);
+    CHECK_EQ(pCounts->Clocks, Frames * 24);
+    CHECK_EQ(pCounts->Reads, HOPS * 2);
+    CHECK_EQ(pCounts->Writes, HOPS * 3 + HighChanges); // REG_38, REG_30 twice
+    CHECK_EQ(gFakeBK4819_Regs[0x38], (14400000 + HOPS * 1250) & 0xffff);
+}
+
+// radio.c keeps its quick retune only while no RX setup register changed
+static void TestRxSetupWrites(void)
+{
+    Setup();
+
+    uint32_t Writes = BK4819_GetRxSetupWrites();
+    BK4819_SetFrequency(43300000);
+    BK4819_WriteRegister(BK4819_REG_3F, 0);
+    BK4819_WriteRegister(BK4819_REG_30, 0xbff1);
+    CHECK_EQ(BK4819_GetRxSetupWrites(), Writes);
+
+    BK4819_WriteRegister(BK4819_REG_4D, 0xa000 | 70);
+    CHECK(BK4819_GetRxSetupWrites() != Writes);
+
+    // Same value again: skipped on the bus, nothing changed
+    Writes = BK4819_GetRxSetupWrites();
+    BK4819_WriteRegister(BK4819_REG_4D, 0xa000 | 70);
+    CHECK_EQ(BK4819_GetRxSetupWrites(), Writes);
+
+    BK4819_SetFilterBandwidth(BK4819_FILTER_BW_NARROW, false);
+    BK4819_SetFilterBandwidth(BK4819_FILTER_BW_WIDE, false);
+    CHECK(BK4819_GetRxSetupWrites() != Writes);
+
+    Writes = BK4819_GetRxSetupWrites();
+    BK4819_WriteRegister(BK4819_REG_00, 0x8000);
+    CHECK(BK4819_GetRxSetupWrites() != Writes);
+}
+
+int main(void)
+{
+    RUN(TestWriteRead);
+    RUN(TestHopCycles);
+    RUN(TestRxSetupWrites);
+    return TEST_RESULT();
+}
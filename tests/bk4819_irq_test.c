@@ -0,0 +1,144 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// BK4819 interrupt edge queue (driver/bk4819_irq.c), the EXTI handler
+// called as the NVIC would
+
+#include "driver/bk4819_irq.h"
+#include "driver/systick.h"
+#include "fake_hw.h"
+#include "test.h"
+
+#define QUEUE_SIZE 8
+#define IRQ_LINE   LL_EXTI_LINE_7
+
+// An edge on PB7 at the current time, then 10 us pass
+static uint32_t Edge(void)
+{
+    const uint32_t Time = SYSTICK_GetUs();
+
+    Fake_ExtiPending |= IRQ_LINE;
+    EXTI4_15_IRQHandler();
+    CHECK_EQ(Fake_ExtiPending & IRQ_LINE, 0);
+    SYSTICK_DelayUs(10);
+    return Time;
+}
+
+static uint32_t Drain(void)
+{
+    uint32_t Time;
+    uint32_t Count = 0;
+
+    while (BK4819_IRQ_Pop(&Time))
+    {
+        Count++;
+    }
+    return Count;
+}
+
+static void TestOrder(void)
+{
+    BK4819_IRQ_Init();
+    Drain();
+
+    uint32_t Times[3];
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        Times[i] = Edge();
+    }
+
+    uint32_t Time;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        CHECK(BK4819_IRQ_Pop(&Time));
+        CHECK_EQ(Time, Times[i]);
+    }
+    CHECK(!BK4819_IRQ_Pop(&Time));
+}
+
+static void TestOtherLine(void)
+{
+    Drain();
+
+    // Another EXTI line of the shared vector: not ours, left pending
+    Fake_ExtiPending = LL_EXTI_LINE_7 << 1;
+    EXTI4_15_IRQHandler();
+    CHECK_EQ(Fake_ExtiPending, LL_EXTI_LINE_7 << 1);
+    Fake_ExtiPending = 0;
+
+    CHECK_EQ(Drain(), 0);
+}
+
+static void TestOverflow(void)
+{
+    Drain();
+
+    // Full: later edges are dropped, the queued ones stay in order
+    uint32_t Times[QUEUE_SIZE + 3];
+    for (uint32_t i = 0; i < QUEUE_SIZE + 3; i++)
+    {
+        Times[i] = Edge();
+    }
+
+    uint32_t Time;
+    for (uint32_t i = 0; i < QUEUE_SIZE; i++)
+    {
+        CHECK(BK4819_IRQ_Pop(&Time));
+        CHECK_EQ(Time, Times[i]);
+    }
+    CHECK(!BK4819_IRQ_Pop(&Time));
+
+    // And it takes edges again once drained
+    const uint32_t After = Edge();
+    CHECK(BK4819_IRQ_Pop(&Time));
+    CHECK_EQ(Time, After);
+}
+
+static void TestWrap(void)
+{
+    Drain();
+
+    // Head and Tail are 8 bits and run free: go round them a few times with
+    // the queue at every fill level
+    for (uint32_t Round = 0; Round < 3 * 256; Round++)
+    {
+        const uint32_t Fill = Round % (QUEUE_SIZE + 1);
+        uint32_t Times[QUEUE_SIZE];
+
+        for (uint32_t i = 0; i < Fill; i++)
+        {
+            Times[i] = Edge();
+        }
+
+        uint32_t Time;
+        for (uint32_t i = 0; i < Fill; i++)
+        {
+            if (!BK4819_IRQ_Pop(&Time) || Time != Times[i])
+            {
+                printf("  round %u: edge %u of %u\n", Round, i, Fill);
+                CHECK(false);
+                return;
+            }
+        }
+        CHECK(!BK4819_IRQ_Pop(&Time));
+    }
+}
+
+int main(void)
+{
+    RUN(TestOrder);
+    RUN(TestOtherLine);
+    RUN(TestOverflow);
+    RUN(TestWrap);
+    return TEST_RESULT();
+}
@@ -0,0 +1,221 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// BK4819 bus profiler (driver/bk4819_profile.c) fed by the driver itself:
+// a scripted session is replayed through driver/bk4829.c on the fake chip,
+// with 1 us per bus clock, and the report printed as "serialtool bkprof"
+// does. Given a file name, the raw profile is also saved there, which
+// "serialtool bkprof --replay" reads like a dump from a radio.
+
+#include <string.h>
+
+#include "driver/bk4819.h"
+#include "driver/bk4819_profile.h"
+#include "driver/systick.h"
+#include "fake_bk4819.h"
+#include "fake_hw.h"
+#include "settings.h"
+#include "test.h"
+
+#define PORT_B 1
+#define MASK_SCL LL_GPIO_PIN_8
+
+EEPROM_Config_t gEeprom;
+
+static const char *const CALLERS[BK4819_CALLER_COUNT] = {"other", "scan", "spectrum", "am fix", "irq", "ui"};
+
+static uint32_t Clocks[BK4819_CALLER_COUNT]; // expected bus time per caller
+static uint8_t Current;
+
+// Bus time: each SCL rising edge in a frame costs 1 us
+static void ClockTick(uint32_t Port, uint32_t Mask, bool Level)
+{
+    if (PORT_B == Port && (Mask & MASK_SCL) && Level && FakeBK4819_IsSelected())
+    {
+        SYSTICK_DelayUs(1);
+        Clocks[Current]++;
+    }
+}
+
+static void Enter(BK4819_Caller_t Caller, uint8_t *pSaved)
+{
+    *pSaved = Current;
+    Current = Caller;
+    BK4819_PROFILE_BEGIN(Caller);
+}
+
+static void Leave(uint8_t Saved)
+{
+    BK4819_PROFILE_END();
+    Current = Saved;
+}
+
+// As app/chFrScanner.c and app/spectrum.c: retune and read the signal
+static void Hop(uint32_t Frequency)
+{
+    BK4819_SetFrequency(Frequency);
+    BK4819_PickRXFilterPathBasedOnFrequency(Frequency);
+    BK4819_WriteRegister(BK4819_REG_30, 0);
+    BK4819_WriteRegister(BK4819_REG_30, 0xbff1);
+    BK4819_GetRSSI();
+}
+
+static void Session(void)
+{
+    uint8_t Saved;
+
+    BK4819_Init();
+
+    Enter(BK4819_CALLER_SCAN, &Saved);
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        Hop(43300000 + i * 2500);
+    }
+    Leave(Saved);
+
+    Enter(BK4819_CALLER_SPECTRUM, &Saved);
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        Hop(14400000 + i * 1250);
+        BK4819_GetGlitchIndicator();
+
+        // AM fix runs inside the spectrum loop and is charged to itself
+        if (i % 8 == 0)
+        {
+            uint8_t Inner;
+            Enter(BK4819_CALLER_AM_FIX, &Inner);
+            BK4819_WriteRegister(BK4819_REG_13, 0x03be + i);
+            BK4819_GetRSSI();
+            Leave(Inner);
+        }
+    }
+    Leave(Saved);
+
+    Enter(BK4819_CALLER_IRQ, &Saved);
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        BK4819_ReadRegister(BK4819_REG_0C);
+        BK4819_WriteRegister(BK4819_REG_02, 0);
+    }
+    Leave(Saved);
+}
+
+static void Report(const BK4819_Profile_t *pProfile)
+{
+    uint32_t TotalUs = 0;
+    uint32_t TotalCalls = 0;
+
+    for (uint32_t i = 0; i < BK4819_CALLER_COUNT; i++)
+    {
+        TotalUs += pProfile->BusUs[i];
+        TotalCalls += pProfile->Calls[i];
+    }
+
+    printf("caller      bus(ms)  share    calls  avg(us)\n");
+    for (uint32_t i = 0; i < BK4819_CALLER_COUNT; i++)
+    {
+        if (!pProfile->Calls[i])
+            continue;
+        printf("%-10s %8.1f %5.1f%% %8u %8.1f\n", CALLERS[i], pProfile->BusUs[i] / 1000.0,
+               TotalUs ? 100.0 * pProfile->BusUs[i] / TotalUs : 0.0, pProfile->Calls[i],
+               (double)pProfile->BusUs[i] / pProfile->Calls[i]);
+    }
+    printf("%-10s %8.1f        %8u\n", "total", TotalUs / 1000.0, TotalCalls);
+
+    if (pProfile->WorstUs)
+    {
+        printf("worst call: %u us, %s REG_%02X, %s\n", pProfile->WorstUs,
+               pProfile->WorstRegister & 0x80 ? "read" : "write", pProfile->WorstRegister & 0x7f,
+               pProfile->WorstCaller < BK4819_CALLER_COUNT ? CALLERS[pProfile->WorstCaller] : "?");
+    }
+
+    // Busiest registers first, ties in register order
+    bool Shown[128] = {false};
+    printf("register    reads   writes\n");
+    for (uint32_t n = 0; n < 16; n++)
+    {
+        int Best = -1;
+        for (int r = 0; r < 128; r++)
+        {
+            const uint32_t Count = pProfile->Reads[r] + pProfile->Writes[r];
+            if (!Shown[r] && Count &&
+                (Best < 0 || Count > (uint32_t)(pProfile->Reads[Best] + pProfile->Writes[Best])))
+            {
+                Best = r;
+            }
+        }
+        if (Best < 0)
+            break;
+        Shown[Best] = true;
+        printf("REG_%02X   %8u %8u%s\n", Best, pProfile->Reads[Best], pProfile->Writes[Best],
+               (pProfile->Reads[Best] == 0xffff || pProfile->Writes[Best] == 0xffff) ? "+" : "");
+    }
+}
+
+static const char *Dump;
+
+static void TestReplay(void)
+{
+    FakeBK4819_Init();
+    Fake_AddPinHook(ClockTick);
+    BK4819_ProfileReset();
+
+    Session();
+
+    const BK4819_Profile_t *pProfile = &gBK4819_Profile;
+    Report(pProfile);
+
+    // Every bus frame counted once, against its register
+    uint32_t Reads = 0;
+    uint32_t Writes = 0;
+    for (uint32_t r = 0; r < 128; r++)
+    {
+        Reads += pProfile->Reads[r];
+        Writes += pProfile->Writes[r];
+    }
+    CHECK_EQ(Reads, gFakeBK4819_Counts.Reads);
+    CHECK_EQ(Writes, gFakeBK4819_Counts.Writes);
+    CHECK_EQ(pProfile->Reads[0x0c], 10);
+    CHECK_EQ(pProfile->Writes[0x02], 10); // interrupt flags: never skipped
+    CHECK_EQ(pProfile->Writes[0x13], 1 + 8); // BK4819_Init(), then AM fix
+
+    // Bus time charged to whoever was on the bus, delays left out
+    for (uint32_t i = 0; i < BK4819_CALLER_COUNT; i++)
+    {
+        CHECK_EQ(pProfile->BusUs[i], Clocks[i]);
+    }
+    CHECK_EQ(pProfile->Calls[BK4819_CALLER_IRQ], 20);
+    CHECK_EQ(pProfile->Calls[BK4819_CALLER_AM_FIX], 16);
+
+    CHECK(pProfile->WorstUs >= 24);
+    CHECK(pProfile->WorstUs <= Clocks[pProfile->WorstCaller]);
+
+    if (Dump)
+    {
+        FILE *pFile = fopen(Dump, "wb");
+        CHECK(pFile != NULL);
+        if (pFile)
+        {
+            CHECK_EQ(fwrite(pProfile, sizeof(*pProfile), 1, pFile), 1);
+            fclose(pFile);
+            printf("  profile saved to %s\n", Dump);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Dump = argc > 1 ? argv[1] : NULL;
+    RUN(TestReplay);
+    return TEST_RESULT();
+}
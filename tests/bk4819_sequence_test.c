@@ -0,0 +1,291 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// BK4819 register tables (BK4819_RunSequence) against the per-call code they
+// replaced: same writes in the same order, same register image
+
+#include <string.h>
+
+#include "driver/bk4819.h"
+#include "driver/system.h"
+#include "driver/systick.h"
+#include "fake_bk4819.h"
+#include "settings.h"
+#include "test.h"
+
+EEPROM_Config_t gEeprom;
+
+// The code before the tables, one BK4819_WriteRegister() per line ------
+
+static void LegacyInit(void)
+{
+    BK4819_WriteRegister(BK4819_REG_00, 0x8000);
+    BK4819_WriteRegister(BK4819_REG_00, 0x0000);
+
+    BK4819_WriteRegister(BK4819_REG_37, 0x9D1F);
+    BK4819_WriteRegister(BK4819_REG_36, 0x0022);
+
+    BK4819_WriteRegister(BK4819_REG_10, 0x0318);
+    BK4819_WriteRegister(BK4819_REG_11, 0x033A);
+    BK4819_WriteRegister(BK4819_REG_12, 0x03DB);
+    BK4819_WriteRegister(BK4819_REG_13, 0x03DF);
+    BK4819_WriteRegister(BK4819_REG_14, 0x0210);
+    BK4819_WriteRegister(BK4819_REG_49, 0x2AB2);
+    BK4819_WriteRegister(BK4819_REG_7B, 0x73DC);
+
+    BK4819_WriteRegister(BK4819_REG_7D, 0xE920);
+
+    BK4819_WriteRegister(BK4819_REG_48, 0x33A8);
+
+    BK4819_WriteRegister(0x40, 0x3516);
+
+    const uint8_t dtmf_coeffs[] = {111, 107, 103, 98, 80, 71, 58, 44, 65, 55, 37, 23, 228, 203, 181, 159};
+    for (unsigned int i = 0; i < sizeof(dtmf_coeffs); i++)
+        BK4819_WriteRegister(BK4819_REG_09, (i << 12) | dtmf_coeffs[i]);
+
+    BK4819_WriteRegister(0x1C, 0x07C0);
+    BK4819_WriteRegister(0x1D, 0xE555);
+    BK4819_WriteRegister(0x1E, 0x4C58);
+
+    BK4819_WriteRegister(BK4819_REG_1F, 0xC65A);
+    BK4819_WriteRegister(BK4819_REG_3E, 0x94C6);
+
+    BK4819_WriteRegister(0x73, 0x4691);
+    BK4819_WriteRegister(0x77, 0x88EF);
+    BK4819_WriteRegister(BK4819_REG_19, 0x104E);
+    BK4819_WriteRegister(BK4819_REG_28, 0x0B40);
+    BK4819_WriteRegister(BK4819_REG_29, 0xAA00);
+    BK4819_WriteRegister(0x2A, 0x6600);
+    BK4819_WriteRegister(0x2C, 0x1822);
+    BK4819_WriteRegister(0x2F, 0x9890);
+    BK4819_WriteRegister(0x53, 0x2028);
+    BK4819_WriteRegister(BK4819_REG_7E, 0x303E);
+    BK4819_WriteRegister(BK4819_REG_46, 0x600A);
+    BK4819_WriteRegister(0x4A, 0x5430);
+    BK4819_WriteRegister(BK4819_REG_07, 0x61CE);
+
+    BK4819_WriteRegister(BK4819_REG_33, 0x9000);
+    BK4819_WriteRegister(BK4819_REG_3F, 0);
+}
+
+static void LegacySleep(void)
+{
+    BK4819_WriteRegister(BK4819_REG_30, 0);
+    BK4819_WriteRegister(BK4819_REG_37, 0x1D00);
+}
+
+static void LegacyTurnsOffTones_TurnsOnRX(void)
+{
+    BK4819_WriteRegister(BK4819_REG_70, 0);
+    BK4819_WriteRegister(BK4819_REG_47, 0x6042 | (BK4819_AF_MUTE << 8));
+    BK4819_WriteRegister(BK4819_REG_50, 0x3B18);
+
+    BK4819_WriteRegister(BK4819_REG_30, 0);
+    BK4819_WriteRegister(BK4819_REG_30,
+        BK4819_REG_30_ENABLE_VCO_CALIB |
+        BK4819_REG_30_ENABLE_RX_LINK   |
+        BK4819_REG_30_ENABLE_AF_DAC    |
+        BK4819_REG_30_ENABLE_DISC_MODE |
+        BK4819_REG_30_ENABLE_PLL_VCO   |
+        BK4819_REG_30_ENABLE_RX_DSP);
+}
+
+static void LegacySetupAircopy(void)
+{
+    BK4819_WriteRegister(BK4819_REG_70, 0x00C3);
+    BK4819_WriteRegister(BK4819_REG_72, 0x3065);
+    BK4819_WriteRegister(BK4819_REG_58, 0x00C1);
+    BK4819_WriteRegister(BK4819_REG_5C, 0x5665);
+    BK4819_WriteRegister(BK4819_REG_5D, 0x4700);
+    BK4819_WriteRegister(0x5E, 0x3204);
+}
+
+static void LegacyResetFSK(void)
+{
+    BK4819_WriteRegister(BK4819_REG_3F, 0x0000);
+    BK4819_WriteRegister(BK4819_REG_59, 0x0068);
+
+    SYSTEM_DelayMs(30);
+
+    BK4819_WriteRegister(BK4819_REG_30, 0x0000);
+}
+
+static void LegacyExitBypass(void)
+{
+    BK4819_WriteRegister(BK4819_REG_47, 0x6042 | (BK4819_AF_MUTE << 8));
+
+    uint16_t regVal = BK4819_ReadRegister(BK4819_REG_7E);
+    BK4819_WriteRegister(BK4819_REG_7E, (regVal & ~(0b111 << 3)) | (5u << 3));
+}
+
+static void LegacyTxOn_Beep(void)
+{
+    BK4819_WriteRegister(BK4819_REG_36, 0);
+    BK4819_WriteRegister(BK4819_REG_37, 0x9D1F);
+    BK4819_WriteRegister(BK4819_REG_52, 0x028F);
+    BK4819_WriteRegister(BK4819_REG_30, 0x0000);
+    BK4819_WriteRegister(BK4819_REG_30, 0xC1FE);
+}
+
+static void LegacyEnterDTMF_TX(bool bLocalLoopback)
+{
+    BK4819_WriteRegister(BK4819_REG_21, 0x06D8);
+    BK4819_WriteRegister(BK4819_REG_24,
+        (1u   << BK4819_REG_24_SHIFT_UNKNOWN_15) |
+        (130u << BK4819_REG_24_SHIFT_THRESHOLD)  |
+        (1u   << BK4819_REG_24_SHIFT_UNKNOWN_6)  |
+                 BK4819_REG_24_ENABLE            |
+                 BK4819_REG_24_SELECT_DTMF       |
+        (15u  << BK4819_REG_24_SHIFT_MAX_SYMBOLS));
+    BK4819_WriteRegister(BK4819_REG_50, 0xBB18);
+    BK4819_WriteRegister(BK4819_REG_47, 0x6042 | ((bLocalLoopback ? BK4819_AF_BEEP : BK4819_AF_MUTE) << 8));
+
+    BK4819_WriteRegister(BK4819_REG_70, 0xC3C3);
+
+    BK4819_WriteRegister(BK4819_REG_30,
+        BK4819_REG_30_ENABLE_VCO_CALIB |
+        BK4819_REG_30_ENABLE_UNKNOWN   |
+        BK4819_REG_30_DISABLE_RX_LINK  |
+        BK4819_REG_30_ENABLE_AF_DAC    |
+        BK4819_REG_30_ENABLE_DISC_MODE |
+        BK4819_REG_30_ENABLE_PLL_VCO   |
+        BK4819_REG_30_ENABLE_PA_GAIN   |
+        BK4819_REG_30_DISABLE_MIC_ADC  |
+        BK4819_REG_30_ENABLE_TX_DSP    |
+        BK4819_REG_30_DISABLE_RX_DSP);
+}
+
+static void LegacyExitDTMF_TX(bool bKeep)
+{
+    BK4819_WriteRegister(BK4819_REG_50, 0xBB18);
+    BK4819_WriteRegister(BK4819_REG_47, 0x6042 | (BK4819_AF_MUTE << 8));
+    BK4819_WriteRegister(BK4819_REG_70, 0x0000);
+    BK4819_WriteRegister(BK4819_REG_24, 0);
+    BK4819_WriteRegister(BK4819_REG_30, 0xC1FE);
+    if (!bKeep)
+        BK4819_WriteRegister(BK4819_REG_50, 0x3B18);
+}
+
+// Harness ------
+
+typedef struct
+{
+    FakeBK4819_Write_t Log[FAKE_BK4819_LOG];
+    uint32_t Count;
+    uint16_t Regs[128];
+    uint32_t Us;
+} Trace_t;
+
+static Trace_t Old;
+static Trace_t New;
+
+// Same chip and shadow state for both runs: fresh from init, then some of
+// the registers the sequences touch moved away from it
+static void Prepare(bool Dirty)
+{
+    FakeBK4819_Init();
+    BK4819_Init();
+
+    if (Dirty)
+    {
+        BK4819_WriteRegister(BK4819_REG_30, 0x1234);
+        BK4819_WriteRegister(BK4819_REG_47, 0x6042 | (BK4819_AF_BEEP << 8));
+        BK4819_WriteRegister(BK4819_REG_70, 0xC3C3);
+        BK4819_WriteRegister(BK4819_REG_7E, 0x3006);
+        BK4819_WriteRegister(BK4819_REG_50, 0xBB18);
+        BK4819_WriteRegister(BK4819_REG_24, 0);
+    }
+
+    FakeBK4819_Reset();
+}
+
+static void Capture(Trace_t *pTrace, uint32_t Start)
+{
+    CHECK(gFakeBK4819_LogCount <= FAKE_BK4819_LOG);
+    CHECK_EQ(gFakeBK4819_Counts.Bad, 0);
+
+    memcpy(pTrace->Log, gFakeBK4819_Log, sizeof(pTrace->Log));
+    pTrace->Count = gFakeBK4819_LogCount;
+    memcpy(pTrace->Regs, gFakeBK4819_Regs, sizeof(pTrace->Regs));
+    pTrace->Us = SYSTICK_GetUs() - Start;
+}
+
+static void Compare(const char *pName)
+{
+    bool Same = Old.Count == New.Count && Old.Us == New.Us;
+
+    for (uint32_t i = 0; Same && i < Old.Count; i++)
+    {
+        Same = Old.Log[i].Register == New.Log[i].Register && Old.Log[i].Value == New.Log[i].Value;
+    }
+    Same = Same && 0 == memcmp(Old.Regs, New.Regs, sizeof(Old.Regs));
+
+    if (!Same)
+    {
+        printf("  %s: %u writes in %u us, was %u in %u us\n", pName, New.Count, New.Us, Old.Count, Old.Us);
+    }
+    CHECK(Same);
+}
+
+// Each sequence from a clean and a dirty state, then straight again, when
+// the shadow already holds most of it
+#define EQUIVALENT(Legacy, Table)                                  \
+    do                                                             \
+    {                                                              \
+        for (int Dirty = 0; Dirty < 2; Dirty++)                    \
+        {                                                          \
+            uint32_t Start;                                        \
+            Prepare(Dirty);                                        \
+            Start = SYSTICK_GetUs();                               \
+            Legacy;                                                \
+            Legacy;                                                \
+            Capture(&Old, Start);                                  \
+            Prepare(Dirty);                                        \
+            Start = SYSTICK_GetUs();                               \
+            Table;                                                 \
+            Table;                                                 \
+            Capture(&New, Start);                                  \
+            Compare(#Table);                                       \
+        }                                                          \
+    } while (0)
+
+static void TestInit(void)
+{
+    EQUIVALENT(LegacyInit(), BK4819_Init());
+
+    // All of it on the bus from any state: the soft reset drops the shadow
+    Prepare(true);
+    BK4819_Init();
+    CHECK_EQ(gFakeBK4819_LogCount, 50);
+}
+
+static void TestModeSwitches(void)
+{
+    EQUIVALENT(LegacySleep(), BK4819_Sleep());
+    EQUIVALENT(LegacyTurnsOffTones_TurnsOnRX(), BK4819_TurnsOffTones_TurnsOnRX());
+    EQUIVALENT(LegacySetupAircopy(), BK4819_SetupAircopy());
+    EQUIVALENT(LegacyResetFSK(), BK4819_ResetFSK());
+    EQUIVALENT(LegacyExitBypass(), BK4819_ExitBypass());
+    EQUIVALENT(LegacyTxOn_Beep(), BK4819_TxOn_Beep());
+    EQUIVALENT(LegacyEnterDTMF_TX(false), BK4819_EnterDTMF_TX(false));
+    EQUIVALENT(LegacyEnterDTMF_TX(true), BK4819_EnterDTMF_TX(true));
+    EQUIVALENT(LegacyExitDTMF_TX(false), BK4819_ExitDTMF_TX(false));
+    EQUIVALENT(LegacyExitDTMF_TX(true), BK4819_ExitDTMF_TX(true));
+}
+
+int main(void)
+{
+    RUN(TestInit);
+    RUN(TestModeSwitches);
+    return TEST_RESULT();
+}
@@ -0,0 +1,237 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// Heard log ring (heardlog.c) on the fake flash chip. Each record carries
+// a running number as its frequency: the log reads back in order when the
+// numbers run on without a gap.
+
+#include <string.h>
+
+#include "driver/bk4819.h"
+#include "driver/py25q16.h"
+#include "driver/systick.h"
+#include "fake_flash.h"
+#include "functions.h"
+#include "heardlog.h"
+#include "radio.h"
+#include "settings.h"
+#include "test.h"
+
+#define LOG_ADDR 0x052000
+#define LOG_SIZE 0x8000
+#define SECTOR 0x1000
+#define SLOTS (LOG_SIZE / sizeof(HeardRecord_t))
+#define PER_SECTOR (SECTOR / sizeof(HeardRecord_t))
+
+EEPROM_Config_t gEeprom;
+VFO_Info_t *gRxVfo;
+FUNCTION_Type_t gCurrentFunction;
+
+uint16_t BK4819_GetRSSI(void)
+{
+    return 0;
+}
+
+BK4819_CssScanResult_t BK4819_GetCxCSSScanResult(uint32_t *pCdcssFreq, uint16_t *pCtcssFreq)
+{
+    return BK4819_CSS_RESULT_NOT_FOUND;
+}
+
+static FREQ_Config_t Rx;
+static VFO_Info_t Vfo = {.pRX = &Rx};
+static uint32_t Seq; // Number of the next record
+
+static uint8_t Snapshot[LOG_SIZE];
+
+static void Boot(void)
+{
+    gGlobalSysTickCounter = 0;
+    PY25Q16_Init();
+    HEARDLOG_Init();
+}
+
+static void Log(uint32_t Count)
+{
+    while (Count--)
+    {
+        gGlobalSysTickCounter += 50;
+        Rx.Frequency = Seq++;
+        HEARDLOG_Open();
+        gGlobalSysTickCounter += 100;
+        HEARDLOG_Close();
+
+        // Now and then a partial page, as on a reset or from the menu
+        if (Seq % 37 == 0)
+        {
+            HEARDLOG_Flush();
+        }
+    }
+}
+
+// Reads the whole log: running numbers without a gap. Returns the one
+// after the newest, 0 if the log is empty.
+static uint32_t Verify(void)
+{
+    const uint16_t Count = HEARDLOG_Count();
+    HeardRecord_t Records[16];
+    uint32_t Expect = 0;
+
+    for (uint16_t Index = 0; Index < Count;)
+    {
+        const uint8_t Got = HEARDLOG_Read(Index, Records, 16);
+        CHECK(Got > 0);
+        if (!Got)
+            return 0;
+
+        for (uint8_t i = 0; i < Got; i++)
+        {
+            if (Index + i > 0 && Records[i].Frequency != Expect)
+            {
+                printf("  record %u: %u, expected %u\n", Index + i, Records[i].Frequency, Expect);
+                CHECK(false);
+                return 0;
+            }
+            Expect = Records[i].Frequency + 1;
+        }
+        Index += Got;
+    }
+
+    return Expect;
+}
+
+static void Start(void)
+{
+    FakeFlash_Init();
+    gRxVfo = &Vfo;
+    Seq = 1000;
+    Boot();
+}
+
+static void TestWrap(void)
+{
+    Start();
+    CHECK_EQ(HEARDLOG_Count(), 0);
+
+    // Several laps, with reboots in between and an unsaved tail lost
+    uint8_t Boots = 0;
+    for (uint32_t Run = 0; Run < 12; Run++)
+    {
+        Log(500);
+        CHECK_EQ(Verify(), Seq);
+
+        HEARDLOG_Flush();
+        Boot();
+        Boots++;
+        CHECK_EQ(Verify(), Seq);
+
+        // Once wrapped, all but the sector being filled is kept
+        const uint32_t Logged = (Run + 1) * 500;
+        const uint16_t Count = HEARDLOG_Count();
+        CHECK(Count == Logged || (Logged > SLOTS && Count >= SLOTS - PER_SECTOR));
+
+        HeardRecord_t Newest;
+        CHECK_EQ(HEARDLOG_Read(Count - 1, &Newest, 1), 1);
+        CHECK_EQ(Newest.Boot, Boots - 1);
+    }
+
+    // Records still in the page buffer are lost, the rest reads in order
+    Log(20);
+    Boot();
+    const uint32_t Next = Verify();
+    CHECK(Next + 20 >= Seq && Next <= Seq);
+}
+
+// The head sector filled up and power went before the next one got erased:
+// all sectors full, any of them the newest
+static void TestAllFull(void)
+{
+    for (uint32_t Newest = 0; Newest < LOG_SIZE / SECTOR; Newest++)
+    {
+        Start();
+        Log(SLOTS + 100);
+
+        // Up to the page that fills sector Newest, then undo its erase
+        bool Done = false;
+        while (!Done)
+        {
+            memcpy(Snapshot, FakeFlash + LOG_ADDR, LOG_SIZE);
+            const uint32_t Erases = gFakeFlash_Counts.Erases;
+            Log(1);
+            if (Erases != gFakeFlash_Counts.Erases)
+            {
+                const uint32_t Erased = (Newest + 1) % (LOG_SIZE / SECTOR) * SECTOR;
+                if (0xff == FakeFlash[LOG_ADDR + Erased + SECTOR - 1] && 0xff != Snapshot[Erased + SECTOR - 1])
+                {
+                    memcpy(FakeFlash + LOG_ADDR + Erased, Snapshot + Erased, SECTOR);
+                    Done = true;
+                }
+            }
+        }
+
+        // The record that filled the page buffer is lost with the power
+        Boot();
+        Seq--;
+        CHECK_EQ(Verify(), Seq);
+        CHECK_EQ(HEARDLOG_Count(), SLOTS - PER_SECTOR);
+
+        // And the ring goes on from there
+        Log(300);
+        HEARDLOG_Flush();
+        Boot();
+        CHECK_EQ(Verify(), Seq);
+    }
+}
+
+// Power lost in every erase and page program of a run over a lap: the log
+// still reads in order up to some record, and goes on from it
+static void TestTornFlush(void)
+{
+    for (uint32_t Cut = 1;; Cut++)
+    {
+        Start();
+        Log(SLOTS - 300);
+
+        jmp_buf Resume;
+        if (0 == setjmp(Resume))
+        {
+            FakeFlash_CutPowerAt(Cut, &Resume);
+            Log(600);
+            FakeFlash_CutPowerAt(0, NULL);
+            break; // Every operation of the run has been cut once
+        }
+        FakeFlash_CutPowerAt(0, NULL);
+
+        Boot();
+        const uint32_t Next = Verify();
+        if (Next + 16 < 1000 + SLOTS - 300 || Next > Seq)
+        {
+            printf("  cut %u: newest %u, %u logged\n", Cut, Next, Seq);
+            CHECK(false);
+            continue;
+        }
+
+        Seq = Next;
+        Log(300);
+        HEARDLOG_Flush();
+        Boot();
+        CHECK_EQ(Verify(), Seq);
+    }
+}
+
+int main(void)
+{
+    RUN(TestWrap);
+    RUN(TestAllFull);
+    RUN(TestTornFlush);
+    return TEST_RESULT();
+}
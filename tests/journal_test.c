@@ -0,0 +1,189 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// Settings journal (driver/py25q16_journal.c) on the fake flash chip
+
+#include <string.h>
+
+#include "driver/crc.h"
+#include "driver/py25q16.h"
+#include "driver/py25q16_journal.h"
+#include "fake_flash.h"
+#include "test.h"
+
+#define SECTOR_SIZE 0x1000
+#define RECORD_SIZE 16
+#define SETTINGS 0x004000 // Journaled, 16 bytes
+
+static void Boot(void)
+{
+    PY25Q16_Init();
+}
+
+static void Save(uint32_t Value)
+{
+    uint8_t Data[8];
+
+    memcpy(Data, &Value, sizeof(Value));
+    memcpy(Data + 4, &Value, sizeof(Value));
+    PY25Q16_WriteBuffer(SETTINGS, Data, sizeof(Data), false);
+    JOURNAL_FlushAll();
+}
+
+static uint32_t Load(void)
+{
+    uint32_t Value;
+
+    PY25Q16_ReadBuffer(SETTINGS, &Value, sizeof(Value));
+    return Value;
+}
+
+static uint32_t JournalErases(void)
+{
+    uint32_t Erases = 0;
+
+    for (uint32_t i = 0; i < JOURNAL_SECTORS; i++)
+    {
+        Erases += gFakeFlash_SectorErases[JOURNAL_ADDR / SECTOR_SIZE + i];
+    }
+    return Erases;
+}
+
+static uint8_t *NextFreeSlot(void)
+{
+    // Active sector: valid header with the highest sequence number
+    uint8_t *pActive = NULL;
+    uint32_t Seq = 0;
+
+    for (uint32_t i = 0; i < JOURNAL_SECTORS; i++)
+    {
+        uint8_t *p = FakeFlash + JOURNAL_ADDR + i * SECTOR_SIZE;
+        uint32_t Magic;
+        uint32_t s;
+
+        memcpy(&Magic, p, 4);
+        memcpy(&s, p + 4, 4);
+        if (0x4c4e524a == Magic && (NULL == pActive || s > Seq))
+        {
+            pActive = p;
+            Seq = s;
+        }
+    }
+
+    uint8_t *pFree = NULL;
+    for (uint32_t Slot = SECTOR_SIZE / RECORD_SIZE - 1; Slot > 0; Slot--)
+    {
+        uint8_t *p = pActive + Slot * RECORD_SIZE;
+        for (uint32_t i = 0; i < RECORD_SIZE; i++)
+        {
+            if (0xff != p[i])
+            {
+                return pFree;
+            }
+        }
+        pFree = p;
+    }
+    return pFree;
+}
+
+static void TestWear(void)
+{
+    const uint32_t Saves = 2000;
+
+    FakeFlash_Init();
+    Boot();
+    memset(&gFakeFlash_Counts, 0, sizeof(gFakeFlash_Counts));
+    memset(gFakeFlash_SectorErases, 0, sizeof(gFakeFlash_SectorErases));
+
+    for (uint32_t i = 1; i <= Saves; i++)
+    {
+        Save(i);
+    }
+
+    // One page program per save, one erase per sector of records, and
+    // never an erase of the home sector or its bank copy
+    CHECK_EQ(gFakeFlash_Counts.Erases, JournalErases());
+    CHECK(JournalErases() <= Saves / (SECTOR_SIZE / RECORD_SIZE - 2) + 1);
+    CHECK(gFakeFlash_Counts.Programs <= Saves + JournalErases() * 2);
+
+    // Spread evenly over the ring
+    for (uint32_t i = 0; i < JOURNAL_SECTORS; i++)
+    {
+        const uint32_t Erases = gFakeFlash_SectorErases[JOURNAL_ADDR / SECTOR_SIZE + i];
+        CHECK(Erases + 1 >= JournalErases() / JOURNAL_SECTORS);
+        CHECK(Erases <= JournalErases() / JOURNAL_SECTORS + 1);
+    }
+
+    CHECK_EQ(Load(), Saves);
+    Boot();
+    CHECK_EQ(Load(), Saves);
+}
+
+static void TestTornRecord(void)
+{
+    FakeFlash_Init();
+    Boot();
+    Save(1);
+    Save(2);
+
+    // Power lost after Data and Crc were programmed, before Addr
+    uint8_t *pSlot = NextFreeSlot();
+    CHECK(pSlot != NULL);
+    memset(pSlot + 4, 0x5a, 10);
+
+    Boot();
+    CHECK_EQ(Load(), 2);
+
+    Save(3);
+    CHECK_EQ(Load(), 3);
+    Boot();
+    CHECK_EQ(Load(), 3);
+}
+
+static void TestTornHeader(void)
+{
+    FakeFlash_Init();
+    Boot();
+
+    // Fill the active sector, the next save compacts into a new one
+    uint32_t i = 1;
+    while (NextFreeSlot())
+    {
+        Save(i++);
+    }
+    const uint32_t Last = i - 1;
+
+    jmp_buf Resume;
+    if (0 == setjmp(Resume))
+    {
+        // Erase, the live record, then the header: cut the header
+        FakeFlash_CutPowerAt(3, &Resume);
+        Save(i);
+        CHECK(false);
+    }
+    FakeFlash_CutPowerAt(0, NULL);
+
+    Boot();
+    CHECK_EQ(Load(), Last);
+    Save(i);
+    Boot();
+    CHECK_EQ(Load(), i);
+}
+
+int main(void)
+{
+    RUN(TestWear);
+    RUN(TestTornRecord);
+    RUN(TestTornHeader);
+    return TEST_RESULT();
+}
@@ -0,0 +1,162 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// Queued DMA reads (PY25Q16_ReadAsync) on the fake flash chip
+
+#include <string.h>
+
+#include "driver/py25q16.h"
+#include "fake_flash.h"
+#include "fake_hw.h"
+#include "test.h"
+
+#define DATA_ADDR 0x100000
+
+static uint8_t Bufs[5][64];
+static void *Done[8];
+static uint32_t DoneCount;
+
+static void Completed(void *pBuffer, uint32_t Size)
+{
+    Done[DoneCount++ % 8] = pBuffer;
+}
+
+static void Setup(void)
+{
+    FakeFlash_Init();
+    for (uint32_t i = 0; i < 0x1000; i++)
+    {
+        FakeFlash[DATA_ADDR + i] = i * 7 + (i >> 8);
+    }
+    PY25Q16_Init();
+
+    memset(Bufs, 0, sizeof(Bufs));
+    DoneCount = 0;
+}
+
+static void TestOrder(void)
+{
+    Setup();
+
+    // Transfers complete one after the other, in the order queued
+    Fake_HoldIrq(true);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        CHECK(PY25Q16_ReadAsync(DATA_ADDR + i * 0x100, Bufs[i], sizeof(Bufs[i]), Completed));
+    }
+    CHECK(!PY25Q16_ReadAsync(DATA_ADDR, Bufs[4], sizeof(Bufs[4]), Completed)); // Queue full
+    CHECK(PY25Q16_IsBusy());
+    CHECK_EQ(DoneCount, 0);
+
+    Fake_HoldIrq(false);
+    CHECK(!PY25Q16_IsBusy());
+    CHECK_EQ(DoneCount, 4);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        CHECK(Done[i] == Bufs[i]);
+        CHECK(0 == memcmp(Bufs[i], FakeFlash + DATA_ADDR + i * 0x100, sizeof(Bufs[i])));
+    }
+}
+
+static void TestSequential(void)
+{
+    Setup();
+
+    // The second read continues the first one without a new command
+    Fake_HoldIrq(true);
+    CHECK(PY25Q16_ReadAsync(DATA_ADDR, Bufs[0], 32, Completed));
+    CHECK(PY25Q16_ReadAsync(DATA_ADDR + 32, Bufs[1], 32, Completed));
+    Fake_HoldIrq(false);
+
+    CHECK(0 == memcmp(Bufs[0], FakeFlash + DATA_ADDR, 32));
+    CHECK(0 == memcmp(Bufs[1], FakeFlash + DATA_ADDR + 32, 32));
+}
+
+static void TestCsReleased(void)
+{
+    Setup();
+
+    // Back in standby after every read: blocking, DMA sized or queued
+    uint32_t Commands = gFakeFlash_Counts.Commands;
+    PY25Q16_ReadBuffer(DATA_ADDR, Bufs[0], 8);
+    CHECK(!FakeFlash_IsSelected());
+    PY25Q16_ReadBuffer(DATA_ADDR + 8, Bufs[0], 32);
+    CHECK(!FakeFlash_IsSelected());
+    CHECK_EQ(gFakeFlash_Counts.Commands - Commands, 2);
+
+    // Only reads chained in the queue share a command
+    Commands = gFakeFlash_Counts.Commands;
+    Fake_HoldIrq(true);
+    CHECK(PY25Q16_ReadAsync(DATA_ADDR, Bufs[0], 32, NULL));
+    CHECK(PY25Q16_ReadAsync(DATA_ADDR + 32, Bufs[1], 32, NULL));
+    CHECK(PY25Q16_ReadAsync(DATA_ADDR + 0x200, Bufs[2], 32, NULL));
+    CHECK(FakeFlash_IsSelected());
+    Fake_HoldIrq(false);
+    CHECK(!FakeFlash_IsSelected());
+    CHECK_EQ(gFakeFlash_Counts.Commands - Commands, 2);
+    CHECK(0 == memcmp(Bufs[2], FakeFlash + DATA_ADDR + 0x200, 32));
+}
+
+static void TestBlockingAfterAsync(void)
+{
+    Setup();
+
+    // A blocking read waits for the queue, then reads its own data
+    CHECK(PY25Q16_ReadAsync(DATA_ADDR, Bufs[0], 32, NULL));
+    PY25Q16_ReadBuffer(DATA_ADDR + 0x800, Bufs[1], 8);
+    CHECK(0 == memcmp(Bufs[0], FakeFlash + DATA_ADDR, 32));
+    CHECK(0 == memcmp(Bufs[1], FakeFlash + DATA_ADDR + 0x800, 8));
+}
+
+static void TestBanked(void)
+{
+    Setup();
+
+    // Channel names: double-buffered, read from the copy in use
+    uint8_t Name[16];
+    memset(Name, 'A', sizeof(Name));
+    PY25Q16_WriteBuffer(0x00e000, Name, sizeof(Name), false);
+    memset(Name, 'B', sizeof(Name));
+    PY25Q16_WriteBuffer(0x00e000, Name, sizeof(Name), false);
+
+    Fake_HoldIrq(true);
+    CHECK(PY25Q16_ReadAsync(0x00e000, Bufs[0], 16, Completed));
+    CHECK_EQ(DoneCount, 0);
+    Fake_HoldIrq(false);
+    CHECK_EQ(DoneCount, 1);
+    CHECK(0 == memcmp(Bufs[0], Name, 16));
+}
+
+static void TestJournaled(void)
+{
+    Setup();
+
+    // Journaled settings need the overlay: read before ReadAsync returns
+    uint8_t Settings[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    PY25Q16_WriteBuffer(0x004000, Settings, sizeof(Settings), false);
+
+    CHECK(PY25Q16_ReadAsync(0x004000, Bufs[0], 16, Completed));
+    CHECK_EQ(DoneCount, 1);
+    CHECK(0 == memcmp(Bufs[0], Settings, sizeof(Settings)));
+}
+
+int main(void)
+{
+    RUN(TestOrder);
+    RUN(TestSequential);
+    RUN(TestCsReleased);
+    RUN(TestBlockingAfterAsync);
+    RUN(TestBanked);
+    RUN(TestJournaled);
+    return TEST_RESULT();
+}
@@ -0,0 +1,150 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <string.h>
+
+#include "fake_bk4819.h"
+#include "fake_hw.h"
+
+#define PORT_B 1
+#define PORT_F 5
+#define MASK_CSN LL_GPIO_PIN_9 // Port F
+#define MASK_SCL LL_GPIO_PIN_8 // Port B
+#define MASK_SDA LL_GPIO_PIN_9 // Port B
+
+uint16_t gFakeBK4819_Regs[128];
+FakeBK4819_Counts_t gFakeBK4819_Counts;
+FakeBK4819_Write_t gFakeBK4819_Log[FAKE_BK4819_LOG];
+uint32_t gFakeBK4819_LogCount;
+
+static bool Hooked;
+static bool Selected;
+static bool Scl;
+static bool Sda;
+static uint32_t Bits;  // Clocked in or out since CSN fell
+static uint32_t Frame; // Bits in, MSB first
+
+static bool Reading(void)
+{
+    return Bits >= 8 && (Frame >> (Bits - 8)) & 0x80;
+}
+
+static void FrameEnd(void)
+{
+    if (Bits != 24)
+    {
+        gFakeBK4819_Counts.Bad++;
+        return;
+    }
+
+    const uint8_t Register = (Frame >> 16) & 0x7f;
+    if (Reading())
+    {
+        gFakeBK4819_Counts.Reads++;
+        return;
+    }
+
+    gFakeBK4819_Regs[Register] = Frame & 0xffff;
+    gFakeBK4819_Counts.Writes++;
+    if (gFakeBK4819_LogCount < FAKE_BK4819_LOG)
+    {
+        gFakeBK4819_Log[gFakeBK4819_LogCount] = (FakeBK4819_Write_t){Register, Frame & 0xffff};
+    }
+    gFakeBK4819_LogCount++;
+}
+
+static void PinChanged(uint32_t Port, uint32_t Mask, bool Level)
+{
+    if (PORT_F == Port && (Mask & MASK_CSN))
+    {
+        gFakeBK4819_Counts.Pins++;
+        if (Level && Selected)
+        {
+            FrameEnd();
+        }
+        Selected = !Level;
+        Bits = 0;
+        Frame = 0;
+        return;
+    }
+
+    if (PORT_B != Port)
+    {
+        return;
+    }
+
+    if (Mask & MASK_SDA)
+    {
+        gFakeBK4819_Counts.Pins++;
+        Sda = Level;
+    }
+
+    if (Mask & MASK_SCL)
+    {
+        gFakeBK4819_Counts.Pins++;
+        if (Level && !Scl && Selected)
+        {
+            // Data phase of a read: the chip drives SDA, nothing to latch
+            gFakeBK4819_Counts.Clocks++;
+            Frame = (Frame << 1) | (Reading() ? 0 : Sda);
+            Bits++;
+        }
+        Scl = Level;
+    }
+}
+
+// During a read the chip has the next bit of the register out after each
+// falling edge, MSB first
+static bool PinInput(uint32_t Port, uint32_t Mask)
+{
+    if (PORT_B == Port && (Mask & MASK_SDA))
+    {
+        if (Selected && Reading() && Bits < 24)
+        {
+            const uint8_t Register = (Frame >> (Bits - 8)) & 0x7f;
+            return (gFakeBK4819_Regs[Register] >> (23 - Bits)) & 1;
+        }
+        return Sda;
+    }
+    if (PORT_B == Port && (Mask & MASK_SCL))
+    {
+        return Scl;
+    }
+    return PORT_F == Port && (Mask & MASK_CSN) ? !Selected : false;
+}
+
+void FakeBK4819_Reset(void)
+{
+    memset(&gFakeBK4819_Counts, 0, sizeof(gFakeBK4819_Counts));
+    gFakeBK4819_LogCount = 0;
+}
+
+void FakeBK4819_Init(void)
+{
+    memset(gFakeBK4819_Regs, 0, sizeof(gFakeBK4819_Regs));
+    FakeBK4819_Reset();
+    Selected = false;
+    Bits = 0;
+
+    if (!Hooked)
+    {
+        Fake_AddPinHook(PinChanged);
+        Fake_SetPinInput(PinInput);
+        Hooked = true;
+    }
+}
+
+bool FakeBK4819_IsSelected(void)
+{
+    return Selected;
+}
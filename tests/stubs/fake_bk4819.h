@@ -0,0 +1,50 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef TESTS_FAKE_BK4819_H
+#define TESTS_FAKE_BK4819_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FAKE_BK4819_LOG 256
+
+typedef struct
+{
+    uint8_t Register;
+    uint16_t Value;
+} FakeBK4819_Write_t;
+
+typedef struct
+{
+    uint32_t Clocks; // SCL rising edges
+    uint32_t Pins;   // GPIO writes to CSN, SCL and SDA
+    uint32_t Writes; // Frames
+    uint32_t Reads;
+    uint32_t Bad;    // Frames that were not 8 + 16 bits
+} FakeBK4819_Counts_t;
+
+// BK4819 on its 3-wire bus, bit-banged: CSN on PF9, SCL on PB8, SDA on PB9.
+// Decodes what the driver clocks out and answers reads from Regs.
+extern uint16_t gFakeBK4819_Regs[128];
+extern FakeBK4819_Counts_t gFakeBK4819_Counts;
+
+// Every register write, in bus order, up to FAKE_BK4819_LOG of them
+extern FakeBK4819_Write_t gFakeBK4819_Log[FAKE_BK4819_LOG];
+extern uint32_t gFakeBK4819_LogCount;
+
+void FakeBK4819_Init(void);
+void FakeBK4819_Reset(void); // Counts and log only
+bool FakeBK4819_IsSelected(void);
+
+#endif
@@ -0,0 +1,221 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <string.h>
+
+#include "fake_flash.h"
+#include "fake_hw.h"
+
+#define CS_PORT 0 // PA3
+#define CS_MASK LL_GPIO_PIN_3
+#define PAGE_SIZE 0x100
+
+uint8_t FakeFlash[FAKE_FLASH_SIZE];
+FakeFlash_Counts_t gFakeFlash_Counts;
+uint32_t gFakeFlash_SectorErases[FAKE_FLASH_SIZE / FAKE_FLASH_SECTOR];
+
+static bool Selected;
+static bool WriteEnabled;
+static uint8_t Opcode;
+static uint32_t Count; // Bytes since CS went low
+static uint32_t Address;
+static uint8_t Page[PAGE_SIZE];
+static uint32_t PageBytes;
+
+static uint32_t CutAt;
+static jmp_buf *pCutResume;
+
+static bool CutPower(void)
+{
+    return CutAt && 0 == --CutAt;
+}
+
+static void PowerLost(void)
+{
+    Selected = false;
+    WriteEnabled = false;
+    longjmp(*pCutResume, 1);
+}
+
+static void Erase(uint32_t Addr)
+{
+    Addr &= (FAKE_FLASH_SIZE - 1) & ~(FAKE_FLASH_SECTOR - 1);
+    gFakeFlash_Counts.Erases++;
+    gFakeFlash_SectorErases[Addr / FAKE_FLASH_SECTOR]++;
+
+    if (CutPower())
+    {
+        memset(FakeFlash + Addr, 0xff, FAKE_FLASH_SECTOR / 2);
+        PowerLost();
+    }
+    memset(FakeFlash + Addr, 0xff, FAKE_FLASH_SECTOR);
+}
+
+static void Program(void)
+{
+    // Data past the end of the page wraps to its start
+    const uint32_t Base = Address & ~(PAGE_SIZE - 1);
+    const uint32_t Bytes = CutPower() ? PageBytes / 2 : PageBytes;
+
+    gFakeFlash_Counts.Programs++;
+    for (uint32_t i = 0; i < Bytes; i++)
+    {
+        const uint32_t Addr = Base + (Address + i) % PAGE_SIZE;
+        FakeFlash[Addr & (FAKE_FLASH_SIZE - 1)] &= Page[(Address + i) % PAGE_SIZE];
+    }
+
+    if (Bytes != PageBytes)
+    {
+        PowerLost();
+    }
+}
+
+static void Deselect(void)
+{
+    if (!Selected)
+    {
+        return;
+    }
+    Selected = false;
+    gFakeFlash_Counts.Commands++;
+
+    switch (Opcode)
+    {
+    case 0x06:
+        WriteEnabled = true;
+        return;
+    case 0x20:
+        if (WriteEnabled && Count >= 4)
+        {
+            WriteEnabled = false;
+            Erase(Address);
+        }
+        return;
+    case 0x02:
+        if (WriteEnabled && Count >= 4)
+        {
+            WriteEnabled = false;
+            Program();
+        }
+        return;
+    }
+}
+
+static void PinHook(uint32_t Port, uint32_t Mask, bool Level)
+{
+    if (CS_PORT != Port || !(Mask & CS_MASK))
+    {
+        return;
+    }
+
+    if (Level)
+    {
+        Deselect();
+    }
+    else if (!Selected)
+    {
+        Selected = true;
+        Count = 0;
+        Address = 0;
+        PageBytes = 0;
+        memset(Page, 0xff, sizeof(Page));
+    }
+}
+
+static uint8_t Exchange(uint8_t Value)
+{
+    if (!Selected)
+    {
+        return 0xff;
+    }
+
+    const uint32_t i = Count++;
+
+    if (0 == i)
+    {
+        Opcode = Value;
+        return 0xff;
+    }
+
+    switch (Opcode)
+    {
+    case 0x05:
+    case 0x35:
+    case 0x15:
+        return 0x00; // Never busy
+
+    case 0x03:
+    case 0x0b:
+    case 0x02:
+    case 0x20:
+        if (i <= 3)
+        {
+            Address = (Address << 8) | Value;
+            return 0xff;
+        }
+        break;
+
+    default:
+        return 0xff;
+    }
+
+    if (0x03 == Opcode || 0x0b == Opcode)
+    {
+        if (0x0b == Opcode && 4 == i)
+        {
+            return 0xff; // Dummy
+        }
+        return FakeFlash[Address++ & (FAKE_FLASH_SIZE - 1)];
+    }
+
+    if (0x02 == Opcode)
+    {
+        Page[(Address + PageBytes) % PAGE_SIZE] = Value;
+        if (PageBytes < PAGE_SIZE)
+        {
+            PageBytes++;
+        }
+    }
+
+    return 0xff;
+}
+
+void FakeFlash_Init(void)
+{
+    static bool Hooked;
+
+    if (!Hooked)
+    {
+        Fake_AddPinHook(PinHook);
+        Hooked = true;
+    }
+    Fake_SpiExchange = Exchange;
+
+    memset(FakeFlash, 0xff, sizeof(FakeFlash));
+    memset(&gFakeFlash_Counts, 0, sizeof(gFakeFlash_Counts));
+    memset(gFakeFlash_SectorErases, 0, sizeof(gFakeFlash_SectorErases));
+    Selected = false;
+    WriteEnabled = false;
+    CutAt = 0;
+}
+
+bool FakeFlash_IsSelected(void)
+{
+    return Selected;
+}
+
+void FakeFlash_CutPowerAt(uint32_t Operation, jmp_buf *pResume)
+{
+    CutAt = Operation;
+    pCutResume = pResume;
+}
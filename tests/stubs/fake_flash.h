@@ -0,0 +1,45 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef TESTS_FAKE_FLASH_H
+#define TESTS_FAKE_FLASH_H
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FAKE_FLASH_SIZE   0x200000
+#define FAKE_FLASH_SECTOR 0x1000
+
+typedef struct
+{
+    uint32_t Erases;   // Sector erases
+    uint32_t Programs; // Page programs
+    uint32_t Commands; // Any command (CS low .. high)
+} FakeFlash_Counts_t;
+
+// PY25Q16 on SPI2, CS on PA3: reads (0x03, 0x0b), page program, sector
+// erase, write enable and status. Programming only clears bits, like NOR.
+extern uint8_t FakeFlash[FAKE_FLASH_SIZE];
+extern FakeFlash_Counts_t gFakeFlash_Counts;
+extern uint32_t gFakeFlash_SectorErases[FAKE_FLASH_SIZE / FAKE_FLASH_SECTOR];
+
+void FakeFlash_Init(void);
+bool FakeFlash_IsSelected(void);
+
+// Power is lost half way through the Nth erase or page program from now
+// (half the sector erased, half the bytes programmed); the test resumes at
+// the setjmp of pResume. 0 disarms.
+void FakeFlash_CutPowerAt(uint32_t Operation, jmp_buf *pResume);
+
+#endif
@@ -0,0 +1,253 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "fake_hw.h"
+
+#define MAX_HOOKS 4
+#define PORT_COUNT 6
+#define RX_FIFO 8
+
+SPI_TypeDef Fake_SPI2;
+uint32_t Fake_ExtiPending;
+DMA_TypeDef Fake_DMA1;
+
+uint8_t (*Fake_SpiExchange)(uint8_t Value);
+
+static Fake_PinHook_t Hooks[MAX_HOOKS];
+static Fake_PinInput_t Input;
+static uint16_t Levels[PORT_COUNT];
+
+static uint8_t RxFifo[RX_FIFO];
+static uint32_t RxHead;
+static uint32_t RxCount;
+
+typedef struct
+{
+    uint32_t Config;
+    uint32_t Address;
+    uint32_t Length;
+    bool Enabled;
+    bool ItTc;
+} Channel_t;
+
+static Channel_t Channels[8];
+static bool TcFlag;
+
+static bool IrqDisabled;
+static bool IrqHeld;
+static bool InIrq;
+static bool IrqPending;
+
+__attribute__((weak)) void DMA1_Channel4_5_6_7_IRQHandler(void)
+{
+}
+
+static void Deliver(void)
+{
+    while (IrqPending && !IrqDisabled && !IrqHeld && !InIrq)
+    {
+        IrqPending = false;
+        InIrq = true;
+        DMA1_Channel4_5_6_7_IRQHandler();
+        InIrq = false;
+    }
+}
+
+void Fake_DisableIrq(void)
+{
+    IrqDisabled = true;
+}
+
+void Fake_EnableIrq(void)
+{
+    IrqDisabled = false;
+    Deliver();
+}
+
+void Fake_HoldIrq(bool Hold)
+{
+    IrqHeld = Hold;
+    Deliver();
+}
+
+static uint32_t PortIndex(GPIO_TypeDef *pPort)
+{
+    return ((uintptr_t)pPort - IOPORT_BASE) / 0x400;
+}
+
+void Fake_AddPinHook(Fake_PinHook_t Hook)
+{
+    for (uint32_t i = 0; i < MAX_HOOKS; i++)
+    {
+        if (NULL == Hooks[i])
+        {
+            Hooks[i] = Hook;
+            return;
+        }
+    }
+    abort();
+}
+
+void Fake_SetPinInput(Fake_PinInput_t In)
+{
+    Input = In;
+}
+
+void Fake_GpioWrite(GPIO_TypeDef *pPort, uint32_t Mask, bool Level)
+{
+    const uint32_t Port = PortIndex(pPort);
+
+    if (Level)
+        Levels[Port] |= Mask;
+    else
+        Levels[Port] &= ~Mask;
+
+    for (uint32_t i = 0; i < MAX_HOOKS && Hooks[i]; i++)
+    {
+        Hooks[i](Port, Mask, Level);
+    }
+}
+
+bool Fake_GpioRead(GPIO_TypeDef *pPort, uint32_t Mask)
+{
+    const uint32_t Port = PortIndex(pPort);
+
+    if (Input)
+    {
+        return Input(Port, Mask);
+    }
+    return (Levels[Port] & Mask) != 0;
+}
+
+void Fake_GpioMode(GPIO_TypeDef *pPort, uint32_t Mask, uint32_t Mode)
+{
+}
+
+void Fake_SpiTransmit(uint8_t Value)
+{
+    const uint8_t Rx = Fake_SpiExchange ? Fake_SpiExchange(Value) : 0xff;
+
+    if (RxCount == RX_FIFO)
+    {
+        abort(); // Overrun: the driver didn't keep up
+    }
+    RxFifo[(RxHead + RxCount++) % RX_FIFO] = Rx;
+}
+
+uint8_t Fake_SpiReceive(void)
+{
+    if (0 == RxCount)
+    {
+        return 0;
+    }
+
+    const uint8_t Value = RxFifo[RxHead];
+    RxHead = (RxHead + 1) % RX_FIFO;
+    RxCount--;
+    return Value;
+}
+
+uint32_t Fake_SpiRxLevel(void)
+{
+    return RxCount;
+}
+
+// The firmware hands DMA 32-bit addresses. Test binaries are linked at
+// fixed low addresses (no PIE), so only stack buffers need their upper
+// half back, which is that of any local.
+static uint8_t *HostPtr(uint32_t Address)
+{
+    const uintptr_t Stack = (uintptr_t)__builtin_frame_address(0);
+    const uintptr_t OnStack = (Stack & ~(uintptr_t)0xffffffff) | Address;
+
+    if (OnStack - Stack + 0x1000000 < 0x2000000)
+    {
+        return (uint8_t *)OnStack;
+    }
+    return (uint8_t *)(uintptr_t)Address;
+}
+
+void Fake_SpiEnableDmaTx(void)
+{
+    // SPI2 DMA: channel 4 reads, channel 5 writes
+    Channel_t *pRd = Channels + LL_DMA_CHANNEL_4;
+    Channel_t *pWr = Channels + LL_DMA_CHANNEL_5;
+
+    if (!pRd->Enabled || !pWr->Enabled)
+    {
+        return;
+    }
+
+    uint8_t *pIn = HostPtr(pRd->Address);
+    const uint8_t *pOut = HostPtr(pWr->Address);
+
+    for (uint32_t i = 0; i < pWr->Length; i++)
+    {
+        const uint8_t Tx = pOut[(pWr->Config & LL_DMA_MEMORY_INCREMENT) ? i : 0];
+        const uint8_t Rx = Fake_SpiExchange ? Fake_SpiExchange(Tx) : 0xff;
+        pIn[(pRd->Config & LL_DMA_MEMORY_INCREMENT) ? i : 0] = Rx;
+    }
+
+    pRd->Enabled = false;
+    pWr->Enabled = false;
+    TcFlag = true;
+
+    if (pRd->ItTc)
+    {
+        IrqPending = true;
+        Deliver();
+    }
+}
+
+void Fake_DmaConfig(uint32_t Channel, uint32_t Config)
+{
+    Channels[Channel].Config = Config;
+}
+
+void Fake_DmaSetMemory(uint32_t Channel, uint32_t Address)
+{
+    Channels[Channel].Address = Address;
+}
+
+void Fake_DmaSetLength(uint32_t Channel, uint32_t Length)
+{
+    Channels[Channel].Length = Length;
+}
+
+void Fake_DmaEnable(uint32_t Channel, bool Enable)
+{
+    Channels[Channel].Enabled = Enable;
+}
+
+void Fake_DmaEnableIt(uint32_t Channel, bool Enable)
+{
+    Channels[Channel].ItTc = Enable;
+}
+
+uint32_t Fake_DmaIsEnabledIt(uint32_t Channel)
+{
+    return Channels[Channel].ItTc;
+}
+
+uint32_t Fake_DmaIsActiveTc(void)
+{
+    return TcFlag;
+}
+
+void Fake_DmaClearTc(void)
+{
+    TcFlag = false;
+}
@@ -0,0 +1,311 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+/**
+ * -----------------------------------
+ * Host stand-in for the PY32F071 LL drivers
+ *
+ *    Just enough of GPIO, EXTI, SPI and DMA for the App drivers to run
+ *    unchanged on the PC: pin writes go to hooks (see fake_flash.c), SPI
+ *    bytes to Fake_SpiExchange, and a DMA transfer runs as soon as it is
+ *    started, its interrupt delivered like the NVIC would (held off by
+ *    __disable_irq, never nested).
+ * ------------------------------------
+ */
+
+#ifndef TESTS_FAKE_HW_H
+#define TESTS_FAKE_HW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// CMSIS ------
+
+#define __disable_irq() Fake_DisableIrq()
+#define __enable_irq()  Fake_EnableIrq()
+#define __NOP()
+#define __DMB()
+
+#define NVIC_SetPriority(IRQn, Priority)
+#define NVIC_EnableIRQ(IRQn)
+#define NVIC_DisableIRQ(IRQn)
+#define NVIC_ClearPendingIRQ(IRQn)
+
+void Fake_DisableIrq(void);
+void Fake_EnableIrq(void);
+
+// Holds transfer complete interrupts back, as if the transfers were slow
+void Fake_HoldIrq(bool Hold);
+
+// Clocks ------
+
+#define LL_APB1_GRP1_EnableClock(Periph)
+#define LL_AHB1_GRP1_EnableClock(Periph)
+#define LL_IOP_GRP1_EnableClock(Periph)
+#define LL_APB2_GRP1_EnableClock(Periph)
+#define LL_APB1_GRP2_EnableClock(Periph)
+
+// GPIO ------
+
+typedef struct
+{
+    uint32_t Dummy;
+} GPIO_TypeDef;
+
+// As on the chip: GPIO_MAKE_PIN keeps only the offset of the port
+#define IOPORT_BASE 0x50000000UL
+#define GPIOA ((GPIO_TypeDef *)(IOPORT_BASE + 0x0000))
+#define GPIOB ((GPIO_TypeDef *)(IOPORT_BASE + 0x0400))
+#define GPIOC ((GPIO_TypeDef *)(IOPORT_BASE + 0x0800))
+#define GPIOF ((GPIO_TypeDef *)(IOPORT_BASE + 0x1400))
+
+#define LL_GPIO_PIN_0  0x0001
+#define LL_GPIO_PIN_1  0x0002
+#define LL_GPIO_PIN_2  0x0004
+#define LL_GPIO_PIN_3  0x0008
+#define LL_GPIO_PIN_4  0x0010
+#define LL_GPIO_PIN_5  0x0020
+#define LL_GPIO_PIN_6  0x0040
+#define LL_GPIO_PIN_7  0x0080
+#define LL_GPIO_PIN_8  0x0100
+#define LL_GPIO_PIN_9  0x0200
+#define LL_GPIO_PIN_10 0x0400
+#define LL_GPIO_PIN_11 0x0800
+#define LL_GPIO_PIN_12 0x1000
+#define LL_GPIO_PIN_13 0x2000
+#define LL_GPIO_PIN_14 0x4000
+#define LL_GPIO_PIN_15 0x8000
+
+#define LL_GPIO_MODE_INPUT     0
+#define LL_GPIO_MODE_OUTPUT    1
+#define LL_GPIO_MODE_ALTERNATE 2
+#define LL_GPIO_MODE_ANALOG    3
+
+#define LL_GPIO_SPEED_FREQ_VERY_HIGH 3
+#define LL_GPIO_OUTPUT_PUSHPULL      0
+#define LL_GPIO_PULL_NO              0
+#define LL_GPIO_PULL_UP              1
+#define LL_GPIO_AF8_SPI2             8
+#define LL_GPIO_AF9_SPI2             9
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Speed;
+    uint32_t OutputType;
+    uint32_t Pull;
+    uint32_t Alternate;
+} LL_GPIO_InitTypeDef;
+
+// Port: 0 for A, 1 for B, ..
+typedef void (*Fake_PinHook_t)(uint32_t Port, uint32_t Mask, bool Level);
+typedef bool (*Fake_PinInput_t)(uint32_t Port, uint32_t Mask);
+
+void Fake_AddPinHook(Fake_PinHook_t Hook);
+void Fake_SetPinInput(Fake_PinInput_t Input);
+void Fake_GpioWrite(GPIO_TypeDef *pPort, uint32_t Mask, bool Level);
+bool Fake_GpioRead(GPIO_TypeDef *pPort, uint32_t Mask);
+void Fake_GpioMode(GPIO_TypeDef *pPort, uint32_t Mask, uint32_t Mode);
+
+static inline void LL_GPIO_StructInit(LL_GPIO_InitTypeDef *pInit)
+{
+    *pInit = (LL_GPIO_InitTypeDef){0};
+}
+
+static inline void LL_GPIO_Init(GPIO_TypeDef *pPort, const LL_GPIO_InitTypeDef *pInit)
+{
+    Fake_GpioMode(pPort, pInit->Pin, pInit->Mode);
+}
+
+static inline void LL_GPIO_SetPinMode(GPIO_TypeDef *pPort, uint32_t Mask, uint32_t Mode)
+{
+    Fake_GpioMode(pPort, Mask, Mode);
+}
+
+static inline void LL_GPIO_SetPinPull(GPIO_TypeDef *pPort, uint32_t Mask, uint32_t Pull)
+{
+}
+
+static inline void LL_GPIO_SetOutputPin(GPIO_TypeDef *pPort, uint32_t Mask)
+{
+    Fake_GpioWrite(pPort, Mask, true);
+}
+
+static inline void LL_GPIO_ResetOutputPin(GPIO_TypeDef *pPort, uint32_t Mask)
+{
+    Fake_GpioWrite(pPort, Mask, false);
+}
+
+static inline void LL_GPIO_TogglePin(GPIO_TypeDef *pPort, uint32_t Mask)
+{
+    Fake_GpioWrite(pPort, Mask, !Fake_GpioRead(pPort, Mask));
+}
+
+static inline uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef *pPort, uint32_t Mask)
+{
+    return Fake_GpioRead(pPort, Mask);
+}
+
+// EXTI ------
+
+#define ENABLE 1
+
+#define LL_EXTI_LINE_7                 0x0080
+#define LL_EXTI_MODE_IT                0
+#define LL_EXTI_TRIGGER_RISING_FALLING 3
+#define LL_EXTI_CONFIG_PORTB           1
+#define LL_EXTI_CONFIG_LINE7           7
+
+typedef struct
+{
+    uint32_t Line;
+    uint32_t LineCommand;
+    uint8_t Mode;
+    uint8_t Trigger;
+} LL_EXTI_InitTypeDef;
+
+// Pending lines, set by the test before it calls the handler like the NVIC
+extern uint32_t Fake_ExtiPending;
+
+#define LL_EXTI_SetEXTISource(Port, Line)
+#define LL_EXTI_IsActiveFlag(Line) ((Fake_ExtiPending & (Line)) != 0)
+#define LL_EXTI_ClearFlag(Line)    (Fake_ExtiPending &= ~(Line))
+
+static inline void LL_EXTI_Init(const LL_EXTI_InitTypeDef *pInit)
+{
+}
+
+void EXTI4_15_IRQHandler(void);
+
+// SPI ------
+
+typedef struct
+{
+    uint32_t Dummy;
+} SPI_TypeDef;
+
+extern SPI_TypeDef Fake_SPI2;
+#define SPI2 (&Fake_SPI2)
+
+#define LL_SPI_MODE_MASTER            0
+#define LL_SPI_FULL_DUPLEX            0
+#define LL_SPI_PHASE_2EDGE            0
+#define LL_SPI_POLARITY_HIGH          0
+#define LL_SPI_BAUDRATEPRESCALER_DIV2 0
+#define LL_SPI_MSB_FIRST              0
+#define LL_SPI_NSS_SOFT               0
+#define LL_SPI_CRCCALCULATION_DISABLE 0
+#define LL_SPI_TX_FIFO_EMPTY          0
+#define LL_SPI_RX_FIFO_EMPTY          0
+
+typedef struct
+{
+    uint32_t TransferDirection;
+    uint32_t Mode;
+    uint32_t DataWidth;
+    uint32_t ClockPolarity;
+    uint32_t ClockPhase;
+    uint32_t NSS;
+    uint32_t BaudRate;
+    uint32_t BitOrder;
+    uint32_t CRCCalculation;
+    uint32_t CRCPoly;
+} LL_SPI_InitTypeDef;
+
+// Byte clocked out on MOSI, returns the byte on MISO
+extern uint8_t (*Fake_SpiExchange)(uint8_t Value);
+
+void     Fake_SpiTransmit(uint8_t Value);
+uint8_t  Fake_SpiReceive(void);
+uint32_t Fake_SpiRxLevel(void);
+void     Fake_SpiEnableDmaTx(void);
+
+static inline void LL_SPI_StructInit(LL_SPI_InitTypeDef *pInit)
+{
+    *pInit = (LL_SPI_InitTypeDef){0};
+}
+
+#define LL_SPI_Init(pSpi, pInit)       ((void)(pInit))
+#define LL_SPI_Enable(pSpi)
+#define LL_SPI_Disable(pSpi)
+#define LL_SPI_IsActiveFlag_TXE(pSpi)  1
+#define LL_SPI_IsActiveFlag_RXNE(pSpi) (Fake_SpiRxLevel() != 0)
+#define LL_SPI_IsActiveFlag_BSY(pSpi)  0
+#define LL_SPI_GetTxFIFOLevel(pSpi)    LL_SPI_TX_FIFO_EMPTY
+#define LL_SPI_GetRxFIFOLevel(pSpi)    LL_SPI_RX_FIFO_EMPTY
+#define LL_SPI_TransmitData8(pSpi, V)  Fake_SpiTransmit(V)
+#define LL_SPI_ReceiveData8(pSpi)      Fake_SpiReceive()
+#define LL_SPI_DMA_GetRegAddr(pSpi)    0
+#define LL_SPI_EnableDMAReq_RX(pSpi)
+#define LL_SPI_DisableDMAReq_RX(pSpi)
+#define LL_SPI_EnableDMAReq_TX(pSpi)   Fake_SpiEnableDmaTx()
+#define LL_SPI_DisableDMAReq_TX(pSpi)
+
+// DMA ------
+
+typedef struct
+{
+    uint32_t Dummy;
+} DMA_TypeDef;
+
+extern DMA_TypeDef Fake_DMA1;
+#define DMA1 (&Fake_DMA1)
+
+#define LL_DMA_CHANNEL_1 1
+#define LL_DMA_CHANNEL_2 2
+#define LL_DMA_CHANNEL_3 3
+#define LL_DMA_CHANNEL_4 4
+#define LL_DMA_CHANNEL_5 5
+
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY 0x0000
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH 0x0010
+#define LL_DMA_MODE_NORMAL                0x0000
+#define LL_DMA_PERIPH_NOINCREMENT         0x0000
+#define LL_DMA_MEMORY_NOINCREMENT         0x0000
+#define LL_DMA_MEMORY_INCREMENT           0x0080
+#define LL_DMA_PDATAALIGN_BYTE            0x0000
+#define LL_DMA_MDATAALIGN_BYTE            0x0000
+#define LL_DMA_PRIORITY_LOW               0x0000
+#define LL_DMA_PRIORITY_MEDIUM            0x1000
+
+#define LL_SYSCFG_DMA_MAP_SPI2_RD 0
+#define LL_SYSCFG_DMA_MAP_SPI2_WR 0
+#define LL_SYSCFG_SetDMARemap(pDma, Channel, Map)
+
+void     Fake_DmaConfig(uint32_t Channel, uint32_t Config);
+void     Fake_DmaSetMemory(uint32_t Channel, uint32_t Address);
+void     Fake_DmaSetLength(uint32_t Channel, uint32_t Length);
+void     Fake_DmaEnable(uint32_t Channel, bool Enable);
+void     Fake_DmaEnableIt(uint32_t Channel, bool Enable);
+uint32_t Fake_DmaIsEnabledIt(uint32_t Channel);
+uint32_t Fake_DmaIsActiveTc(void);
+void     Fake_DmaClearTc(void);
+
+#define LL_DMA_ConfigTransfer(pDma, Channel, Config)    Fake_DmaConfig(Channel, Config)
+#define LL_DMA_SetMemoryAddress(pDma, Channel, Address) Fake_DmaSetMemory(Channel, Address)
+#define LL_DMA_SetPeriphAddress(pDma, Channel, Address)
+#define LL_DMA_SetDataLength(pDma, Channel, Length)     Fake_DmaSetLength(Channel, Length)
+#define LL_DMA_EnableChannel(pDma, Channel)             Fake_DmaEnable(Channel, true)
+#define LL_DMA_DisableChannel(pDma, Channel)            Fake_DmaEnable(Channel, false)
+#define LL_DMA_EnableIT_TC(pDma, Channel)               Fake_DmaEnableIt(Channel, true)
+#define LL_DMA_DisableIT_TC(pDma, Channel)              Fake_DmaEnableIt(Channel, false)
+#define LL_DMA_IsEnabledIT_TC(pDma, Channel)            Fake_DmaIsEnabledIt(Channel)
+#define LL_DMA_IsActiveFlag_TC4(pDma)                   Fake_DmaIsActiveTc()
+#define LL_DMA_ClearFlag_TC4(pDma)                      Fake_DmaClearTc()
+#define LL_DMA_ClearFlag_GI4(pDma)                      Fake_DmaClearTc()
+
+// Interrupt handler of the SPI flash reads, see driver/py25q16.c
+void DMA1_Channel4_5_6_7_IRQHandler(void);
+
+#endif
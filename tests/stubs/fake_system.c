@@ -0,0 +1,44 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+// Time only moves when the firmware waits
+
+#include "driver/system.h"
+#include "driver/systick.h"
+
+volatile uint32_t gGlobalSysTickCounter;
+
+static uint32_t Now;
+
+void SYSTICK_Init(void)
+{
+}
+
+void SYSTICK_DelayUs(uint32_t Delay)
+{
+    Now += Delay;
+}
+
+uint32_t SYSTICK_GetUs(void)
+{
+    return Now;
+}
+
+void SYSTEM_DelayMs(uint32_t Delay)
+{
+    Now += Delay * 1000;
+}
+
+void SYSTEM_ConfigureClocks(void)
+{
+}
@@ -0,0 +1,2 @@
+// Host build: see fake_hw.h
+#include "fake_hw.h"
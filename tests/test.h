@@ -0,0 +1,55 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef TESTS_TEST_H
+#define TESTS_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int gTestFailures;
+
+#define CHECK(Cond)                                                      \
+    do                                                                   \
+    {                                                                    \
+        if (!(Cond))                                                     \
+        {                                                                \
+            fprintf(stderr, "%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #Cond); \
+            gTestFailures++;                                             \
+        }                                                                \
+    } while (0)
+
+#define CHECK_EQ(A, B)                                                   \
+    do                                                                   \
+    {                                                                    \
+        const long long a_ = (long long)(A);                             \
+        const long long b_ = (long long)(B);                             \
+        if (a_ != b_)                                                    \
+        {                                                                \
+            fprintf(stderr, "%s:%d: %s == %lld, expected %s == %lld\n",  \
+                    __FILE__, __LINE__, #A, a_, #B, b_);                 \
+            gTestFailures++;                                             \
+        }                                                                \
+    } while (0)
+
+#define RUN(Test)                        \
+    do                                   \
+    {                                    \
+        printf("%s\n", #Test);           \
+        fflush(stdout);                  \
+        Test();                          \
+    } while (0)
+
+#define TEST_RESULT() (gTestFailures ? EXIT_FAILURE : EXIT_SUCCESS)
+
+#endif
@@ -0,0 +1,368 @@
+#!/usr/bin/env python3
+
+# Licensed under the MIT License (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at the root of this repository.
+#
+#     Unless required by applicable law or agreed to in writing, software
+#     distributed under the License is distributed on an "AS IS" BASIS,
+#     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#     See the License for the specific language governing permissions and
+#     limitations under the License.
+#
+
+"""
+Panadapter for the spectrum sweep stream (firmware built with
+ENABLE_SPECTRUM_STREAM, see App/app/sweepstream.c for the frame format).
+
+Reads a radio in spectrum mode, or a capture file made with --record.
+"""
+
+import os
+import sys
+import time
+import struct
+import argparse
+from dataclasses import dataclass
+
+# Serial configuration, as k5viewer
+DEFAULT_PORT = "/dev/ttyUSB0"
+BAUDRATE = 38400
+TIMEOUT = 0.05
+
+# Protocol
+HEADER = b"\xAA\x55"
+TYPE_SWEEP = 0x03
+TAIL = 0x0A
+FLAG_9BIT = 0x01
+FLAG_DELTA = 0x02
+REQUEST_EVERY = 0.5  # s, the radio stops 2 s after the last request
+
+# Matches SweepHeader_t in App/app/sweepstream.h
+_SWEEP_HEADER = struct.Struct("<IIHBBb3x")
+
+WATERFALL_ROWS = 120
+
+
+def make_request(mode: int) -> bytes:
+    return bytes((ord("S"), ord("W"), mode, mode ^ 0xFF))
+
+
+@dataclass
+class Sweep:
+    start: int  # Hz
+    step: int  # Hz
+    seq: int
+    flags: int
+    dbm_corr: int
+    readings: list  # 9 bit scale, 0 = no reading
+
+    def freq(self, i: int) -> int:
+        return self.start + i * self.step
+
+    def dbm(self, i: int) -> float | None:
+        r = self.readings[i]
+        return r / 2 - 160 + self.dbm_corr if r else None
+
+
+def _unpack_key(data: bytes, count: int, bits: int) -> list:
+    values = []
+    acc = held = pos = 0
+    mask = (1 << bits) - 1
+    for _ in range(count):
+        while held < bits:
+            acc |= data[pos] << held
+            pos += 1
+            held += 8
+        values.append(acc & mask)
+        acc >>= bits
+        held -= bits
+    return values
+
+
+def _unpack_delta(data: bytes, prev: list, bits: int) -> list:
+    nibbles = (n for b in data for n in (b & 15, b >> 4))
+    values = []
+    for p in prev:
+        n = next(nibbles)
+        if n == 15:
+            v = 0
+            for shift in range(0, bits, 4):
+                v |= next(nibbles) << shift
+            values.append(v)
+        else:
+            values.append(p - (n + 1) // 2 if n & 1 else p + n // 2)
+    return values
+
+
+class SweepDecoder:
+    """Picks sweep frames out of a byte stream, other frames are skipped."""
+
+    def __init__(self):
+        self._buf = bytearray()
+        self._prev = None  # (header tuple, values at the sent resolution)
+        self.dropped = 0
+
+    def feed(self, data: bytes) -> list[Sweep]:
+        self._buf.extend(data)
+        sweeps = []
+        while True:
+            at = self._buf.find(HEADER)
+            if at < 0:
+                del self._buf[:-1]
+                return sweeps
+            del self._buf[:at]
+            if len(self._buf) < 5:
+                return sweeps
+            size = int.from_bytes(self._buf[3:5], "big")
+            if len(self._buf) < 5 + size + 1:
+                return sweeps
+            kind = self._buf[2]
+            payload = bytes(self._buf[5 : 5 + size])
+            tail = self._buf[5 + size]
+            if tail != TAIL:
+                del self._buf[:2]  # false header, resync
+                continue
+            del self._buf[: 5 + size + 1]
+            if kind == TYPE_SWEEP and size >= _SWEEP_HEADER.size:
+                sweep = self._decode(payload)
+                if sweep:
+                    sweeps.append(sweep)
+
+    def _decode(self, payload: bytes) -> Sweep | None:
+        start, step, count, flags, seq, corr = _SWEEP_HEADER.unpack_from(payload)
+        data = payload[_SWEEP_HEADER.size :]
+        bits = 9 if flags & FLAG_9BIT else 8
+
+        if flags & FLAG_DELTA:
+            prev = self._prev
+            if not prev or prev[0] != (start, step, count, flags & FLAG_9BIT) or (prev[1] + 1) & 0xFF != seq:
+                self.dropped += 1
+                return None
+            values = _unpack_delta(data, prev[2], bits)
+        else:
+            values = _unpack_key(data, count, bits)
+
+        self._prev = ((start, step, count, flags & FLAG_9BIT), seq, values)
+        readings = values if bits == 9 else [v << 1 for v in values]
+        return Sweep(start * 10, step * 10, seq, flags, corr, readings)
+
+
+class SweepEncoder:
+    """The radio side, readings on the 9 bit scale; for --synth."""
+
+    KEY_INTERVAL = 16
+
+    def __init__(self, bits: int = 9, delta: bool = True):
+        self._bits = bits
+        self._delta = delta
+        self._prev = None  # (start, step, values)
+        self._since_key = 0
+        self._seq = 0
+
+    def _key(self, values: list) -> bytes:
+        acc = held = 0
+        data = bytearray()
+        for v in values:
+            acc |= v << held
+            held += self._bits
+            while held >= 8:
+                data.append(acc & 0xFF)
+                acc >>= 8
+                held -= 8
+        if held:
+            data.append(acc)
+        return bytes(data)
+
+    def _delta_data(self, values: list, prev: list) -> bytes:
+        nibbles = []
+        for v, p in zip(values, prev):
+            d = v - p
+            if -7 <= d <= 7:
+                nibbles.append(-2 * d - 1 if d < 0 else 2 * d)
+            else:
+                nibbles.append(15)
+                nibbles += [(v >> shift) & 15 for shift in range(0, self._bits, 4)]
+        if len(nibbles) & 1:
+            nibbles.append(0)
+        return bytes(nibbles[i] | nibbles[i + 1] << 4 for i in range(0, len(nibbles), 2))
+
+    def encode(self, start: int, step: int, readings: list, corr: int = 0) -> bytes:
+        values = [r >> (9 - self._bits) for r in readings]
+        data = self._key(values)
+        flags = FLAG_9BIT if self._bits == 9 else 0
+        prev = self._prev
+        if self._delta and prev and prev[:2] == (start, step) and self._since_key < self.KEY_INTERVAL - 1:
+            delta = self._delta_data(values, prev[2])
+            if len(delta) < len(data):
+                data = delta
+                flags |= FLAG_DELTA
+        self._since_key = self._since_key + 1 if flags & FLAG_DELTA else 0
+        self._prev = (start, step, values)
+        self._seq = (self._seq + 1) & 0xFF
+
+        payload = _SWEEP_HEADER.pack(start // 10, step // 10, len(values), flags, self._seq, corr) + data
+        return HEADER + bytes((TYPE_SWEEP,)) + len(payload).to_bytes(2, "big") + payload + bytes((TAIL,))
+
+
+def synth_capture(path: str, sweeps: int):
+    import math
+    import random
+
+    encoder = SweepEncoder()
+    with open(path, "wb") as fd:
+        for s in range(sweeps):
+            readings = []
+            for i in range(128):
+                noise = 2 * (-120 + 160) + random.randint(-4, 4)
+                carrier = 80 * math.exp(-(((i - 40 - 20 * math.sin(s / 20)) / 2) ** 2))
+                burst = 60 if 90 <= i <= 93 and s % 30 < 10 else 0
+                readings.append(min(511, int(noise + carrier + burst)))
+            fd.write(encoder.encode(433_000_000, 12_500, readings))
+    print(f"{sweeps} sweeps written to {path}")
+
+
+class Source:
+    def __init__(self, args: argparse.Namespace):
+        self._ser = None
+        self._fd = None
+        self._record = open(args.record, "wb") if args.record else None
+        self._mode = (FLAG_9BIT if args.bits == 9 else 0) | (0 if args.no_delta else FLAG_DELTA)
+        self._requested = 0.0
+        self._rate = args.rate
+
+        if args.replay:
+            self._fd = open(args.replay, "rb")
+        else:
+            import serial
+
+            self._ser = serial.Serial(args.port or DEFAULT_PORT, BAUDRATE, timeout=TIMEOUT)
+
+    def read(self) -> bytes | None:
+        if self._fd:
+            time.sleep(1 / self._rate)
+            data = self._fd.read(200)
+            return data or None
+
+        now = time.monotonic()
+        if now - self._requested >= REQUEST_EVERY:
+            self._ser.write(make_request(self._mode))
+            self._requested = now
+        data = self._ser.read(512)
+        if self._record and data:
+            self._record.write(data)
+        return data
+
+    def close(self):
+        for f in (self._ser, self._fd, self._record):
+            if f:
+                f.close()
+
+
+def run_text(source: Source, decoder: SweepDecoder):
+    while (data := source.read()) is not None:
+        for sw in decoder.feed(data):
+            best = max(range(len(sw.readings)), key=lambda i: sw.readings[i])
+            dbm = sw.dbm(best)
+            kind = "delta" if sw.flags & FLAG_DELTA else "key  "
+            peak = f"{dbm:7.1f} dBm" if dbm is not None else "    -"
+            print(f"#{sw.seq:3d} {kind} {sw.start / 1e6:11.5f} MHz +{len(sw.readings)}x{sw.step / 1e3:g} kHz"
+                  f"  peak {sw.freq(best) / 1e6:11.5f} MHz {peak}")
+
+
+def run_plot(source: Source, decoder: SweepDecoder, db_min: int, db_max: int):
+    os.environ["PYGAME_HIDE_SUPPORT_PROMPT"] = "hide"
+    import pygame
+
+    width, trace_h = 768, 240
+    screen = pygame.display.set_mode((width, trace_h + WATERFALL_ROWS * 2))
+    pygame.display.set_caption("K5 panadapter – No data")
+    font = pygame.font.Font(None, 20)
+    waterfall = pygame.Surface((width, WATERFALL_ROWS))
+    last = None
+    count = 0
+    last_time = time.monotonic()
+
+    def level(dbm):
+        return min(1.0, max(0.0, (dbm - db_min) / (db_max - db_min)))
+
+    while True:
+        for event in pygame.event.get():
+            if event.type == pygame.QUIT or (event.type == pygame.KEYDOWN and event.key == pygame.K_q):
+                return
+
+        data = source.read()
+        if data is None:
+            pygame.time.wait(100)
+            continue
+
+        for sw in decoder.feed(data):
+            last = sw
+            count += 1
+            n = len(sw.readings)
+            waterfall.scroll(0, 1)
+            for x in range(width):
+                dbm = sw.dbm(x * n // width)
+                v = int(255 * level(dbm)) if dbm is not None else 0
+                waterfall.set_at((x, 0), (v, v // 2, 255 - v if v else 0))
+
+        if last is None:
+            continue
+
+        screen.fill((0, 0, 0))
+        n = len(last.readings)
+        points = []
+        for i in range(n):
+            dbm = last.dbm(i)
+            y = trace_h - 1 - int((trace_h - 20) * level(dbm)) if dbm is not None else trace_h - 1
+            points += [(i * width // n, y), ((i + 1) * width // n - 1, y)]
+        pygame.draw.lines(screen, (255, 255, 0), False, points)
+        screen.blit(pygame.transform.scale(waterfall, (width, WATERFALL_ROWS * 2)), (0, trace_h))
+        label = f"{last.start / 1e6:.5f} MHz  +{n} x {last.step / 1e3:g} kHz  {db_min}..{db_max} dBm"
+        screen.blit(font.render(label, True, (200, 200, 200)), (4, 2))
+        pygame.display.flip()
+
+        now = time.monotonic()
+        if now - last_time >= 1.0:
+            pygame.display.set_caption(f"K5 panadapter – {count / (now - last_time):.1f} sweeps/s, {decoder.dropped} lost")
+            count = 0
+            last_time = now
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Panadapter for the UV-K5 spectrum sweep stream")
+    parser.add_argument("--port", type=str, help=f"serial port (default {DEFAULT_PORT})")
+    parser.add_argument("--replay", type=str, metavar="FILE", help="read a capture instead of a radio")
+    parser.add_argument("--record", type=str, metavar="FILE", help="save what the radio sends")
+    parser.add_argument("--rate", type=float, default=50, help="replay reads per second")
+    parser.add_argument("--bits", type=int, choices=(8, 9), default=9, help="reading resolution to ask for")
+    parser.add_argument("--no-delta", action="store_true", help="ask for key frames only")
+    parser.add_argument("--text", action="store_true", help="print a line per sweep, no window")
+    parser.add_argument("--db", type=int, nargs=2, default=(-130, -50), metavar=("MIN", "MAX"))
+    parser.add_argument("--synth", type=str, metavar="FILE", help="write a synthetic capture and exit")
+    args = parser.parse_args()
+
+    if args.synth:
+        synth_capture(args.synth, 300)
+        return
+
+    try:
+        source = Source(args)
+    except Exception as e:
+        print(f"[!] {e}")
+        sys.exit(1)
+
+    decoder = SweepDecoder()
+    try:
+        if args.text:
+            run_text(source, decoder)
+        else:
+            run_plot(source, decoder, *args.db)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        source.close()
+
+
+if __name__ == "__main__":
+    main()
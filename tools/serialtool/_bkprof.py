@@ -0,0 +1,155 @@
+# Licensed under the MIT License (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at the root of this repository.
+#
+#     Unless required by applicable law or agreed to in writing, software
+#     distributed under the License is distributed on an "AS IS" BASIS,
+#     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#     See the License for the specific language governing permissions and
+#     limitations under the License.
+#
+
+"""
+BK4819 bus profile (firmware built with ENABLE_BK4819_PROFILE)
+"""
+
+from serial import Serial
+import struct
+from time import monotonic
+import msg as mm
+
+MSG_READ_BK4819_PROFILE = 0x0603
+
+# Matches BK4819_Profile_t in App/driver/bk4819_profile.h
+CALLERS = ("other", "scan", "spectrum", "am fix", "irq", "ui")
+_PROFILE = struct.Struct(f"<128H128H{len(CALLERS)}I{len(CALLERS)}IHBB")
+
+_PAGE = 128
+
+
+def report(raw: bytes, top: int = 16):
+    """Print the report for a raw profile, live or from a saved dump"""
+
+    if len(raw) != _PROFILE.size:
+        print(f"Profile is {len(raw)} bytes, expected {_PROFILE.size}")
+        return
+
+    v = _PROFILE.unpack(raw)
+    n = len(CALLERS)
+    reads = v[0:128]
+    writes = v[128:256]
+    bus_us = v[256 : 256 + n]
+    calls = v[256 + n : 256 + 2 * n]
+    worst_us, worst_reg, worst_caller = v[256 + 2 * n :]
+
+    total_us = sum(bus_us)
+    print("caller      bus(ms)  share    calls  avg(us)")
+    for i, name in enumerate(CALLERS):
+        if not calls[i]:
+            continue
+        print(
+            "{:<10} {:8.1f} {:5.1f}% {:8d} {:8.1f}".format(
+                name,
+                bus_us[i] / 1000,
+                100 * bus_us[i] / total_us if total_us else 0,
+                calls[i],
+                bus_us[i] / calls[i],
+            )
+        )
+    print("{:<10} {:8.1f}        {:8d}".format("total", total_us / 1000, sum(calls)))
+
+    if worst_us:
+        kind = "read" if worst_reg & 0x80 else "write"
+        caller = CALLERS[worst_caller] if worst_caller < n else f"#{worst_caller}"
+        print(f"worst call: {worst_us} us, {kind} REG_{worst_reg & 0x7F:02X}, {caller}")
+
+    busiest = sorted(range(128), key=lambda r: reads[r] + writes[r], reverse=True)
+    print("register    reads   writes")
+    for r in busiest[:top]:
+        if not reads[r] + writes[r]:
+            break
+        sat = "+" if 0xFFFF in (reads[r], writes[r]) else ""
+        print(f"REG_{r:02X}   {reads[r]:8d} {writes[r]:8d}{sat}")
+
+
+class BK4819Profile:
+
+    def __init__(self, ser: Serial, out_file: str | None, reset: bool):
+        self._ser = ser
+        self._out_file = out_file
+        self._reset = reset
+        self._rx_buf = bytearray(256)
+        self._msg_buf = bytearray()
+        self._offset = 0
+        self._expect_resp = False
+        self._sent_at = 0.0
+        self.raw = bytearray()
+
+    def loop(self) -> bool:
+
+        if not self._expect_resp:
+            self._send_request()
+            self._expect_resp = True
+            self._sent_at = monotonic()
+            return True
+
+        msg = self._recv_msg()
+        if not msg:
+            if monotonic() - self._sent_at > 1.0:
+                print("No response. Retry..")
+                self._expect_resp = False
+            return True
+
+        if MSG_READ_BK4819_PROFILE != msg.get_msg_type():
+            return True
+
+        offset = msg.get_hw_LE(4)
+        total = msg.get_hw_LE(6)
+
+        if offset != self._offset:
+            print("Invalid response. Retry..")
+            self._expect_resp = False
+            return True
+
+        count = min(_PAGE, total - offset)
+        self.raw.extend(msg.buf[8 : 8 + count])
+        self._offset += count
+        self._expect_resp = False
+
+        if count and self._offset < total:
+            return True
+
+        # Finished ------
+
+        self._done()
+        return False
+
+    def _done(self):
+
+        if self._out_file:
+            with open(self._out_file, "wb") as fd:
+                fd.write(self.raw)
+            print("Profile saved to " + self._out_file)
+
+        report(self.raw)
+
+    def _last_page(self) -> bool:
+        return self._offset + _PAGE >= _PROFILE.size
+
+    def _send_request(self):
+        msg = mm.Msg(8)
+        msg.set_msg_type(MSG_READ_BK4819_PROFILE)
+        msg.set_hw_LE(4, self._offset)
+        msg.buf[6] = 1 if self._reset and self._last_page() else 0
+        pack = mm.make_packet(msg.buf)
+        self._ser.write(pack)
+        self._ser.flush()
+
+    def _recv_msg(self) -> mm.Msg:
+        while True:
+            len1 = self._ser.readinto(self._rx_buf)
+            if len1 > 0:
+                self._msg_buf.extend(memoryview(self._rx_buf)[:len1])
+            if len1 < len(self._rx_buf):
+                break
+        return mm.fetch(self._msg_buf)
@@ -0,0 +1,195 @@
+# Licensed under the MIT License (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at the root of this repository.
+#
+#     Unless required by applicable law or agreed to in writing, software
+#     distributed under the License is distributed on an "AS IS" BASIS,
+#     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#     See the License for the specific language governing permissions and
+#     limitations under the License.
+#
+
+"""
+Heard log export (firmware built with ENABLE_HEARD_LOG)
+"""
+
+from serial import Serial
+import struct
+from time import monotonic
+import msg as mm
+
+MSG_READ_HEARD_LOG = 0x0620
+
+# Matches HeardRecord_t in App/heardlog.h
+_RECORD = struct.Struct("<IIHHBBBB")
+
+_CTCSS = (
+    670, 693, 719, 744, 770, 797, 825, 854, 885, 915,
+    948, 974, 1000, 1035, 1072, 1109, 1148, 1188, 1230, 1273,
+    1318, 1365, 1413, 1462, 1514, 1567, 1598, 1622, 1655, 1679,
+    1713, 1738, 1773, 1799, 1835, 1862, 1899, 1928, 1966, 1995,
+    2035, 2065, 2107, 2181, 2257, 2291, 2336, 2418, 2503, 2541,
+)  # fmt: skip
+
+_DCS = (
+    0o023, 0o025, 0o026, 0o031, 0o032, 0o036, 0o043, 0o047,
+    0o051, 0o053, 0o054, 0o065, 0o071, 0o072, 0o073, 0o074,
+    0o114, 0o115, 0o116, 0o122, 0o125, 0o131, 0o132, 0o134,
+    0o143, 0o145, 0o152, 0o155, 0o156, 0o162, 0o165, 0o172,
+    0o174, 0o205, 0o212, 0o223, 0o225, 0o226, 0o243, 0o244,
+    0o245, 0o246, 0o251, 0o252, 0o255, 0o261, 0o263, 0o265,
+    0o266, 0o271, 0o274, 0o306, 0o311, 0o315, 0o325, 0o331,
+    0o332, 0o343, 0o346, 0o351, 0o356, 0o364, 0o365, 0o371,
+    0o411, 0o412, 0o413, 0o423, 0o431, 0o432, 0o445, 0o446,
+    0o452, 0o454, 0o455, 0o462, 0o464, 0o465, 0o466, 0o503,
+    0o506, 0o516, 0o523, 0o526, 0o532, 0o546, 0o565, 0o606,
+    0o612, 0o624, 0o627, 0o631, 0o632, 0o654, 0o662, 0o664,
+    0o703, 0o712, 0o723, 0o731, 0o732, 0o734, 0o743, 0o754,
+)  # fmt: skip
+
+MR_CHANNEL_LAST = 199
+FREQ_CHANNEL_LAST = 206
+
+
+class HeardRecord:
+
+    def __init__(self, buf: bytes, off: int):
+        (
+            self.time,
+            self.freq,
+            self.duration,
+            self.rssi,
+            self.channel,
+            self.flags,
+            self.code,
+            self.boot,
+        ) = _RECORD.unpack_from(buf, off)
+
+    def rssi_dBm(self) -> int:
+        return self.rssi // 2 - 160
+
+    def channel_str(self) -> str:
+        ch = self.channel
+        if ch <= MR_CHANNEL_LAST:
+            zone = self.flags >> 4
+            return f"M{zone * (MR_CHANNEL_LAST + 1) + ch + 1}"
+        if ch <= FREQ_CHANNEL_LAST:
+            return "VFO"
+        return f"#{ch}"
+
+    def code_str(self) -> str:
+        code_type = self.flags & 0x0F
+        try:
+            if 1 == code_type:
+                return f"{_CTCSS[self.code] / 10:.1f}"
+            if 2 == code_type:
+                return f"D{_DCS[self.code]:03o}N"
+            if 3 == code_type:
+                return f"D{_DCS[self.code]:03o}I"
+        except IndexError:
+            return "?"
+        return ""
+
+    def __str__(self) -> str:
+        return "{:4d} {:10.2f} {:10.5f} {:>7.2f} {:>7} {:>4} {:>6}".format(
+            self.boot,
+            self.time / 100,
+            self.freq / 100000,
+            self.duration / 100,
+            self.channel_str(),
+            self.rssi_dBm(),
+            self.code_str(),
+        )
+
+
+class HeardLog:
+
+    def __init__(self, ser: Serial, out_file: str | None):
+        self._ser = ser
+        self._out_file = out_file
+        self._rx_buf = bytearray(256)
+        self._msg_buf = bytearray()
+        self._index = 0
+        self._total = None
+        self._expect_resp = False
+        self._sent_at = 0.0
+        self.records: list[HeardRecord] = []
+
+    def loop(self) -> bool:
+
+        if not self._expect_resp:
+            self._send_request()
+            self._expect_resp = True
+            self._sent_at = monotonic()
+            return True
+
+        msg = self._recv_msg()
+        if not msg:
+            if monotonic() - self._sent_at > 1.0:
+                print("No response. Retry..")
+                self._expect_resp = False
+            return True
+
+        if MSG_READ_HEARD_LOG != msg.get_msg_type():
+            return True
+
+        index = msg.get_hw_LE(4)
+        total = msg.get_hw_LE(6)
+        count = msg.buf[8]
+
+        if index != self._index:
+            print("Invalid response. Retry..")
+            self._expect_resp = False
+            return True
+
+        self._total = total
+        for i in range(count):
+            self.records.append(HeardRecord(msg.buf, 12 + i * _RECORD.size))
+
+        self._index += count
+        self._expect_resp = False
+
+        if total:
+            print(f"Fetching heard log.. {self._index * 100 // total}%")
+
+        if count and self._index < total:
+            return True
+
+        # Finished ------
+
+        self._done()
+        return False
+
+    def _done(self):
+
+        print(f"{len(self.records)} records")
+        print("boot    time(s)  freq(MHz) length(s) channel dBm   code")
+        for r in self.records:
+            print(r)
+
+        if self._out_file:
+            with open(self._out_file, "w") as fd:
+                fd.write("boot,time_s,freq_hz,duration_s,channel,rssi_dbm,code\n")
+                for r in self.records:
+                    fd.write(
+                        f"{r.boot},{r.time / 100:.2f},{r.freq * 10},{r.duration / 100:.2f},"
+                        f"{r.channel_str()},{r.rssi_dBm()},{r.code_str()}\n"
+                    )
+            print("Heard log saved to " + self._out_file)
+
+    def _send_request(self):
+        msg = mm.Msg(8)
+        msg.set_msg_type(MSG_READ_HEARD_LOG)
+        msg.set_hw_LE(4, self._index)
+        pack = mm.make_packet(msg.buf)
+        self._ser.write(pack)
+        self._ser.flush()
+
+    def _recv_msg(self) -> mm.Msg:
+        while True:
+            len1 = self._ser.readinto(self._rx_buf)
+            if len1 > 0:
+                self._msg_buf.extend(memoryview(self._rx_buf)[:len1])
+            if len1 < len(self._rx_buf):
+                break
+        return mm.fetch(self._msg_buf)
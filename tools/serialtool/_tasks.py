@@ -0,0 +1,93 @@
+# Licensed under the MIT License (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at the root of this repository.
+#
+#     Unless required by applicable law or agreed to in writing, software
+#     distributed under the License is distributed on an "AS IS" BASIS,
+#     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#     See the License for the specific language governing permissions and
+#     limitations under the License.
+#
+
+"""
+Cooperative task time (firmware built with ENABLE_BACKGROUND_TASKS)
+"""
+
+from serial import Serial
+import struct
+from time import monotonic
+import msg as mm
+
+MSG_READ_TASK_STATS = 0x0604
+
+# Matches TASK_Stats_t in App/task.h
+TASKS = ("app", "commands", "journal", "battery")
+_STATS = struct.Struct(f"<{len(TASKS)}H{len(TASKS)}H{len(TASKS)}II")
+
+
+def report(raw: bytes):
+
+    if len(raw) < _STATS.size:
+        print(f"Stats are {len(raw)} bytes, expected {_STATS.size}")
+        return
+
+    v = _STATS.unpack_from(raw)
+    n = len(TASKS)
+    slice_us = v[0:n]
+    peak_us = v[n : 2 * n]
+    runs = v[2 * n : 3 * n]
+    max_gap_us = v[3 * n]
+
+    print("task       slice(us) peak(us)      runs")
+    for i, name in enumerate(TASKS):
+        print(f"{name:<10} {slice_us[i]:9d} {peak_us[i]:8d} {runs[i]:9d}")
+    print(f"longest wait of the services: {max_gap_us / 1000:.1f} ms")
+
+
+class TaskStats:
+
+    def __init__(self, ser: Serial, reset: bool):
+        self._ser = ser
+        self._reset = reset
+        self._rx_buf = bytearray(256)
+        self._msg_buf = bytearray()
+        self._expect_resp = False
+        self._sent_at = 0.0
+
+    def loop(self) -> bool:
+
+        if not self._expect_resp:
+            self._send_request()
+            self._expect_resp = True
+            self._sent_at = monotonic()
+            return True
+
+        msg = self._recv_msg()
+        if not msg:
+            if monotonic() - self._sent_at > 1.0:
+                print("No response. Retry..")
+                self._expect_resp = False
+            return True
+
+        if MSG_READ_TASK_STATS != msg.get_msg_type():
+            return True
+
+        report(bytes(msg.buf[4:]))
+        return False
+
+    def _send_request(self):
+        msg = mm.Msg(8)
+        msg.set_msg_type(MSG_READ_TASK_STATS)
+        msg.buf[4] = 1 if self._reset else 0
+        pack = mm.make_packet(msg.buf)
+        self._ser.write(pack)
+        self._ser.flush()
+
+    def _recv_msg(self) -> mm.Msg:
+        while True:
+            len1 = self._ser.readinto(self._rx_buf)
+            if len1 > 0:
+                self._msg_buf.extend(memoryview(self._rx_buf)[:len1])
+            if len1 < len(self._rx_buf):
+                break
+        return mm.fetch(self._msg_buf)
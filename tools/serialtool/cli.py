@@ -25,6 +25,9 @@ import os
 import _prog as pp
 import _dump as dd
 import _restore as rr
+import _heard as hh
+import _bkprof as bp
+import _tasks as tt
 
 
 def load_image(file: str) -> bytes:
@@ -105,6 +108,71 @@ def main_restore(args, ser: serial.Serial):
         sleep(0)
 
 
+def main_heard(args, ser: serial.Serial):
+
+    out_file: str | None = args.file
+
+    if out_file:
+        print("Output file: {}".format(out_file))
+        if os.path.exists(out_file):
+            print("Output file exists. Will be overwritten")
+
+    print("Read heard log..")
+
+    quit_flag = False
+
+    def quit_handler(sig, frame):
+        nonlocal quit_flag
+        quit_flag = True
+
+    signal.signal(signal.SIGINT, quit_handler)
+
+    log = hh.HeardLog(ser, out_file)
+    while (not quit_flag) and log.loop():
+        sleep(0)
+
+
+def main_bkprof(args, ser: serial.Serial):
+
+    out_file: str | None = args.file
+
+    if out_file:
+        print("Output file: {}".format(out_file))
+        if os.path.exists(out_file):
+            print("Output file exists. Will be overwritten")
+
+    print("Read BK4819 bus profile..")
+
+    quit_flag = False
+
+    def quit_handler(sig, frame):
+        nonlocal quit_flag
+        quit_flag = True
+
+    signal.signal(signal.SIGINT, quit_handler)
+
+    prof = bp.BK4819Profile(ser, out_file, args.reset)
+    while (not quit_flag) and prof.loop():
+        sleep(0)
+
+
+def main_tasks(args, ser: serial.Serial):
+
+    print("Read task stats..")
+
+    quit_flag = False
+
+    def quit_handler(sig, frame):
+        nonlocal quit_flag
+        quit_flag = True
+
+    signal.signal(signal.SIGINT, quit_handler)
+
+    stats = tt.TaskStats(ser, args.reset)
+    while (not quit_flag) and stats.loop():
+        sleep(0)
+
+
 def main_flash(args, ser: serial.Serial):
 
     bl_ver: str = args.bl_ver
@@ -146,6 +214,10 @@ def main():
     # serialtool.py .. flash [--bl-ver <ver>] <file>
     # serialtool.py .. dump {--config | --calib [| --all]} file
     # serialtool.py .. restore {--config | --calib [| --all]} file
+    # serialtool.py .. heard [file]
+    # serialtool.py .. bkprof [--reset] [file]
+    # serialtool.py bkprof --replay file
+    # serialtool.py .. tasks [--reset]
     ap = argparse.ArgumentParser(description="UV-K5 V2 serial tool")
 
     # TODO: have to add option to each of subcommands ??
@@ -198,6 +270,34 @@ def main():
     )
     ap_restore.add_argument("file", help="input dump file")
 
+    ap_heard = sp.add_parser("heard", help="read the heard log (ENABLE_HEARD_LOG)")
+    ap_heard.add_argument(
+        "--port", "-p", help="serial port, eg., '/dev/ttyUSB0'", required=True
+    )
+    ap_heard.add_argument("file", nargs="?", help="optional output CSV file")
+
+    ap_bkprof = sp.add_parser(
+        "bkprof", help="read the BK4819 bus profile (ENABLE_BK4819_PROFILE)"
+    )
+    ap_bkprof.add_argument("--port", "-p", help="serial port, eg., '/dev/ttyUSB0'")
+    ap_bkprof.add_argument(
+        "--reset", action="store_true", help="clear the profile once read"
+    )
+    ap_bkprof.add_argument(
+        "--replay", action="store_true", help="print the report of a saved profile"
+    )
+    ap_bkprof.add_argument("file", nargs="?", help="optional raw profile file")
+
+    ap_tasks = sp.add_parser(
+        "tasks", help="read the cooperative task time (ENABLE_BACKGROUND_TASKS)"
+    )
+    ap_tasks.add_argument(
+        "--port", "-p", help="serial port, eg., '/dev/ttyUSB0'", required=True
+    )
+    ap_tasks.add_argument(
+        "--reset", action="store_true", help="clear the stats once read"
+    )
+
     args = ap.parse_args()
     port: str = args.port
     sub_name: str = args.subcommand
@@ -205,6 +305,18 @@ def main():
     print(ap.description)
     # print("Press Ctrl-C to quit")
 
+    if "bkprof" == sub_name and args.replay:
+        if not args.file:
+            print("No profile file to replay")
+            return
+        with open(args.file, "rb") as fd:
+            bp.report(fd.read())
+        return
+
+    if not port:
+        print("No serial port given")
+        return
+
     try:
         ser = serial.Serial(port, baudrate=38400, timeout=0.0001, write_timeout=None)
     except Exception as e:
@@ -218,6 +330,12 @@ def main():
             main_dump(args, ser)
         case "restore":
             main_restore(args, ser)
+        case "heard":
+            main_heard(args, ser)
+        case "bkprof":
+            main_bkprof(args, ser)
+        case "tasks":
+            main_tasks(args, ser)
 
     ser.close()
     print("Quit")